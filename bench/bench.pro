@@ -0,0 +1,54 @@
+# -------------------------------------------------
+# Solver benchmark; not part of the main application
+# -------------------------------------------------
+TARGET = solverbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+DEPENDPATH += . \
+    ../src
+INCLUDEPATH += ../src
+
+# No FMA contraction, so that results are bitwise identical whichever
+# instruction set the kernels are run on (see EnsembleStepper)
+*-g++*|*-clang* {
+    QMAKE_CXXFLAGS += -ffp-contract=off
+}
+
+SOURCES += solverbench.cpp \
+    ../src/doublependulum.cpp \
+    ../src/doublependulumarena.cpp \
+    ../src/doublependulumevent.cpp \
+    ../src/fasttrig.cpp \
+    ../src/doublependulumrk4.cpp \
+    ../src/doublependulumadaptive.cpp \
+    ../src/doublependulumdop853.cpp \
+    ../src/doublependulumtaylor.cpp \
+    ../src/doublependulumbulirschstoer.cpp \
+    ../src/doublependulumeuler.cpp \
+    ../src/doublependulumnormalmode.cpp \
+    ../src/doublependulumgausslegendre.cpp \
+    ../src/doublependulumcartesian.cpp \
+    ../src/doublependulumfactory.cpp \
+    ../src/ensemblestepper.cpp \
+    ../src/pararealintegrator.cpp \
+    ../src/doublependulumlyapunov.cpp
+HEADERS += ../src/doublependulum.h \
+    ../src/doublependulumarena.h \
+    ../src/doublependulumevent.h \
+    ../src/fasttrig.h \
+    ../src/doublependulumrk4.h \
+    ../src/doublependulumadaptive.h \
+    ../src/doublependulumdop853.h \
+    ../src/doublependulumtaylor.h \
+    ../src/doublependulumbulirschstoer.h \
+    ../src/doublependulumeuler.h \
+    ../src/doublependulumnormalmode.h \
+    ../src/doublependulumgausslegendre.h \
+    ../src/doublependulumcartesian.h \
+    ../src/doublependulumfactory.h \
+    ../src/ensemblestepper.h \
+    ../src/chainpendulum.h \
+    ../src/pararealintegrator.h \
+    ../src/doublependulumlyapunov.h
@@ -0,0 +1,878 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+/*
+ * Benchmarks for the solvers, run as "solverbench [mode]".  The modes are:
+ *
+ *   solvers   (the default) the cost of each solver at a given accuracy
+ *   ensemble  the throughput of EnsembleStepper over its page modes,
+ *             pinning and thread counts, and a check that deterministic
+ *             mode gives bitwise identical results whatever the threads
+ *   chain     ChainPendulum<N>, whose loops have compile-time trip counts,
+ *             against the same RK4 with run-time loops, for N = 2, 3, 4
+ *   parareal  PararealIntegrator's iterations, error and speedup over a
+ *             serial fine solve, for a range of slice counts
+ *   lyapunov  the Lyapunov spectrum of the reference pendulum, with and
+ *             without energy projection
+ *
+ * The solvers mode compares the cost of the solvers, in evaluations of the
+ * equations of motion and CPU time per simulated second, needed to reach a
+ * given accuracy.  Each solver is run over a range of step sizes (or
+ * tolerances) and its error at the end time is measured against a
+ * tight-tolerance reference; the cost at a set of target accuracies is then
+ * found by log-log interpolation.  CPU time
+ * is the fairer measure for the Taylor series solver, which does not call
+ * derivs() at all, and for RK4 with energy projection, whose projections do
+ * not either.  The projection is also compared with plain RK4 on the energy
+ * drift over the run, giving the CPU time it costs per step against the
+ * steps it saves at a given energy budget.
+ */
+
+#include "doublependulumrk4.h"
+#include "doublependulumdop853.h"
+#include "doublependulumtaylor.h"
+#include "doublependulumbulirschstoer.h"
+#include "ensemblestepper.h"
+#include "chainpendulum.h"
+#include "pararealintegrator.h"
+#include "doublependulumlyapunov.h"
+
+#include <QThread>
+#include <QTime>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+namespace
+{
+    const double endTime = 2.0;
+
+    const Pendulum upper(1.0, 0.0, 1.0, 1.0);
+    const Pendulum lower(0.6, 0.0, 0.65, 0.3);
+
+    typedef DoublePendulum *(*Factory)(double param);
+
+    DoublePendulum *createRK4(double dt)
+    {
+        return new DoublePendulumRK4(upper, lower, dt);
+    }
+
+    DoublePendulum *createRK4Projected(double dt)
+    {
+        DoublePendulum *p = new DoublePendulumRK4(upper, lower, dt);
+        p->setEnergyProjection(true);
+
+        return p;
+    }
+
+    DoublePendulum *createDOP853(double tol)
+    {
+        return new DoublePendulumDOP853(upper, lower, 0.01, 9.81, tol);
+    }
+
+    DoublePendulum *createTaylor(double tol)
+    {
+        return new DoublePendulumTaylor(upper, lower, 0.01, 9.81, tol);
+    }
+
+    DoublePendulum *createBulirschStoer(double tol)
+    {
+        return new DoublePendulumBulirschStoer(upper, lower, 0.01, 9.81, tol);
+    }
+
+    struct Solver
+    {
+        const char *name;
+        Factory create;
+
+        // Parameter sweep: start, multiplicative factor and count
+        double param;
+        double factor;
+        int count;
+    };
+
+    const Solver solvers[] =
+    {
+        { "RK4", createRK4, 0.05, 0.5, 12 },
+        { "RK4+proj", createRK4Projected, 0.05, 0.5, 12 },
+        { "DOP853", createDOP853, 1e-4, 0.1, 11 },
+        { "Taylor", createTaylor, 1e-4, 0.1, 12 },
+        { "Bulirsch-Stoer", createBulirschStoer, 1e-4, 0.1, 11 }
+    };
+
+    const int numSolvers = sizeof(solvers) / sizeof(solvers[0]);
+
+    // Indices of the solvers compared by printProjectionSummary()
+    const int rk4 = 0;
+    const int rk4Projected = 1;
+
+    struct Sample
+    {
+        double error;
+        double drift;
+        double cost;
+        double time;
+    };
+
+    double stateError(DoublePendulum *p, DoublePendulum *ref)
+    {
+        return std::max(std::max(fabs(p->theta1() - ref->theta1()),
+                                 fabs(p->omega1() - ref->omega1())),
+                        std::max(fabs(p->theta2() - ref->theta2()),
+                                 fabs(p->omega2() - ref->omega2())));
+    }
+
+    double energyDrift(DoublePendulum *p)
+    {
+        return fabs((p->energy() - p->initEnergy()) / p->initEnergy());
+    }
+
+    /**
+     * Interpolates the cost needed to reach the target error, returning a
+     * negative value if the target lies outside of the samples.
+     */
+    double costAt(const std::vector<Sample>& samples, double target,
+                  double Sample::*cost, double Sample::*error = &Sample::error)
+    {
+        for (size_t i = 1; i < samples.size(); ++i)
+        {
+            const Sample& s0 = samples[i - 1];
+            const Sample& s1 = samples[i];
+
+            if (s0.*error >= target && s1.*error <= target
+             && s1.*error > 0.0 && s1.*error < s0.*error
+             && s0.*cost > 0.0 && s1.*cost > 0.0)
+            {
+                const double x = log(target / s0.*error)
+                               / log(s1.*error / s0.*error);
+
+                return s0.*cost * pow(s1.*cost / s0.*cost, x);
+            }
+        }
+
+        return -1.0;
+    }
+
+    void printSummary(const char *title,
+                      const std::vector<std::vector<Sample> >& results,
+                      const double *targets, int numTargets,
+                      double Sample::*cost)
+    {
+        printf("%-10s", title);
+        for (int s = 0; s < numSolvers; ++s)
+        {
+            printf("  %16s", solvers[s].name);
+        }
+        printf("\n");
+
+        for (int t = 0; t < numTargets; ++t)
+        {
+            const double base = costAt(results[0], targets[t], cost);
+
+            printf("%-10.0e", targets[t]);
+            for (int s = 0; s < numSolvers; ++s)
+            {
+                const double c = costAt(results[s], targets[t], cost);
+
+                if (c <= 0.0)
+                {
+                    printf("  %16s", "-");
+                }
+                else if (base > 0.0 && s > 0)
+                {
+                    printf("  %8.0f (%5.1fx)", c, base / c);
+                }
+                else
+                {
+                    printf("  %16.0f", c);
+                }
+            }
+            printf("\n");
+        }
+
+        printf("\n");
+    }
+
+    /**
+     * Compares RK4 with and without energy projection: the CPU time the
+     * projection adds at each dt, and the CPU time each needs to keep the
+     * energy drift within a set of budgets.  With projection the drift is
+     * usually within budget at every dt swept, so the cost of the largest
+     * dt is given; the saving is then a lower bound.
+     */
+    void printProjectionSummary(const std::vector<std::vector<Sample> >& results,
+                                const double *budgets, int numBudgets)
+    {
+        const std::vector<Sample>& plain = results[rk4];
+        const std::vector<Sample>& projected = results[rk4Projected];
+
+        printf("%-10s  %12s  %12s  %12s  %12s\n", "dt", "drift",
+               "drift+proj", "CPU us/s", "overhead");
+
+        double dt = solvers[rk4].param;
+        for (size_t i = 0; i < plain.size() && i < projected.size();
+             ++i, dt *= solvers[rk4].factor)
+        {
+            printf("%-10.3g  %12.3g  %12.3g  %12.1f  %11.1f%%\n", dt,
+                   plain[i].drift, projected[i].drift, plain[i].time,
+                   100.0 * (projected[i].time / plain[i].time - 1.0));
+        }
+        printf("\n");
+
+        printf("%-10s  %16s  %16s\n", "drift", solvers[rk4].name,
+               solvers[rk4Projected].name);
+
+        for (int b = 0; b < numBudgets; ++b)
+        {
+            const double base = costAt(plain, budgets[b], &Sample::time,
+                                       &Sample::drift);
+
+            // Largest dt (the first sample) which keeps within the budget
+            double c = -1.0;
+            for (size_t i = 0; i < projected.size(); ++i)
+            {
+                if (projected[i].drift <= budgets[b])
+                {
+                    c = projected[i].time;
+                    break;
+                }
+            }
+
+            printf("%-10.0e", budgets[b]);
+
+            if (base > 0.0)
+            {
+                printf("  %16.1f", base);
+            }
+            else
+            {
+                printf("  %16s", "-");
+            }
+
+            if (c <= 0.0)
+            {
+                printf("  %16s", "-");
+            }
+            else if (base > 0.0)
+            {
+                printf("  %8.1f (%5.1fx)", c, base / c);
+            }
+            else
+            {
+                printf("  %16.1f", c);
+            }
+            printf("\n");
+        }
+
+        printf("\n");
+    }
+
+    int benchSolvers()
+        {
+        DoublePendulumDOP853 ref(upper, lower, 0.01, 9.81, 1e-15);
+        ref.update(endTime);
+
+        const double targets[] = { 1e-6, 1e-9, 1e-12 };
+        const int numTargets = sizeof(targets) / sizeof(targets[0]);
+
+        std::vector<std::vector<Sample> > results(numSolvers);
+
+        for (int s = 0; s < numSolvers; ++s)
+        {
+            printf("%s\n", solvers[s].name);
+            printf("  %12s  %12s  %14s  %14s\n", "param", "error", "derivs/s",
+                   "CPU us/s");
+
+            double param = solvers[s].param;
+            for (int i = 0; i < solvers[s].count;
+                 ++i, param *= solvers[s].factor)
+            {
+                DoublePendulum *p = solvers[s].create(param);
+                p->update(endTime);
+
+                Sample sample;
+                sample.error = stateError(p, &ref);
+                sample.drift = energyDrift(p);
+                sample.cost = p->derivsEvaluations() / endTime;
+
+                delete p;
+
+                // Repeat the run until enough CPU time has passed to measure
+                int reps = 0;
+                const clock_t start = clock();
+                clock_t end;
+                do
+                {
+                    p = solvers[s].create(param);
+                    p->update(endTime);
+                    delete p;
+
+                    ++reps;
+                } while ((end = clock()) - start < CLOCKS_PER_SEC / 20);
+
+                sample.time = 1e6 * (end - start) / CLOCKS_PER_SEC
+                            / (reps * endTime);
+
+                results[s].push_back(sample);
+
+                printf("  %12.3g  %12.3g  %14.1f  %14.1f\n", param,
+                       sample.error, sample.cost, sample.time);
+            }
+
+            printf("\n");
+        }
+
+        // Summaries at equal accuracy, relative to the first solver (RK4)
+        printSummary("derivs/s", results, targets, numTargets, &Sample::cost);
+        printSummary("CPU us/s", results, targets, numTargets, &Sample::time);
+
+        // Energy drift with and without projection
+        const double budgets[] = { 1e-4, 1e-6, 1e-8 };
+        const int numBudgets = sizeof(budgets) / sizeof(budgets[0]);
+
+        printProjectionSummary(results, budgets, numBudgets);
+
+        return 0;
+    }
+
+    /**
+     * Fills the stepper with count pendula fanned out over the upper angle.
+     */
+    void fillEnsemble(EnsembleStepper& stepper, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            stepper.addInitialCondition(Pendulum(1.0, 0.5 + 1e-6 * i, 1.0, 1.0),
+                                        lower);
+        }
+    }
+
+    /**
+     * Times EnsembleStepper with each page mode, pinned and unpinned, over a
+     * range of thread counts, then checks that deterministic mode gives the
+     * same mean energy and checksum, bit for bit, with any number of threads.
+     */
+    int benchEnsemble()
+    {
+        const char *solver = "Runge Kutta (RK4)";
+        const double dt = 0.01;
+        const int count = 50000;
+        const int advances = 5;
+        const double interval = 0.1;
+
+        const DoublePendulumArena::PageMode pages[] =
+        {
+            DoublePendulumArena::HeapPages,
+            DoublePendulumArena::MappedPages,
+            DoublePendulumArena::TransparentHugePages,
+            DoublePendulumArena::ExplicitHugePages
+        };
+        const char *pageNames[] =
+        {
+            "heap", "mapped", "transparent huge", "explicit huge"
+        };
+        const int numPages = sizeof(pages) / sizeof(pages[0]);
+
+        const int threads[] = { 1, 2, 4, 8 };
+        const int numThreads = sizeof(threads) / sizeof(threads[0]);
+
+        printf("%d pendula, %s, dt %g, %d cores\n\n", count, solver, dt,
+               QThread::idealThreadCount());
+        printf("%-18s  %8s  %8s  %10s  %12s\n", "pages", "pinned", "threads",
+               "wall s", "Msteps/s");
+
+        for (int p = 0; p < numPages; ++p)
+        {
+            for (int pin = 1; pin >= 0; --pin)
+            {
+                for (int t = 0; t < numThreads; ++t)
+                {
+                    EnsembleStepper stepper(solver, dt);
+                    stepper.setPageMode(pages[p]);
+                    stepper.setPinThreads(pin);
+                    stepper.setThreadCount(threads[t]);
+
+                    fillEnsemble(stepper, count);
+                    stepper.start();
+
+                    QTime timer;
+                    timer.start();
+
+                    for (int i = 1; i <= advances; ++i)
+                    {
+                        stepper.advance(interval * i);
+                    }
+
+                    const double wall = 1e-3 * qMax(timer.elapsed(), 1);
+                    const double steps = count * advances * interval / dt;
+
+                    printf("%-18s  %8s  %8d  %10.3f  %12.2f\n", pageNames[p],
+                           pin ? "yes" : "no", threads[t], wall,
+                           1e-6 * steps / wall);
+                }
+            }
+        }
+
+        printf("\n");
+
+        // Deterministic mode, over thread counts which split the chunks badly
+        const int checkThreads[] = { 1, 2, 3, 7, 16 };
+        const int numCheckThreads = sizeof(checkThreads)
+                                  / sizeof(checkThreads[0]);
+        const int checkCount = 30001;
+
+        double energy0 = 0.0;
+        quint64 checksum0 = 0;
+        bool identical = true;
+
+        printf("%-8s  %24s  %16s\n", "threads", "mean energy", "checksum");
+
+        for (int t = 0; t < numCheckThreads; ++t)
+        {
+            EnsembleStepper stepper(solver, dt);
+            stepper.setDeterministic(true);
+            stepper.setThreadCount(checkThreads[t]);
+
+            fillEnsemble(stepper, checkCount);
+            stepper.start();
+            stepper.advance(1.0);
+
+            const double energy = stepper.meanEnergy();
+            const quint64 checksum = stepper.checksum();
+
+            if (t == 0)
+            {
+                energy0 = energy;
+                checksum0 = checksum;
+            }
+            else if (memcmp(&energy, &energy0, sizeof(energy)) != 0
+                  || checksum != checksum0)
+            {
+                identical = false;
+            }
+
+            printf("%-8d  %24.17g  %016llx\n", checkThreads[t], energy,
+                   (unsigned long long) checksum);
+        }
+
+        printf("\ndeterministic results %s\n",
+               identical ? "bitwise identical" : "DIFFER");
+
+        return identical ? 0 : 1;
+    }
+
+    /**
+     * ChainPendulum with the number of links chosen at run time, so that
+     * none of its loops can be unrolled; otherwise the arithmetic is the
+     * same, operation for operation, and so are the results.
+     */
+    class GenericChain
+    {
+    public:
+        enum
+        {
+            MAX_LINKS = 8
+        };
+
+        GenericChain(int n, const Pendulum *bobs, double dt)
+            : m_n(n), m_dt(dt), m_g(9.81), m_time(0.0)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                m_y[2*i] = bobs[i].theta;
+                m_y[2*i + 1] = bobs[i].omega;
+                m_l[i] = bobs[i].l;
+            }
+
+            double mu = 0.0;
+            for (int i = n - 1; i >= 0; --i)
+            {
+                mu += bobs[i].m;
+                m_mu[i] = mu;
+            }
+        }
+
+        void update(double newTime)
+        {
+            do
+            {
+                double yout[2*MAX_LINKS];
+
+                solveODEs(m_y, yout);
+
+                for (int i = 0; i < 2*m_n; ++i)
+                {
+                    m_y[i] = yout[i];
+                }
+            } while ((m_time += m_dt) < newTime);
+        }
+
+        double theta(int i) const
+        {
+            return m_y[2*i];
+        }
+
+        double omega(int i) const
+        {
+            return m_y[2*i + 1];
+        }
+
+    private:
+        void derivs(const double *yin, double *dydx) const
+        {
+            const int n = m_n;
+
+            // Zeroed, as the compiler can not see that n > 0
+            double theta[MAX_LINKS] = { 0.0 };
+            double s[MAX_LINKS], c[MAX_LINKS];
+
+            for (int i = 0; i < n; ++i)
+            {
+                theta[i] = yin[2*i];
+            }
+
+            FastTrig::sinCos(theta, s, c, n);
+
+            double M[MAX_LINKS][MAX_LINKS], f[MAX_LINKS];
+
+            for (int i = 0; i < n; ++i)
+            {
+                f[i] = -m_g * m_mu[i] * m_l[i] * s[i];
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                M[i][i] = m_mu[i] * m_l[i] * m_l[i];
+
+                for (int j = i + 1; j < n; ++j)
+                {
+                    const double k = m_mu[j] * m_l[i] * m_l[j];
+                    const double cij = c[i]*c[j] + s[i]*s[j];
+                    const double sij = s[i]*c[j] - c[i]*s[j];
+
+                    M[i][j] = M[j][i] = k * cij;
+
+                    f[i] -= k * sij * yin[2*j + 1] * yin[2*j + 1];
+                    f[j] += k * sij * yin[2*i + 1] * yin[2*i + 1];
+                }
+            }
+
+            for (int j = 0; j < n; ++j)
+            {
+                for (int k = 0; k < j; ++k)
+                {
+                    M[j][j] -= M[j][k] * M[j][k] * M[k][k];
+                }
+
+                for (int i = j + 1; i < n; ++i)
+                {
+                    for (int k = 0; k < j; ++k)
+                    {
+                        M[i][j] -= M[i][k] * M[j][k] * M[k][k];
+                    }
+
+                    M[i][j] /= M[j][j];
+                }
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                for (int k = 0; k < i; ++k)
+                {
+                    f[i] -= M[i][k] * f[k];
+                }
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                f[i] /= M[i][i];
+            }
+
+            for (int i = n - 1; i >= 0; --i)
+            {
+                for (int k = i + 1; k < n; ++k)
+                {
+                    f[i] -= M[k][i] * f[k];
+                }
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                dydx[2*i] = yin[2*i + 1];
+                dydx[2*i + 1] = f[i];
+            }
+        }
+
+        void solveODEs(const double *yin, double *yout) const
+        {
+            const int neqns = 2*m_n;
+
+            double k1[2*MAX_LINKS], k2[2*MAX_LINKS], k3[2*MAX_LINKS];
+            double k4[2*MAX_LINKS], yt[2*MAX_LINKS] = { 0.0 };
+
+            derivs(yin, k1);
+            for (int i = 0; i < neqns; ++i)
+            {
+                yt[i] = yin[i] + 0.5 * m_dt * k1[i];
+            }
+
+            derivs(yt, k2);
+            for (int i = 0; i < neqns; ++i)
+            {
+                yt[i] = yin[i] + 0.5 * m_dt * k2[i];
+            }
+
+            derivs(yt, k3);
+            for (int i = 0; i < neqns; ++i)
+            {
+                yt[i] = yin[i] + m_dt * k3[i];
+            }
+
+            derivs(yt, k4);
+            for (int i = 0; i < neqns; ++i)
+            {
+                yout[i] = yin[i] + m_dt / 6.0
+                        * (k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i]);
+            }
+        }
+
+        const int m_n;
+        const double m_dt;
+        const double m_g;
+
+        double m_y[2*MAX_LINKS];
+        double m_l[MAX_LINKS];
+        double m_mu[MAX_LINKS];
+
+        double m_time;
+    };
+
+    const Pendulum chainBobs[] =
+    {
+        Pendulum(1.0, 1.0, 1.0, 0.0),
+        Pendulum(0.8, 0.5, 0.8, 0.3),
+        Pendulum(0.6, 0.2, 0.7, -0.2),
+        Pendulum(0.4, -0.3, 0.5, 0.1)
+    };
+
+    /**
+     * Times ChainPendulum<N> and GenericChain over the same run, in CPU
+     * time per step, and gives the largest difference between their states.
+     */
+    template <int N>
+    void benchChainLinks()
+    {
+        const double dt = 0.001;
+        const double duration = 10.0;
+        const double steps = duration / dt;
+
+        // Each timed over as many runs as fit in a twentieth of a second
+        int reps = 0;
+        clock_t start = clock();
+        clock_t end;
+        ChainPendulum<N> *chain = 0;
+        do
+        {
+            delete chain;
+            chain = new ChainPendulum<N>(chainBobs, dt);
+            chain->update(duration);
+
+            ++reps;
+        } while ((end = clock()) - start < CLOCKS_PER_SEC / 20);
+
+        const double chainTime = 1e9 * (end - start) / CLOCKS_PER_SEC
+                               / (reps * steps);
+
+        reps = 0;
+        start = clock();
+        GenericChain *generic = 0;
+        do
+        {
+            delete generic;
+            generic = new GenericChain(N, chainBobs, dt);
+            generic->update(duration);
+
+            ++reps;
+        } while ((end = clock()) - start < CLOCKS_PER_SEC / 20);
+
+        const double genericTime = 1e9 * (end - start) / CLOCKS_PER_SEC
+                                 / (reps * steps);
+
+        double diff = 0.0;
+        for (int i = 0; i < N; ++i)
+        {
+            diff = std::max(diff, fabs(chain->theta(i) - generic->theta(i)));
+            diff = std::max(diff, fabs(chain->omega(i) - generic->omega(i)));
+        }
+
+        printf("%-6d  %14.1f  %14.1f  %8.2fx  %12.3g\n", N, chainTime,
+               genericTime, genericTime / chainTime, diff);
+
+        delete chain;
+        delete generic;
+    }
+
+    int benchChain()
+    {
+        printf("%-6s  %14s  %14s  %9s  %12s\n", "links", "unrolled ns",
+               "generic ns", "speedup", "difference");
+
+        benchChainLinks<2>();
+        benchChainLinks<3>();
+        benchChainLinks<4>();
+
+        return 0;
+    }
+
+    /**
+     * Runs PararealIntegrator with RK4 as both the coarse and fine solvers
+     * over a range of slice counts.  Its end state is compared with a serial
+     * run of the fine solver, which it should match to within its tolerance
+     * once converged, and its wall time with that of the serial run.  The
+     * speedup it reports itself, from the times of its own fine solves, is
+     * given alongside.
+     */
+    int benchParareal()
+    {
+        const char *solver = "Runge Kutta (RK4)";
+        const double coarseDt = 0.05;
+        const double fineDt = 0.00002;
+        const double duration = 20.0;
+        const double tol = 1e-10;
+
+        DoublePendulumRK4 serial(upper, lower, fineDt);
+
+        QTime timer;
+        timer.start();
+        serial.update(duration);
+        const int serialTime = timer.elapsed();
+
+        printf("%s, coarse dt %g, fine dt %g, %g s, %d cores\n", solver,
+               coarseDt, fineDt, duration, QThread::idealThreadCount());
+        printf("serial fine solve %d ms\n\n", serialTime);
+
+        printf("%-8s  %10s  %12s  %10s  %10s  %10s\n", "slices",
+               "iterations", "error", "wall ms", "speedup", "reported");
+
+        const int slices[] = { 5, 10, 20, 40 };
+        const int numSlices = sizeof(slices) / sizeof(slices[0]);
+
+        for (int i = 0; i < numSlices; ++i)
+        {
+            PararealIntegrator parareal(solver, coarseDt, solver, fineDt);
+            const PararealResult r = parareal.run(upper, lower, duration,
+                                                  slices[i], tol);
+
+            const double error = std::max(
+                std::max(fabs(r.upper.theta - serial.theta1()),
+                         fabs(r.upper.omega - serial.omega1())),
+                std::max(fabs(r.lower.theta - serial.theta2()),
+                         fabs(r.lower.omega - serial.omega2())));
+
+            printf("%-8d  %10d  %12.3g  %10d  %9.2fx  %9.2fx\n", slices[i],
+                   r.iterations, error, r.wallTime,
+                   double(serialTime) / qMax(r.wallTime, 1), r.speedup);
+        }
+
+        // An unknown solver must be refused rather than crash
+        PararealIntegrator bad("No such solver", coarseDt, solver, fineDt);
+        const PararealResult r = bad.run(upper, lower, duration, 4, tol);
+
+        printf("\nunknown solver: valid %s, iterations %d\n",
+               bad.isValid() ? "yes" : "no", r.iterations);
+
+        return (!bad.isValid() && r.iterations == -1) ? 0 : 1;
+    }
+
+    /**
+     * Prints the Lyapunov spectrum of the reference pendulum as it converges,
+     * with and without energy projection.  The system is Hamiltonian, so the
+     * exponents should come in pairs summing to zero, with the middle two
+     * (along the flow and across the energy surface) vanishing.
+     */
+    int benchLyapunov()
+    {
+        const double dt = 0.005;
+        const double times[] = { 50.0, 100.0, 200.0, 400.0 };
+        const int numTimes = sizeof(times) / sizeof(times[0]);
+
+        printf("Lyapunov spectrum, RK4 dt %g, orthonormalised every 10 "
+               "steps\n", dt);
+
+        for (int projected = 0; projected < 2; ++projected)
+        {
+            DoublePendulumLyapunov p(upper, lower, dt);
+            p.setEnergyProjection(projected);
+
+            printf("\n%s energy projection\n", projected ? "with" : "without");
+            printf("%8s  %10s  %10s  %10s  %10s  %10s  %10s\n", "time",
+                   "lambda1", "lambda2", "lambda3", "lambda4", "sum",
+                   "energy");
+
+            for (int i = 0; i < numTimes; ++i)
+            {
+                p.update(times[i]);
+
+                double lambda[4];
+                p.exponents(lambda);
+
+                printf("%8g  %10.5f  %10.5f  %10.5f  %10.5f  %10.2e  %10.6f\n",
+                       times[i], lambda[0], lambda[1], lambda[2], lambda[3],
+                       lambda[0] + lambda[1] + lambda[2] + lambda[3],
+                       p.energy());
+            }
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mode = (argc > 1) ? argv[1] : "solvers";
+
+    if (strcmp(mode, "solvers") == 0)
+    {
+        return benchSolvers();
+    }
+    else if (strcmp(mode, "ensemble") == 0)
+    {
+        return benchEnsemble();
+    }
+    else if (strcmp(mode, "chain") == 0)
+    {
+        return benchChain();
+    }
+    else if (strcmp(mode, "parareal") == 0)
+    {
+        return benchParareal();
+    }
+    else if (strcmp(mode, "lyapunov") == 0)
+    {
+        return benchLyapunov();
+    }
+
+    fprintf(stderr, "usage: %s [solvers|ensemble|chain|parareal|lyapunov]\n",
+            argv[0]);
+
+    return 1;
+}
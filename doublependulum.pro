@@ -10,25 +10,102 @@ INCLUDEPATH += src
 SOURCES += src/main.cpp \
     src/mainwindow.cpp \
     src/doublependulum.cpp \
+    src/doublependulumarena.cpp \
+    src/doublependulumevent.cpp \
+    src/fasttrig.cpp \
     src/doublependulumeuler.cpp \
     src/doublependulumrk4.cpp \
+    src/doublependulumnormalmode.cpp \
     src/doublependulumwidget.cpp \
     src/colourpicker.cpp \
     src/doublependulumitem.cpp \
-    src/doublependuluminfoitem.cpp
+    src/doublependuluminfoitem.cpp \
+    src/pendulumregistry.cpp \
+    src/pendulumlistmodel.cpp \
+    src/ensemblegenerator.cpp \
+    src/ensemblestepper.cpp \
+    src/timewarpbuffer.cpp \
+    src/multiratestepper.cpp \
+    src/dttuner.cpp \
+    src/ensembledialog.cpp \
+    src/doublependulumlyapunov.cpp \
+    src/lyapunovensemble.cpp \
+    src/doublependulumgausslegendre.cpp \
+    src/doublependulumadaptive.cpp \
+    src/doublependulumdop853.cpp \
+    src/doublependulumtaylor.cpp \
+    src/doublependulumbulirschstoer.cpp \
+    src/doublependulumcartesian.cpp \
+    src/doublependulumfactory.cpp \
+    src/pararealintegrator.cpp \
+    src/poincaresectionengine.cpp \
+    src/poincaresectionwidget.cpp \
+    src/fft.cpp \
+    src/slidingdft.cpp \
+    src/spectralanalyser.cpp \
+    src/spectrogramwidget.cpp \
+    src/minmaxpyramid.cpp \
+    src/stripchartwidget.cpp \
+    src/phasedensity.cpp \
+    src/phasedensitywidget.cpp \
+    src/phasespacetree.cpp \
+    src/recurrenceanalyser.cpp \
+    src/recurrenceplotwidget.cpp
 HEADERS += src/mainwindow.h \
     src/doublependulum.h \
+    src/doublependulumarena.h \
+    src/doublependulumevent.h \
+    src/fasttrig.h \
     src/doublependulumeuler.h \
     src/doublependulumrk4.h \
+    src/doublependulumnormalmode.h \
     src/doublependulumwidget.h \
     src/colourpicker.h \
     src/doublependulumitem.h \
-    src/doublependuluminfoitem.h
+    src/doublependuluminfoitem.h \
+    src/pendulumregistry.h \
+    src/pendulumlistmodel.h \
+    src/ensemblegenerator.h \
+    src/ensemblestepper.h \
+    src/timewarpbuffer.h \
+    src/multiratestepper.h \
+    src/dttuner.h \
+    src/ensembledialog.h \
+    src/chainpendulum.h \
+    src/doublependulumlyapunov.h \
+    src/lyapunovensemble.h \
+    src/doublependulumgausslegendre.h \
+    src/doublependulumadaptive.h \
+    src/doublependulumdop853.h \
+    src/doublependulumtaylor.h \
+    src/doublependulumbulirschstoer.h \
+    src/doublependulumcartesian.h \
+    src/doublependulumfactory.h \
+    src/pararealintegrator.h \
+    src/poincaresectionengine.h \
+    src/poincaresectionwidget.h \
+    src/fft.h \
+    src/slidingdft.h \
+    src/spectralanalyser.h \
+    src/spectrogramwidget.h \
+    src/minmaxpyramid.h \
+    src/stripchartwidget.h \
+    src/phasedensity.h \
+    src/phasedensitywidget.h \
+    src/phasespacetree.h \
+    src/recurrenceanalyser.h \
+    src/recurrenceplotwidget.h
 FORMS += src/mainwindow.ui
 RESOURCES += resources.qrc
 
 DEFINES += DOUBLEPENDULUM_VERSION="0.3"
 
+# No FMA contraction, so that results are bitwise identical whichever
+# instruction set the kernels are run on (see EnsembleStepper)
+*-g++*|*-clang* {
+    QMAKE_CXXFLAGS += -ffp-contract=off
+}
+
 contains(CONFIG, static) {
     DEFINES += DOUBLEPENDULUM_STATIC
     QTPLUGIN += qsvg
@@ -0,0 +1,322 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef CHAINPENDULUM_H
+#define CHAINPENDULUM_H
+
+#include "doublependulum.h"
+
+#include <cmath>
+#include <cassert>
+
+/**
+ * A chain of N point masses connected by massless rods, solved using RK4.
+ *
+ * The number of links is a template parameter so that all of the state lives
+ * in fixed-size arrays and every loop below has a compile-time trip count;
+ * for the small N this is intended for (2–8) the compiler unrolls them
+ * completely ("solverbench chain" times this against run-time loops).  The equations of motion are assembled as M(θ)·α = f(θ, ω)
+ * where M is the symmetric positive-definite mass matrix, which is then
+ * solved with an LDLᵀ factorisation (no square roots required).
+ */
+template <int N>
+class ChainPendulum
+{
+public:
+    /**
+     * Constructs the chain from N bobs, ordered from the pivot downwards.
+     */
+    ChainPendulum(const Pendulum *bobs, double dt=0.005, double g=9.81)
+        : m_dt(dt), m_g(g), m_time(0.0)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            m_y[2*i] = bobs[i].theta;
+            m_y[2*i + 1] = bobs[i].omega;
+            m_l[i] = bobs[i].l;
+            m_m[i] = bobs[i].m;
+        }
+
+        // μi is the mass hanging from (and including) bob i
+        double mu = 0.0;
+        for (int i = N - 1; i >= 0; --i)
+        {
+            mu += m_m[i];
+            m_mu[i] = mu;
+        }
+
+        m_initEnergy = energy();
+    }
+
+    /**
+     * Advances the equation in steps of m_dt until newTime is reached.
+     */
+    void update(double newTime)
+    {
+        assert(newTime >= m_time);
+
+        do
+        {
+            double yout[NUM_EQNS];
+
+            solveODEs(m_y, yout);
+
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                m_y[i] = yout[i];
+            }
+        } while ((m_time += m_dt) < newTime);
+    }
+
+    static int links()
+    {
+        return N;
+    }
+
+    double theta(int i) const
+    {
+        return m_y[2*i];
+    }
+
+    double omega(int i) const
+    {
+        return m_y[2*i + 1];
+    }
+
+    double l(int i) const
+    {
+        return m_l[i];
+    }
+
+    double m(int i) const
+    {
+        return m_m[i];
+    }
+
+    double time() const
+    {
+        return m_time;
+    }
+
+    double initEnergy() const
+    {
+        return m_initEnergy;
+    }
+
+    double energy() const
+    {
+        double s[N], c[N];
+        sinCos(m_y, s, c);
+
+        // Potential energy; each rod lifts everything hanging below it
+        double pe = 0.0;
+        for (int i = 0; i < N; ++i)
+        {
+            pe -= m_mu[i] * m_g * m_l[i] * c[i];
+        }
+
+        // Kinetic energy, ½ ωᵀMω
+        double ke = 0.0;
+        for (int i = 0; i < N; ++i)
+        {
+            const double wi = m_l[i] * m_y[2*i + 1];
+
+            ke += 0.5 * m_mu[i] * wi * wi;
+
+            for (int j = i + 1; j < N; ++j)
+            {
+                const double wj = m_l[j] * m_y[2*j + 1];
+
+                ke += m_mu[j] * wi * wj * (c[i]*c[j] + s[i]*s[j]);
+            }
+        }
+
+        return pe + ke;
+    }
+
+    const char *solverMethod()
+    {
+        return "Runge Kutta (RK4)";
+    }
+
+protected:
+    /**
+     * The state vector is laid out as θ1, ω1, θ2, ω2, …, to match the
+     * ordering used by DoublePendulum.
+     */
+    enum
+    {
+        NUM_EQNS = 2*N
+    };
+
+    /**
+     * Computes sin θi and cos θi for each link.  Every angle difference in
+     * the equations of motion is then built from these with the usual
+     * addition formulae, so only N sin/cos pairs are needed per evaluation
+     * rather than one per pair of links, and these are done in one batch.
+     */
+    static void sinCos(const double *y, double *s, double *c)
+    {
+        double theta[N];
+
+        for (int i = 0; i < N; ++i)
+        {
+            theta[i] = y[2*i];
+        }
+
+        FastTrig::sinCos(theta, s, c, N);
+    }
+
+    void derivs(const double *yin, double *dydx) const
+    {
+        double s[N], c[N];
+        sinCos(yin, s, c);
+
+        // Mass matrix, Mij = μmax(i,j) li lj cos(θi - θj), and the forcing
+        double M[N][N], f[N];
+
+        for (int i = 0; i < N; ++i)
+        {
+            f[i] = -m_g * m_mu[i] * m_l[i] * s[i];
+        }
+
+        for (int i = 0; i < N; ++i)
+        {
+            M[i][i] = m_mu[i] * m_l[i] * m_l[i];
+
+            for (int j = i + 1; j < N; ++j)
+            {
+                const double k = m_mu[j] * m_l[i] * m_l[j];
+                const double cij = c[i]*c[j] + s[i]*s[j];
+                const double sij = s[i]*c[j] - c[i]*s[j];
+
+                M[i][j] = M[j][i] = k * cij;
+
+                // Centripetal coupling; sin(θj - θi) = -sin(θi - θj)
+                f[i] -= k * sij * yin[2*j + 1] * yin[2*j + 1];
+                f[j] += k * sij * yin[2*i + 1] * yin[2*i + 1];
+            }
+        }
+
+        // Factorise M = LDLᵀ in place (L below the diagonal, D on it)
+        for (int j = 0; j < N; ++j)
+        {
+            for (int k = 0; k < j; ++k)
+            {
+                M[j][j] -= M[j][k] * M[j][k] * M[k][k];
+            }
+
+            for (int i = j + 1; i < N; ++i)
+            {
+                for (int k = 0; k < j; ++k)
+                {
+                    M[i][j] -= M[i][k] * M[j][k] * M[k][k];
+                }
+
+                M[i][j] /= M[j][j];
+            }
+        }
+
+        // Forward substitution, diagonal scaling and back substitution
+        for (int i = 0; i < N; ++i)
+        {
+            for (int k = 0; k < i; ++k)
+            {
+                f[i] -= M[i][k] * f[k];
+            }
+        }
+
+        for (int i = 0; i < N; ++i)
+        {
+            f[i] /= M[i][i];
+        }
+
+        for (int i = N - 1; i >= 0; --i)
+        {
+            for (int k = i + 1; k < N; ++k)
+            {
+                f[i] -= M[k][i] * f[k];
+            }
+        }
+
+        // dθ/dt = ω and dω/dt = α
+        for (int i = 0; i < N; ++i)
+        {
+            dydx[2*i] = yin[2*i + 1];
+            dydx[2*i + 1] = f[i];
+        }
+    }
+
+    void solveODEs(const double *yin, double *yout) const
+    {
+        double k1[NUM_EQNS], k2[NUM_EQNS], k3[NUM_EQNS], k4[NUM_EQNS];
+        double yt[NUM_EQNS];
+
+        derivs(yin, k1);
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            yt[i] = yin[i] + 0.5 * m_dt * k1[i];
+        }
+
+        derivs(yt, k2);
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            yt[i] = yin[i] + 0.5 * m_dt * k2[i];
+        }
+
+        derivs(yt, k3);
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            yt[i] = yin[i] + m_dt * k3[i];
+        }
+
+        derivs(yt, k4);
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            yout[i] = yin[i] + m_dt / 6.0 * (k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i]);
+        }
+    }
+
+    /**
+     * Current state, interleaved as θ1, ω1, θ2, ω2, …
+     */
+    double m_y[NUM_EQNS];
+
+    /**
+     * Rod lengths (in m) and bob masses (in kg).
+     */
+    double m_l[N];
+    double m_m[N];
+
+    /**
+     * Cumulative tail masses, μi = Σk≥i mk.
+     */
+    double m_mu[N];
+
+    const double m_dt;
+    const double m_g;
+
+    double m_time;
+    double m_initEnergy;
+};
+
+typedef ChainPendulum<2> DoubleChainPendulum;
+typedef ChainPendulum<3> TripleChainPendulum;
+
+#endif // CHAINPENDULUM_H
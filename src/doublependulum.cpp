@@ -18,78 +18,510 @@
 */
 
 #include "doublependulum.h"
+#include "doublependulumarena.h"
 
 #include <cmath>
 #include <cassert>
 
 DoublePendulum::DoublePendulum(const Pendulum& upper, const Pendulum& lower,
                                double dt, double g) :
-    m_theta1(upper.theta),
-    m_omega1(upper.omega),
+    m_state(&m_ownState),
     m_l1(upper.l), m_m1(upper.m),
-    m_theta2(lower.theta),
-    m_omega2(lower.omega),
     m_l2(lower.l), m_m2(lower.m),
     m_dt(dt), m_g(g), m_time(0.0),
-    m_initEnergy(energy())
+    m_initEnergy(0.0),
+    m_derivsEvaluations(0),
+    m_tPrev(0.0),
+    m_hermiteReady(false),
+    m_numEvents(0),
+    m_eventTime(0.0),
+    m_stopped(false),
+    m_numObservers(0),
+    m_trigAccuracy(FastTrig::Faithful),
+    m_energyProjection(false)
 {
+    m_state->y[THETA_1] = m_yPrev[THETA_1] = upper.theta;
+    m_state->y[OMEGA_1] = m_yPrev[OMEGA_1] = upper.omega;
+    m_state->y[THETA_2] = m_yPrev[THETA_2] = lower.theta;
+    m_state->y[OMEGA_2] = m_yPrev[OMEGA_2] = lower.omega;
+
+    // Needs m_trigAccuracy, so can not go in the initialiser list
+    m_initEnergy = energy();
 }
 
 DoublePendulum::~DoublePendulum()
 {
 }
 
+void *DoublePendulum::operator new(size_t size, DoublePendulumArena *arena)
+{
+    return arena ? arena->allocate(size) : ::operator new(size);
+}
+
+void DoublePendulum::operator delete(void *p, DoublePendulumArena *arena)
+{
+    // Only called if a constructor throws; arena memory is simply abandoned
+    if (!arena)
+    {
+        ::operator delete(p);
+    }
+}
+
+void *DoublePendulum::operator new(size_t size)
+{
+    return ::operator new(size);
+}
+
+void DoublePendulum::operator delete(void *p)
+{
+    ::operator delete(p);
+}
+
 double DoublePendulum::energy() const
 {
-    double pe = -(m_m1 + m_m2) * m_g * m_l1 * cos(m_theta1)
-                - m_m2 * m_g * m_l2 * cos(m_theta2);
+    return energy(m_state->y);
+}
+
+double DoublePendulum::energy(const double *y) const
+{
+    const double angles[3] = { y[THETA_1], y[THETA_2],
+                               y[THETA_1] - y[THETA_2] };
+    double s[3], c[3];
+
+    FastTrig::sinCos(angles, s, c, 3, m_trigAccuracy);
+
+    double pe = -(m_m1 + m_m2) * m_g * m_l1 * c[0]
+                - m_m2 * m_g * m_l2 * c[1];
 
-    double ke = 0.5 * m_m1 * m_l1*m_l1 * m_omega1*m_omega1
+    double ke = 0.5 * m_m1 * m_l1*m_l1 * y[OMEGA_1]*y[OMEGA_1]
               + 0.5 * m_m2
-              * (m_l1*m_l1 * m_omega1*m_omega1
-               + m_l2*m_l2 * m_omega2*m_omega2
-               + 2 * m_l1 * m_l2 * m_omega1 * m_omega2 * cos(m_theta1 - m_theta2));
+              * (m_l1*m_l1 * y[OMEGA_1]*y[OMEGA_1]
+               + m_l2*m_l2 * y[OMEGA_2]*y[OMEGA_2]
+               + 2 * m_l1 * m_l2 * y[OMEGA_1] * y[OMEGA_2] * c[2]);
 
     return pe + ke;
 }
 
+double DoublePendulum::energyGradient(const double *y, double *grad) const
+{
+    const double angles[3] = { y[THETA_1], y[THETA_2],
+                               y[THETA_1] - y[THETA_2] };
+    double s[3], c[3];
+
+    FastTrig::sinCos(angles, s, c, 3, m_trigAccuracy);
+
+    const double w1 = y[OMEGA_1], w2 = y[OMEGA_2];
+    const double m12 = m_m1 + m_m2;
+    const double l12 = m_m2 * m_l1 * m_l2;
+
+    grad[THETA_1] = m12 * m_g * m_l1 * s[0] - l12 * w1 * w2 * s[2];
+    grad[OMEGA_1] = m12 * m_l1*m_l1 * w1 + l12 * w2 * c[2];
+    grad[THETA_2] = m_m2 * m_g * m_l2 * s[1] + l12 * w1 * w2 * s[2];
+    grad[OMEGA_2] = m_m2 * m_l2*m_l2 * w2 + l12 * w1 * c[2];
+
+    // Energy, as in energy(), sharing the sines and cosines with ∇E
+    return -m12 * m_g * m_l1 * c[0] - m_m2 * m_g * m_l2 * c[1]
+         + 0.5 * m12 * m_l1*m_l1 * w1*w1
+         + 0.5 * m_m2 * m_l2*m_l2 * w2*w2
+         + l12 * w1 * w2 * c[2];
+}
+
+void DoublePendulum::projectEnergy(double *y) const
+{
+    double grad[NUM_EQNS];
+    const double e = energyGradient(y, grad);
+
+    const double norm2 = grad[THETA_1]*grad[THETA_1]
+                       + grad[OMEGA_1]*grad[OMEGA_1]
+                       + grad[THETA_2]*grad[THETA_2]
+                       + grad[OMEGA_2]*grad[OMEGA_2];
+
+    // ∇E vanishes only at the equilibria, where there is nothing to correct
+    if (norm2 > 0.0)
+    {
+        const double lambda = (e - m_initEnergy) / norm2;
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            y[i] -= lambda * grad[i];
+        }
+    }
+}
+
 void DoublePendulum::update(double newTime)
 {
     assert(newTime >= m_time);
 
+    if (m_stopped)
+    {
+        return;
+    }
+
     do
     {
-        const double yin[NUM_EQNS] = { m_theta1, m_omega1, m_theta2, m_omega2 };
+        const double yin[NUM_EQNS] = { m_state->y[THETA_1], m_state->y[OMEGA_1],
+                                       m_state->y[THETA_2], m_state->y[OMEGA_2] };
         double yout[NUM_EQNS];
 
         solveODEs(yin, yout);
 
-        m_theta1 = yout[THETA_1];
-        m_omega1 = yout[OMEGA_1];
-        m_theta2 = yout[THETA_2];
-        m_omega2 = yout[OMEGA_2];
-    } while ((m_time += m_dt) < newTime);
+        if (m_energyProjection)
+        {
+            projectEnergy(yout);
+        }
+
+        m_state->y[THETA_1] = yout[THETA_1];
+        m_state->y[OMEGA_1] = yout[OMEGA_1];
+        m_state->y[THETA_2] = yout[THETA_2];
+        m_state->y[OMEGA_2] = yout[OMEGA_2];
+
+        m_time += m_dt;
+
+        stepTaken(m_time - m_dt, yin, m_time, yout);
+        checkEvents(m_time, yout);
+
+        if (m_stopped)
+        {
+            return;
+        }
+
+    // Stop at the step nearest to newTime; round-off accumulated in m_time
+    // would otherwise occasionally cause an extra step to be taken
+    } while (m_time < newTime - 0.5 * m_dt);
+}
+
+void DoublePendulum::setSectionListener(PoincareListener *listener)
+{
+    m_sectionEvent.setListener(listener);
+
+    removeEvent(&m_sectionEvent);
+
+    if (listener)
+    {
+        addEvent(&m_sectionEvent);
+    }
+}
+
+bool DoublePendulum::addObserver(DoublePendulumObserver *observer,
+                                 double interval)
+{
+    assert(interval > 0.0);
+
+    if (m_numObservers == MAX_OBSERVERS)
+    {
+        return false;
+    }
+
+    m_observers[m_numObservers] = observer;
+    m_sampleIntervals[m_numObservers] = interval;
+    m_nextSamples[m_numObservers] = m_time + interval;
+    ++m_numObservers;
+
+    return true;
+}
+
+void DoublePendulum::removeObserver(DoublePendulumObserver *observer)
+{
+    for (int i = 0; i < m_numObservers; ++i)
+    {
+        if (m_observers[i] == observer)
+        {
+            --m_numObservers;
+
+            for (int j = i; j < m_numObservers; ++j)
+            {
+                m_observers[j] = m_observers[j + 1];
+                m_sampleIntervals[j] = m_sampleIntervals[j + 1];
+                m_nextSamples[j] = m_nextSamples[j + 1];
+            }
+
+            return;
+        }
+    }
+}
+
+bool DoublePendulum::addEvent(DoublePendulumEvent *event)
+{
+    if (m_numEvents == MAX_EVENTS)
+    {
+        return false;
+    }
+
+    const double *y = m_state->y;
+
+    m_events[m_numEvents] = event;
+    m_eventValues[m_numEvents] = event->value(*this, m_time, y);
+    ++m_numEvents;
+
+    return true;
+}
+
+void DoublePendulum::removeEvent(DoublePendulumEvent *event)
+{
+    for (int i = 0; i < m_numEvents; ++i)
+    {
+        if (m_events[i] == event)
+        {
+            --m_numEvents;
+
+            for (int j = i; j < m_numEvents; ++j)
+            {
+                m_events[j] = m_events[j + 1];
+                m_eventValues[j] = m_eventValues[j + 1];
+            }
+
+            return;
+        }
+    }
+}
+
+void DoublePendulum::denseOutput(double t, double *yout)
+{
+    const double *y = m_state->y;
+    const double h = m_time - m_tPrev;
+
+    if (!m_hermiteReady)
+    {
+        derivs(m_yPrev, m_fPrev);
+        derivs(y, m_fCur);
+
+        m_hermiteReady = true;
+    }
+
+    // Cubic Hermite basis functions
+    const double s = (t - m_tPrev) / h;
+    const double h00 = (1.0 + 2.0*s) * (1.0 - s) * (1.0 - s);
+    const double h10 = s * (1.0 - s) * (1.0 - s);
+    const double h01 = s * s * (3.0 - 2.0*s);
+    const double h11 = s * s * (s - 1.0);
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yout[i] = h00 * m_yPrev[i] + h10 * h * m_fPrev[i]
+                + h01 * y[i] + h11 * h * m_fCur[i];
+    }
+}
+
+void DoublePendulum::stepTaken(double tPrev, const double *yPrev,
+                               double, const double *)
+{
+    // The end of the step is the current state, so only its start is kept
+    m_tPrev = tPrev;
+    m_hermiteReady = false;
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        m_yPrev[i] = yPrev[i];
+    }
+}
+
+void DoublePendulum::checkEvents(double t, const double *y)
+{
+    const double tPrev = m_eventTime;
+
+    m_eventTime = t;
+
+    // Locate every event which occurred during the step
+    int order[MAX_EVENTS];
+    double times[MAX_EVENTS];
+    double states[MAX_EVENTS][NUM_EQNS];
+    int n = 0;
+
+    for (int i = 0; i < m_numEvents; ++i)
+    {
+        DoublePendulumEvent *event = m_events[i];
+
+        const double ga = m_eventValues[i];
+        const double gb = event->value(*this, t, y);
+
+        m_eventValues[i] = gb;
+
+        if (!event->crosses(ga, gb))
+        {
+            continue;
+        }
+
+        const double tc = locateEvent(event, tPrev, ga, t, gb, states[i]);
+
+        if (!event->accept(*this, tc, states[i]))
+        {
+            continue;
+        }
+
+        // Insert into the list of occurrences, keeping it sorted by time
+        int j = n++;
+
+        for (; j > 0 && times[j - 1] > tc; --j)
+        {
+            order[j] = order[j - 1];
+            times[j] = times[j - 1];
+        }
+
+        order[j] = i;
+        times[j] = tc;
+    }
+
+    // Sample the observers up to the first event which stops us; this must
+    // come first as stopping changes the state the dense output ends at
+    if (m_numObservers)
+    {
+        double tEnd = t;
+
+        for (int k = 0; k < n; ++k)
+        {
+            if (m_events[order[k]]->actions() & DoublePendulumEvent::Stop)
+            {
+                tEnd = times[k];
+                break;
+            }
+        }
+
+        sampleObservers(tPrev, tEnd, (tEnd == t) ? y : 0);
+    }
+
+    // Then fire them in the order in which they occurred
+    for (int k = 0; k < n; ++k)
+    {
+        DoublePendulumEvent *event = m_events[order[k]];
+        const double *yc = states[order[k]];
+
+        event->fire(*this, times[k], yc);
+
+        if (event->actions() & DoublePendulumEvent::Stop)
+        {
+            m_stopped = true;
+
+            m_state->y[THETA_1] = yc[THETA_1];
+            m_state->y[OMEGA_1] = yc[OMEGA_1];
+            m_state->y[THETA_2] = yc[THETA_2];
+            m_state->y[OMEGA_2] = yc[OMEGA_2];
+
+            m_time = m_eventTime = times[k];
+
+            // Restart the events from here, taking the one which stopped us
+            // to be exactly zero so that it does not fire again on resuming
+            for (int i = 0; i < m_numEvents; ++i)
+            {
+                m_eventValues[i] = (i == order[k])
+                                 ? 0.0 : m_events[i]->value(*this, m_time, yc);
+            }
+
+            break;
+        }
+    }
+}
+
+void DoublePendulum::sampleObservers(double tPrev, double t, const double *y)
+{
+    for (int i = 0; i < m_numObservers; ++i)
+    {
+        // Samples are due at m_nextSamples[i] and every interval after
+        for (; m_nextSamples[i] <= t; m_nextSamples[i] += m_sampleIntervals[i])
+        {
+            const double ts = m_nextSamples[i];
+
+            if (ts <= tPrev)
+            {
+                continue;
+            }
+            else if (y && ts == t)
+            {
+                m_observers[i]->sample(*this, t, y);
+            }
+            else
+            {
+                double ys[NUM_EQNS];
+
+                denseOutput(ts, ys);
+                m_observers[i]->sample(*this, ts, ys);
+            }
+        }
+    }
+}
+
+double DoublePendulum::locateEvent(DoublePendulumEvent *event,
+                                   double tPrev, double ga,
+                                   double t, double gb, double *yc)
+{
+    // Use the Illinois variant of regula falsi
+    double a = tPrev, b = t, tc = t;
+    int side = 0;
+
+    if (gb == 0.0)
+    {
+        denseOutput(t, yc);
+        return t;
+    }
+
+    for (int i = 0; i < 60; ++i)
+    {
+        tc = (a*gb - b*ga) / (gb - ga);
+        denseOutput(tc, yc);
+
+        const double gc = event->value(*this, tc, yc);
+
+        if (gc == 0.0 || fabs(b - a) <= 1e-13 * (1.0 + fabs(tc)))
+        {
+            break;
+        }
+        else if (gc * gb > 0.0)
+        {
+            b = tc;
+            gb = gc;
+
+            if (side == -1)
+            {
+                ga *= 0.5;
+            }
+
+            side = -1;
+        }
+        else
+        {
+            a = tc;
+            ga = gc;
+
+            if (side == 1)
+            {
+                gb *= 0.5;
+            }
+
+            side = 1;
+        }
+    }
+
+    return tc;
 }
 
 void DoublePendulum::derivs(const double *yin, double *dydx)
 {
-    // Delta is θ2 - θ1
-    const double delta = yin[THETA_2] - yin[THETA_1];
+    ++m_derivsEvaluations;
+
+    // Delta is θ2 - θ1; its sine and cosine are computed in one batch
+    // along with those of θ1 and θ2
+    const double angles[3] = { yin[THETA_2] - yin[THETA_1],
+                               yin[THETA_1], yin[THETA_2] };
+    double s[3], c[3];
+
+    FastTrig::sinCos(angles, s, c, 3, m_trigAccuracy);
+
+    const double sinDelta = s[0], cosDelta = c[0];
+    const double sinTheta1 = s[1], sinTheta2 = s[2];
 
     // `Big-M' is the total mass of the system, m1 + m2;
     const double M = m_m1 + m_m2;
 
     // Denominator expression for ω1
-    double den = M*m_l1 - m_m2*m_l1*cos(delta)*cos(delta);
+    double den = M*m_l1 - m_m2*m_l1*cosDelta*cosDelta;
 
     // dθ/dt = ω, by definition
     dydx[THETA_1] = yin[OMEGA_1];
 
     // Compute ω1
-    dydx[OMEGA_1] = (m_m2*m_l1*yin[OMEGA_1]*yin[OMEGA_1]*sin(delta)*cos(delta)
-                  + m_m2*m_g*sin(yin[THETA_2])*cos(delta)
-                  + m_m2*m_l2*yin[OMEGA_2]*yin[OMEGA_2]*sin(delta)
-                  - M*m_g*sin(yin[THETA_1])) / den;
+    dydx[OMEGA_1] = (m_m2*m_l1*yin[OMEGA_1]*yin[OMEGA_1]*sinDelta*cosDelta
+                  + m_m2*m_g*sinTheta2*cosDelta
+                  + m_m2*m_l2*yin[OMEGA_2]*yin[OMEGA_2]*sinDelta
+                  - M*m_g*sinTheta1) / den;
 
     // Again, dθ/dt = ω for θ2 as well
     dydx[THETA_2] = yin[OMEGA_2];
@@ -98,8 +530,57 @@ void DoublePendulum::derivs(const double *yin, double *dydx)
     den *= m_l2 / m_l1;
 
     // Compute ω2
-    dydx[OMEGA_2] = (-m_m2*m_l2*yin[OMEGA_2]*yin[OMEGA_2]*sin(delta)*cos(delta)
-                  + M*m_g*sin(yin[THETA_1])*cos(delta)
-                  - M*m_l1*yin[OMEGA_1]*yin[OMEGA_1]*sin(delta)
-                  - M*m_g*sin(yin[THETA_2])) / den;
+    dydx[OMEGA_2] = (-m_m2*m_l2*yin[OMEGA_2]*yin[OMEGA_2]*sinDelta*cosDelta
+                  + M*m_g*sinTheta1*cosDelta
+                  - M*m_l1*yin[OMEGA_1]*yin[OMEGA_1]*sinDelta
+                  - M*m_g*sinTheta2) / den;
+}
+
+void DoublePendulum::jacobian(const double *yin, double jac[][NUM_EQNS])
+{
+    const double delta = yin[THETA_2] - yin[THETA_1];
+    const double s = sin(delta), c = cos(delta);
+    const double st1 = sin(yin[THETA_1]), ct1 = cos(yin[THETA_1]);
+    const double st2 = sin(yin[THETA_2]), ct2 = cos(yin[THETA_2]);
+    const double w1 = yin[OMEGA_1], w2 = yin[OMEGA_2];
+    const double M = m_m1 + m_m2;
+
+    // Numerators and denominators exactly as in derivs()
+    const double den1 = M*m_l1 - m_m2*m_l1*c*c;
+    const double den2 = den1 * m_l2 / m_l1;
+
+    const double a1 = (m_m2*m_l1*w1*w1*s*c + m_m2*m_g*st2*c
+                     + m_m2*m_l2*w2*w2*s - M*m_g*st1) / den1;
+    const double a2 = (-m_m2*m_l2*w2*w2*s*c + M*m_g*st1*c
+                     - M*m_l1*w1*w1*s - M*m_g*st2) / den2;
+
+    // Derivatives of the accelerations with respect to delta (quotient rule)
+    const double da1 = (m_m2*m_l1*w1*w1*(c*c - s*s) - m_m2*m_g*st2*s
+                      + m_m2*m_l2*w2*w2*c - a1*2.0*m_m2*m_l1*c*s) / den1;
+    const double da2 = (-m_m2*m_l2*w2*w2*(c*c - s*s) - M*m_g*st1*s
+                      - M*m_l1*w1*w1*c - a2*2.0*m_m2*m_l2*c*s) / den2;
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        for (int j = 0; j < NUM_EQNS; ++j)
+        {
+            jac[i][j] = 0.0;
+        }
+    }
+
+    // dθ/dt = ω
+    jac[THETA_1][OMEGA_1] = 1.0;
+    jac[THETA_2][OMEGA_2] = 1.0;
+
+    // dω1/dt; note that ∂delta/∂θ1 = -1 and ∂delta/∂θ2 = +1
+    jac[OMEGA_1][THETA_1] = -da1 - M*m_g*ct1 / den1;
+    jac[OMEGA_1][OMEGA_1] = 2.0*m_m2*m_l1*w1*s*c / den1;
+    jac[OMEGA_1][THETA_2] = da1 + m_m2*m_g*ct2*c / den1;
+    jac[OMEGA_1][OMEGA_2] = 2.0*m_m2*m_l2*w2*s / den1;
+
+    // dω2/dt
+    jac[OMEGA_2][THETA_1] = -da2 + M*m_g*ct1*c / den2;
+    jac[OMEGA_2][OMEGA_1] = -2.0*M*m_l1*w1*s / den2;
+    jac[OMEGA_2][THETA_2] = da2 - M*m_g*ct2 / den2;
+    jac[OMEGA_2][OMEGA_2] = -2.0*m_m2*m_l2*w2*s*c / den2;
 }
@@ -20,6 +20,11 @@
 #ifndef DOUBLEPENDULUM_H
 #define DOUBLEPENDULUM_H
 
+#include <cstddef>
+
+#include "doublependulumevent.h"
+#include "fasttrig.h"
+
 struct Pendulum
 {
     Pendulum()
@@ -38,27 +43,148 @@ struct Pendulum
     double m;
 };
 
+/**
+ * The hot part of a pendulum's state, θ1, ω1, θ2, ω2, in the order used for
+ * the state vectors of the solvers.  At 32 bytes two fit in a cache line;
+ * see DoublePendulumArena for how an ensemble packs these together away
+ * from the rest of the pendulum.
+ */
+struct DoublePendulumState
+{
+    double y[4];
+};
+
+class DoublePendulumArena;
+
 class DoublePendulum
 {
 public:
+    enum
+    {
+        /**
+         * Maximum number of events which may be registered at once; events
+         * are kept in a fixed-size table so that checking them never
+         * allocates.
+         */
+        MAX_EVENTS = 8,
+
+        /**
+         * Likewise for observers.
+         */
+        MAX_OBSERVERS = 8
+    };
+
     DoublePendulum(const Pendulum& upper, const Pendulum& lower,
                    double dt=0.005, double g=9.81);
 
     virtual ~DoublePendulum();
 
     /**
-     * Advances the equation in steps of m_dt until newTime is reached.
+     * Pendula may be constructed in an arena, with new (arena) T(...); the
+     * arena then owns them and they must not be deleted.  When arena is 0
+     * this is the same as an ordinary new.
+     */
+    static void *operator new(size_t size, DoublePendulumArena *arena);
+    static void operator delete(void *p, DoublePendulumArena *arena);
+
+    // Declaring the above hides the usual forms, so bring them back
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
+    /**
+     * Advances the equation in steps of m_dt until newTime is reached (to
+     * within half a step), or until an event with the Stop action occurs.
      */
-    void update(double newTime);
+    virtual void update(double newTime);
+
+    /**
+     * Evaluates the state θ1, ω1, θ2, ω2 at time t, which must lie within
+     * the most recently taken step.  The default implementation uses cubic
+     * Hermite interpolation between the two ends of the step.
+     */
+    virtual void denseOutput(double t, double *yout);
+
+    /**
+     * Sets the listener to be notified of Poincaré section crossings, which
+     * are located inside the solver loop using the dense output.  Pass 0 to
+     * disable section detection.
+     */
+    void setSectionListener(PoincareListener *listener);
+
+    /**
+     * Registers an observer to be passed the state every interval seconds
+     * of simulated time, independent of the step size used by the solver.
+     * As with events the observer is not owned by the pendulum.  Returns
+     * false if MAX_OBSERVERS are already registered.
+     */
+    bool addObserver(DoublePendulumObserver *observer, double interval);
+
+    void removeObserver(DoublePendulumObserver *observer);
+
+    /**
+     * Registers an event to be checked after every step.  The event is not
+     * owned by the pendulum and must outlive it (or be removed first).
+     * Returns false if MAX_EVENTS are already registered.
+     */
+    bool addEvent(DoublePendulumEvent *event);
+
+    void removeEvent(DoublePendulumEvent *event);
+
+    /**
+     * Returns true if update() has been halted by an event with the Stop
+     * action, in which case the state and time are those of the event, or
+     * by an adaptive solver unable to take a step.
+     * Further calls to update() do nothing until resume() is called.
+     */
+    bool stopped() const
+    {
+        return m_stopped;
+    }
+
+    /**
+     * Sets the accuracy of the sines and cosines used when evaluating the
+     * equations of motion and the energy; the default is faithful rounding.
+     */
+    void setTrigAccuracy(FastTrig::Accuracy accuracy)
+    {
+        m_trigAccuracy = accuracy;
+    }
+
+    FastTrig::Accuracy trigAccuracy() const
+    {
+        return m_trigAccuracy;
+    }
+
+    /**
+     * Sets whether each fixed step is followed by a projection of the state
+     * back on to the surface of constant (initial) energy.  This keeps the
+     * energy of explicit solvers such as RK4 from drifting, allowing a
+     * larger dt for a given energy budget; the adaptive solvers, whose dense
+     * output is tied to the unprojected end of each step, are unaffected.
+     */
+    void setEnergyProjection(bool project)
+    {
+        m_energyProjection = project;
+    }
+
+    bool energyProjection() const
+    {
+        return m_energyProjection;
+    }
+
+    void resume()
+    {
+        m_stopped = false;
+    }
 
     double theta1()
     {
-        return m_theta1;
+        return m_state->y[THETA_1];
     }
 
     double omega1()
     {
-        return m_omega1;
+        return m_state->y[OMEGA_1];
     }
 
     double m1()
@@ -73,12 +199,12 @@ public:
 
     double theta2()
     {
-        return m_theta2;
+        return m_state->y[THETA_2];
     }
 
     double omega2()
     {
-        return m_omega2;
+        return m_state->y[OMEGA_2];
     }
 
     double m2()
@@ -103,6 +229,20 @@ public:
 
     double energy() const;
 
+    /**
+     * Computes the mechanical energy of the state θ1, ω1, θ2, ω2.
+     */
+    double energy(const double *y) const;
+
+    /**
+     * Returns the number of times the equations of motion have been
+     * evaluated; useful for comparing the cost of different solvers.
+     */
+    long derivsEvaluations() const
+    {
+        return m_derivsEvaluations;
+    }
+
     /**
      * Returns a string representation of the solver method used.
      */
@@ -128,6 +268,12 @@ protected:
      */
     void derivs(const double *yin, double *dydx);
 
+    /**
+     * Computes the Jacobian, ∂(dydx)i/∂yj, of the equations of motion as
+     * evaluated by derivs() at the state yin.
+     */
+    void jacobian(const double *yin, double jac[][NUM_EQNS]);
+
     /**
      * Called to solve the equations of motion for the system by advancing
      * theta and omega by one step (this->m_dt).
@@ -138,34 +284,73 @@ protected:
     virtual void solveODEs(const double *yin, double *yout) = 0;
 
     /**
-     * Angle of the first pendulum from the vertical (in rad).
+     * Called by update() after each step from (tPrev, yPrev) to (t, y) has
+     * been taken and the dense output for it is available.
      */
-    double m_theta1;
+    void stepTaken(double tPrev, const double *yPrev,
+                   double t, const double *y);
 
     /**
-     * Angular acceleration of the first pendulum (dθ/dt).
+     * Checks the events over the part of the last step from m_eventTime to
+     * (t, y).  Any which occurred are located and fired in time order; if
+     * one of them stops the integration the state and time are moved back
+     * to it and m_stopped is set.
      */
-    double m_omega1;
+    void checkEvents(double t, const double *y);
 
     /**
-     * Length of the first pendulum (in m).
+     * Returns true if the solver must call stepTaken() and checkEvents()
+     * after every step, rather than only obtaining the state at the end of
+     * update(); solvers which otherwise avoid computing the angles at each
+     * step use this to skip doing so.
      */
-    const double m_l1;
+    bool needsStepOutput() const
+    {
+        return m_numEvents > 0 || m_numObservers > 0;
+    }
 
     /**
-     * Mass of the first pendulum (in kg).
+     * Passes the observers the state at each of their sample times in
+     * (tPrev, t], where y, if given, is the state at t.
      */
-    const double m_m1;
+    void sampleObservers(double tPrev, double t, const double *y);
 
     /**
-     * Angle of the second pendulum from the vertical (in rad).
+     * Moves y along the gradient of the energy so that its energy is once
+     * again m_initEnergy; one Newton step, as the step errors are small.
      */
-    double m_theta2;
+    void projectEnergy(double *y) const;
 
     /**
-     * Angular acceleration of the second pendulum (dθ/dt).
+     * Returns the energy at y, writing its gradient with respect to the
+     * state into grad.
      */
-    double m_omega2;
+    double energyGradient(const double *y, double *grad) const;
+
+    /**
+     * Finds the time at which event passes through zero between tPrev and t,
+     * where it takes the values ga and gb, using the dense output of the
+     * last step.  The state at the crossing is returned in yc.
+     */
+    double locateEvent(DoublePendulumEvent *event, double tPrev, double ga,
+                       double t, double gb, double *yc);
+
+    /**
+     * Current θ1, ω1, θ2, ω2; this points at m_ownState unless the pendulum
+     * has been placed in an arena, in which case it points into the arena's
+     * array of states.
+     */
+    DoublePendulumState *m_state;
+
+    /**
+     * Length of the first pendulum (in m).
+     */
+    const double m_l1;
+
+    /**
+     * Mass of the first pendulum (in kg).
+     */
+    const double m_m1;
 
     /**
      * Length of the second pendulum (in m).
@@ -196,6 +381,66 @@ protected:
      * Initial mechanical energy
      */
     double m_initEnergy;
+
+    /**
+     * Number of calls to derivs() made so far.
+     */
+    long m_derivsEvaluations;
+
+    /**
+     * Time and state at the start of the most recent step.
+     */
+    double m_tPrev;
+    double m_yPrev[NUM_EQNS];
+
+    /**
+     * Derivatives at either end of the most recent step, used for Hermite
+     * interpolation and computed only on demand.
+     */
+    double m_fPrev[NUM_EQNS];
+    double m_fCur[NUM_EQNS];
+    bool m_hermiteReady;
+
+    /**
+     * Registered events along with the value of each at the end of the
+     * most recent step.
+     */
+    DoublePendulumEvent *m_events[MAX_EVENTS];
+    double m_eventValues[MAX_EVENTS];
+    int m_numEvents;
+
+    /**
+     * Time up to which events have been checked, and at which the event
+     * values were last evaluated.
+     */
+    double m_eventTime;
+
+    bool m_stopped;
+
+    /**
+     * Registered observers along with their sampling intervals and the
+     * times at which they are next due.
+     */
+    DoublePendulumObserver *m_observers[MAX_OBSERVERS];
+    double m_sampleIntervals[MAX_OBSERVERS];
+    double m_nextSamples[MAX_OBSERVERS];
+    int m_numObservers;
+
+    FastTrig::Accuracy m_trigAccuracy;
+
+    bool m_energyProjection;
+
+    PoincareSectionEvent m_sectionEvent;
+
+    DoublePendulumState m_ownState;
+
+private:
+    friend class DoublePendulumArena;
+    friend class MultiRateStepper;
+
+    // m_state may point into ourself, so we can not be copied
+    DoublePendulum(const DoublePendulum&);
+    DoublePendulum& operator=(const DoublePendulum&);
 };
 
 #endif // DOUBLEPENDULUM_H
@@ -0,0 +1,117 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumadaptive.h"
+
+#include <cassert>
+
+DoublePendulumAdaptive::DoublePendulumAdaptive(const Pendulum& upper,
+                                               const Pendulum& lower,
+                                               double dt, double g,
+                                               double tol) :
+    DoublePendulum(upper, lower, dt, g),
+    m_tol(tol),
+    m_h(dt),
+    m_tStep(0.0),
+    m_acceptedSteps(0),
+    m_rejectedSteps(0)
+{
+    m_y[THETA_1] = m_state->y[THETA_1];
+    m_y[OMEGA_1] = m_state->y[OMEGA_1];
+    m_y[THETA_2] = m_state->y[THETA_2];
+    m_y[OMEGA_2] = m_state->y[OMEGA_2];
+}
+
+void DoublePendulumAdaptive::update(double newTime)
+{
+    assert(newTime >= m_time);
+
+    if (m_stopped)
+    {
+        return;
+    }
+
+    double y[NUM_EQNS];
+
+    for (;;)
+    {
+        // Check for events over the part of the last step up to newTime,
+        // leaving any beyond it to be found by the next call
+        if (m_eventTime < m_tStep && m_eventTime < newTime)
+        {
+            if (newTime < m_tStep)
+            {
+                denseOutput(newTime, y);
+                checkEvents(newTime, y);
+            }
+            else
+            {
+                checkEvents(m_tStep, m_y);
+            }
+
+            if (m_stopped)
+            {
+                return;
+            }
+        }
+
+        // Step until we have passed newTime
+        if (m_tStep >= newTime)
+        {
+            break;
+        }
+
+        step();
+
+        // The solver has given up, so stop where its last step ended
+        if (m_stopped)
+        {
+            m_state->y[THETA_1] = m_y[THETA_1];
+            m_state->y[OMEGA_1] = m_y[OMEGA_1];
+            m_state->y[THETA_2] = m_y[THETA_2];
+            m_state->y[OMEGA_2] = m_y[OMEGA_2];
+
+            m_time = m_tStep;
+
+            return;
+        }
+
+        stepTaken(m_tPrev, m_yPrev, m_tStep, m_y);
+    }
+
+    // Then interpolate back to it
+    if (newTime == m_tStep)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            y[i] = m_y[i];
+        }
+    }
+    else
+    {
+        denseOutput(newTime, y);
+    }
+
+    m_state->y[THETA_1] = y[THETA_1];
+    m_state->y[OMEGA_1] = y[OMEGA_1];
+    m_state->y[THETA_2] = y[THETA_2];
+    m_state->y[OMEGA_2] = y[OMEGA_2];
+
+    m_time = newTime;
+}
@@ -0,0 +1,93 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMADAPTIVE_H
+#define DOUBLEPENDULUMADAPTIVE_H
+
+#include "doublependulum.h"
+
+/**
+ * Base class for solvers which choose their own step size in order to meet
+ * an error tolerance.
+ *
+ * Steps are taken internally until they pass the requested time, after which
+ * the state at exactly that time is obtained from the dense output of the
+ * last step.  The user-specified dt is only used as the initial step size.
+ */
+class DoublePendulumAdaptive : public DoublePendulum
+{
+public:
+    DoublePendulumAdaptive(const Pendulum& upper, const Pendulum& lower,
+                           double dt, double g, double tol);
+
+    void update(double newTime);
+
+    /**
+     * Evaluates the solution at time t, which must lie within the most
+     * recently taken step.
+     */
+    void denseOutput(double t, double *yout) = 0;
+
+    double tolerance() const
+    {
+        return m_tol;
+    }
+
+    long acceptedSteps() const
+    {
+        return m_acceptedSteps;
+    }
+
+    long rejectedSteps() const
+    {
+        return m_rejectedSteps;
+    }
+
+protected:
+    /**
+     * Advances (m_tStep, m_y) by a single accepted step, starting with a
+     * trial step size of m_h and leaving m_h as the suggested size for the
+     * next step.  The starting point of the step must be saved in m_tPrev
+     * and m_yPrev, after which update() calls stepTaken().  If no step can
+     * be taken it should instead set m_stopped, leaving them unchanged.
+     */
+    virtual void step() = 0;
+
+    /**
+     * Absolute and relative error tolerance.
+     */
+    const double m_tol;
+
+    /**
+     * Next step size to attempt.
+     */
+    double m_h;
+
+    /**
+     * Time and state at the end of the most recent step; the start is kept
+     * in m_tPrev and m_yPrev.
+     */
+    double m_tStep;
+    double m_y[NUM_EQNS];
+
+    long m_acceptedSteps;
+    long m_rejectedSteps;
+};
+
+#endif // DOUBLEPENDULUMADAPTIVE_H
@@ -0,0 +1,280 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumarena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    // Smallest block to grow by once the reservation is exhausted
+    const size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    // Mappings are rounded up to whole huge pages (2 MiB on x86)
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /*
+     * The solver core does not depend on Qt, so over-allocate and align by
+     * hand, stashing the pointer malloc gave us just before the block.
+     */
+    char *alignedAlloc(size_t size)
+    {
+        const size_t alignment = DoublePendulumArena::ALIGNMENT;
+
+        char *raw = static_cast<char *>(malloc(size + alignment));
+
+        if (!raw)
+        {
+            throw std::bad_alloc();
+        }
+
+        char *p = raw + alignment - size_t(raw) % alignment;
+        reinterpret_cast<char **>(p)[-1] = raw;
+
+        return p;
+    }
+
+    void alignedFree(char *p)
+    {
+        if (p)
+        {
+            free(reinterpret_cast<char **>(p)[-1]);
+        }
+    }
+
+#ifdef __linux__
+    char *mapPages(size_t length, int flags)
+    {
+        void *p = mmap(0, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+
+        return (p == MAP_FAILED) ? 0 : static_cast<char *>(p);
+    }
+#endif
+}
+
+DoublePendulumArena::DoublePendulumArena(PageMode pages)
+    : m_pages(pages)
+    , m_states(0)
+    , m_stateCapacity(0)
+{
+    m_stateBlock.data = 0;
+    m_stateBlock.size = m_stateBlock.used = m_stateBlock.mapped = 0;
+}
+
+DoublePendulumArena::~DoublePendulumArena()
+{
+    clear();
+    release();
+}
+
+void DoublePendulumArena::reserve(int count, size_t objectBytes)
+{
+    clear();
+
+    const size_t stateBytes = objectSize(count * sizeof(DoublePendulumState));
+
+    // Reuse what we have if it is big enough
+    if (m_blocks.size() == 1 && !m_stateBlock.data && count <= m_stateCapacity
+     && objectBytes <= m_blocks[0].size - m_blocks[0].used)
+    {
+        return;
+    }
+
+    release();
+
+    Block block = allocateBlock(stateBytes + objectBytes);
+    block.used = stateBytes;
+
+    m_blocks.push_back(block);
+
+    m_states = reinterpret_cast<DoublePendulumState *>(block.data);
+    m_stateCapacity = count;
+}
+
+void DoublePendulumArena::clear()
+{
+    for (size_t i = 0; i < m_pendula.size(); ++i)
+    {
+        m_pendula[i]->~DoublePendulum();
+    }
+
+    m_pendula.clear();
+
+    // Everything after the state array is free again
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+        m_blocks[i].used = 0;
+    }
+
+    if (!m_blocks.empty() && !m_stateBlock.data)
+    {
+        m_blocks[0].used = objectSize(m_stateCapacity * sizeof(DoublePendulumState));
+    }
+}
+
+void *DoublePendulumArena::allocate(size_t size)
+{
+    size = objectSize(size);
+
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+        Block& block = m_blocks[i];
+
+        if (block.size - block.used >= size)
+        {
+            void *p = block.data + block.used;
+            block.used += size;
+
+            return p;
+        }
+    }
+
+    // Out of room so grow, doubling the space each time
+    size_t blockSize = std::max(size, MIN_BLOCK_SIZE);
+
+    if (!m_blocks.empty())
+    {
+        blockSize = std::max(blockSize, 2 * m_blocks.back().size);
+    }
+
+    Block block = allocateBlock(blockSize);
+    block.used = size;
+
+    m_blocks.push_back(block);
+
+    return block.data;
+}
+
+void DoublePendulumArena::adopt(DoublePendulum *pendulum)
+{
+    const int i = int(m_pendula.size());
+
+    if (i == m_stateCapacity)
+    {
+        // Move the states somewhere bigger and repoint the pendula at them
+        const int capacity = std::max(2 * m_stateCapacity, 64);
+        const Block block = allocateBlock(capacity * sizeof(DoublePendulumState));
+        DoublePendulumState *states = reinterpret_cast<DoublePendulumState *>(block.data);
+
+        if (i > 0)
+        {
+            memcpy(states, m_states, i * sizeof(DoublePendulumState));
+        }
+
+        for (int j = 0; j < i; ++j)
+        {
+            m_pendula[j]->m_state = &states[j];
+        }
+
+        freeBlock(m_stateBlock);
+
+        m_stateBlock = block;
+        m_states = states;
+        m_stateCapacity = capacity;
+    }
+
+    m_states[i] = *pendulum->m_state;
+    pendulum->m_state = &m_states[i];
+
+    m_pendula.push_back(pendulum);
+}
+
+DoublePendulumArena::Block DoublePendulumArena::allocateBlock(size_t size) const
+{
+    Block block;
+    block.data = 0;
+    block.size = size;
+    block.used = 0;
+    block.mapped = 0;
+
+#ifdef __linux__
+    if (m_pages != HeapPages)
+    {
+        const size_t pageSize = (m_pages == MappedPages) ? 4096 : HUGE_PAGE_SIZE;
+        const size_t length = (size + pageSize - 1) / pageSize * pageSize;
+
+#ifdef MAP_HUGETLB
+        if (m_pages == ExplicitHugePages)
+        {
+            block.data = mapPages(length, MAP_HUGETLB);
+        }
+#endif
+
+        if (!block.data)
+        {
+            block.data = mapPages(length, 0);
+
+#ifdef MADV_HUGEPAGE
+            if (block.data && m_pages != MappedPages)
+            {
+                madvise(block.data, length, MADV_HUGEPAGE);
+            }
+#endif
+        }
+
+        if (block.data)
+        {
+            block.size = block.mapped = length;
+            return block;
+        }
+    }
+#endif
+
+    block.data = alignedAlloc(size);
+
+    return block;
+}
+
+void DoublePendulumArena::freeBlock(const Block& block)
+{
+#ifdef __linux__
+    if (block.mapped)
+    {
+        munmap(block.data, block.mapped);
+        return;
+    }
+#endif
+
+    alignedFree(block.data);
+}
+
+void DoublePendulumArena::release()
+{
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+        freeBlock(m_blocks[i]);
+    }
+
+    m_blocks.clear();
+
+    freeBlock(m_stateBlock);
+    m_stateBlock.data = 0;
+    m_stateBlock.mapped = 0;
+
+    m_states = 0;
+    m_stateCapacity = 0;
+}
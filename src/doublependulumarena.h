@@ -0,0 +1,180 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMARENA_H
+#define DOUBLEPENDULUMARENA_H
+
+#include <cstddef>
+#include <vector>
+
+#include "doublependulum.h"
+
+/**
+ * Storage for the pendula of an ensemble.
+ *
+ * Pendula are constructed in the arena with new (arena) T(...), usually by
+ * DoublePendulumFactory, which bump allocates them one after the other on
+ * cache line boundaries and then moves their hot state, θ1, ω1, θ2, ω2,
+ * into an array of DoublePendulumState kept apart from the objects, so that
+ * stepping or drawing a whole ensemble walks two densely packed arrays.
+ *
+ * Given the number of pendula and the total size of their objects up front
+ * reserve() makes room for everything in a single allocation, and clear()
+ * destroys the pendula but keeps the memory, so an ensemble may be started
+ * and stopped repeatedly without going near the heap.  Should more be
+ * needed than was reserved the arena grows in further blocks.
+ *
+ * Memory is touched first by whichever thread calls reserve() and creates
+ * the pendula, so on NUMA machines an arena filled by a worker thread is
+ * local to that worker.  Mapping the blocks afresh rather than taking them
+ * from the heap makes sure of this, and for very large ensembles the
+ * blocks may be backed by huge pages to cut down on TLB misses.  Page
+ * modes other than HeapPages are only available on Linux; elsewhere, or
+ * should the mapping fail, the arena quietly falls back to the heap.
+ *
+ * Pendula in an arena are owned by it and must not be deleted.
+ */
+class DoublePendulumArena
+{
+public:
+    enum
+    {
+        /**
+         * Alignment of the objects and of the state array.
+         */
+        ALIGNMENT = 64
+    };
+
+    enum PageMode
+    {
+        /**
+         * Blocks come from malloc.
+         */
+        HeapPages,
+
+        /**
+         * Blocks are freshly mapped so that their pages are placed by
+         * first touch.
+         */
+        MappedPages,
+
+        /**
+         * As MappedPages, with the kernel advised to use transparent huge
+         * pages.
+         */
+        TransparentHugePages,
+
+        /**
+         * Blocks come from the explicit huge page pool (hugetlbfs), falling
+         * back to transparent huge pages if the pool is exhausted.
+         */
+        ExplicitHugePages
+    };
+
+    explicit DoublePendulumArena(PageMode pages=HeapPages);
+    ~DoublePendulumArena();
+
+    /**
+     * Destroys any pendula in the arena and makes room for count pendula
+     * whose objects need objectBytes between them, as given by summing
+     * objectSize() over them.
+     */
+    void reserve(int count, size_t objectBytes);
+
+    /**
+     * Destroys all of the pendula, keeping the memory for reuse.
+     */
+    void clear();
+
+    /**
+     * Size taken up in the arena by an object of the given size.
+     */
+    static size_t objectSize(size_t size)
+    {
+        return (size + ALIGNMENT - 1) & ~size_t(ALIGNMENT - 1);
+    }
+
+    int count() const
+    {
+        return int(m_pendula.size());
+    }
+
+    DoublePendulum *at(int i) const
+    {
+        return m_pendula[i];
+    }
+
+    /**
+     * States of all of the pendula in the order in which they were adopted.
+     */
+    const DoublePendulumState *states() const
+    {
+        return m_states;
+    }
+
+    /**
+     * Allocates size bytes for a pendulum; used by operator new.
+     */
+    void *allocate(size_t size);
+
+    /**
+     * Takes ownership of a pendulum constructed in the arena, moving its
+     * state into the state array.
+     */
+    void adopt(DoublePendulum *pendulum);
+
+private:
+    // Owns its memory and so can not be copied
+    DoublePendulumArena(const DoublePendulumArena&);
+    DoublePendulumArena& operator=(const DoublePendulumArena&);
+
+    struct Block
+    {
+        char *data;
+        size_t size;
+        size_t used;
+
+        /**
+         * Length of the mapping backing the block, or 0 if it is from the
+         * heap.
+         */
+        size_t mapped;
+    };
+
+    Block allocateBlock(size_t size) const;
+    static void freeBlock(const Block& block);
+
+    void release();
+
+    const PageMode m_pages;
+
+    std::vector<Block> m_blocks;
+
+    /**
+     * The state array, which is at the start of the first block unless it
+     * has outgrown it, in which case it lives in m_stateBlock.
+     */
+    DoublePendulumState *m_states;
+    int m_stateCapacity;
+    Block m_stateBlock;
+
+    std::vector<DoublePendulum *> m_pendula;
+};
+
+#endif // DOUBLEPENDULUMARENA_H
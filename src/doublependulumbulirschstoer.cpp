@@ -0,0 +1,377 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumbulirschstoer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Step size controller parameters, as in ODEX
+    const double safety = 0.94;
+    const double errSafety = 0.65;
+    const double minFactor = 0.02;
+    const double maxFactor = 4.0;
+
+    // Below this the error estimate is lost in rounding; ODEX likewise asks
+    // for a relative tolerance above 10·uround
+    const double minTol = 10.0 * std::numeric_limits<double>::epsilon();
+
+    /**
+     * Number of midpoint substeps for row k of the tableau.
+     */
+    int substeps(int k)
+    {
+        return 2 * (k + 1);
+    }
+
+    /**
+     * Evaluations of derivs() needed to compute rows 0..k of the tableau.
+     */
+    double work(int k)
+    {
+        double w = 1.0;
+        for (int i = 0; i <= k; ++i)
+        {
+            w += substeps(i);
+        }
+
+        return w;
+    }
+
+    double square(double x)
+    {
+        return x * x;
+    }
+
+    /**
+     * Factor by which to change the step size given the error estimate for
+     * column k; the limits on the change narrow as the order rises.
+     */
+    double stepFactor(double err, int k)
+    {
+        const double expo = 1.0 / (2 * k + 1);
+        const double limit = pow(minFactor, expo);
+
+        if (err == 0.0)
+        {
+            return 1.0 / limit;
+        }
+
+        return std::max(limit / maxFactor,
+                        std::min(1.0 / limit,
+                                 safety * pow(errSafety / err, expo)));
+    }
+}
+
+DoublePendulumBulirschStoer::DoublePendulumBulirschStoer(const Pendulum& upper,
+                                                         const Pendulum& lower,
+                                                         double dt, double g,
+                                                         double tol) :
+    DoublePendulumAdaptive(upper, lower, dt, g, tol),
+    m_stepColumn(0),
+    m_haveF1(false)
+{
+    // Initial column from the tolerance, as in ODEX
+    const int column = int(-log10(tol + 1e-40) * 0.6 + 0.5);
+
+    m_column = std::max(2, std::min(int(MAX_COLUMNS) - 2, column));
+}
+
+const char *DoublePendulumBulirschStoer::solverMethod()
+{
+    return "Bulirsch-Stoer";
+}
+
+void DoublePendulumBulirschStoer::midpoint(const double *yin, const double *f0,
+                                           double h, int n, double *dy)
+{
+    const double hs = h / n;
+    double d0[NUM_EQNS], d1[NUM_EQNS], z[NUM_EQNS], f[NUM_EQNS];
+
+    // The midpoint values are carried as increments to yin
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        d0[i] = 0.0;
+        d1[i] = hs * f0[i];
+    }
+
+    for (int m = 1; m < n; ++m)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            z[i] = yin[i] + d1[i];
+        }
+
+        derivs(z, f);
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            const double d2 = d0[i] + 2.0 * hs * f[i];
+
+            d0[i] = d1[i];
+            d1[i] = d2;
+        }
+    }
+
+    // Gragg's smoothing step
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        z[i] = yin[i] + d1[i];
+    }
+
+    derivs(z, f);
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        dy[i] = 0.5 * (d1[i] + d0[i] + hs * f[i]);
+    }
+}
+
+void DoublePendulumBulirschStoer::extrapolate(const double *yin,
+                                              const double *f0,
+                                              double h, int k)
+{
+    midpoint(yin, f0, h, substeps(k), m_table[k][0]);
+
+    // Aitken-Neville extrapolation to zero substep size in h²
+    for (int j = 1; j <= k; ++j)
+    {
+        const double ratio = square(double(substeps(k)) / substeps(k - j));
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_table[k][j][i] = m_table[k][j - 1][i]
+                             + (m_table[k][j - 1][i] - m_table[k - 1][j - 1][i])
+                             / (ratio - 1.0);
+        }
+    }
+}
+
+double DoublePendulumBulirschStoer::error(const double *yin, int k) const
+{
+    const double tol = std::max(m_tol, minTol);
+    double err = 0.0;
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        const double y = yin[i] + m_table[k][k][i];
+        const double scale = tol + tol * std::max(fabs(yin[i]), fabs(y));
+        const double e = (m_table[k][k][i] - m_table[k - 1][k - 1][i]) / scale;
+
+        err += e * e;
+    }
+
+    return sqrt(err / NUM_EQNS);
+}
+
+void DoublePendulumBulirschStoer::solveODEs(const double *yin, double *yout)
+{
+    double f0[NUM_EQNS];
+    derivs(yin, f0);
+
+    for (int k = 0; k <= m_column; ++k)
+    {
+        extrapolate(yin, f0, m_dt, k);
+    }
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yout[i] = yin[i] + m_table[m_column][m_column][i];
+    }
+
+    m_haveF1 = false;
+}
+
+void DoublePendulumBulirschStoer::step()
+{
+    // Reuse f at the end of the previous step if we have it
+    if (m_haveF1)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_f0[i] = m_f1[i];
+        }
+    }
+    else
+    {
+        derivs(m_y, m_f0);
+    }
+
+    bool rejected = false;
+
+    for (;;)
+    {
+        const double h = m_h;
+
+        // Error, suggested step size and work per unit step for each column
+        double errs[MAX_COLUMNS], hNew[MAX_COLUMNS], cost[MAX_COLUMNS];
+
+        bool converged = false;
+        int k;
+
+        // Add rows until the error converges within the window m_column ± 1
+        for (k = 0; k <= m_column + 1; ++k)
+        {
+            extrapolate(m_y, m_f0, h, k);
+
+            if (k == 0)
+            {
+                continue;
+            }
+
+            const double err = error(m_y, k);
+
+            errs[k] = err;
+            hNew[k] = h * stepFactor(err, k);
+            cost[k] = work(k) / hNew[k];
+
+            // After a rejection the window starts at m_column itself
+            if (k < m_column - (rejected ? 0 : 1))
+            {
+                continue;
+            }
+
+            if (err <= 1.0)
+            {
+                converged = true;
+                break;
+            }
+
+            // Give up early if convergence is not expected by m_column + 1,
+            // the error falling by roughly (n_k / n_0)² with each row
+            if (k == m_column - 1
+             && err > square(double(substeps(m_column) * substeps(m_column + 1))
+                             / (substeps(0) * substeps(0))))
+            {
+                break;
+            }
+
+            if (k == m_column
+             && err > square(double(substeps(m_column + 1)) / substeps(0)))
+            {
+                break;
+            }
+        }
+
+        if (converged)
+        {
+            m_tPrev = m_tStep;
+            m_tStep += h;
+
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                m_yPrev[i] = m_y[i];
+                m_y[i] += m_table[k][k][i];
+            }
+
+            m_stepColumn = k;
+
+            // f at the new point is the next step's f0; the current one
+            // is kept for the dense output
+            derivs(m_y, m_f1);
+
+            // Move to the neighbouring column if it is cheaper per unit step
+            int column = k;
+            if (k > 2 && cost[k - 1] < 0.8 * cost[k])
+            {
+                column = k - 1;
+            }
+            else if (!rejected && k >= m_column
+                  && cost[k] < 0.9 * cost[k - 1])
+            {
+                column = k + 1;
+            }
+
+            // Leave room for m_column + 1 in the tableau
+            m_column = std::max(2, std::min(int(MAX_COLUMNS) - 2, column));
+
+            if (m_column <= k)
+            {
+                m_h = hNew[m_column];
+            }
+            else
+            {
+                m_h = hNew[k] * work(m_column) / work(k);
+            }
+
+            // Do not grow the step straight after a rejection
+            if (rejected)
+            {
+                m_h = std::min(m_h, h);
+            }
+
+            ++m_acceptedSteps;
+            m_haveF1 = true;
+
+            break;
+        }
+        else
+        {
+            // Retry at the same column, predicting its error if we gave up
+            // before reaching it
+            const int last = std::min(k, m_column + 1);
+
+            if (last >= m_column)
+            {
+                m_h = hNew[m_column];
+            }
+            else
+            {
+                double err = errs[last];
+                for (int j = last + 1; j <= m_column; ++j)
+                {
+                    err /= square(double(substeps(j)) / substeps(0));
+                }
+
+                m_h = h * stepFactor(err, m_column);
+            }
+
+            ++m_rejectedSteps;
+            rejected = true;
+        }
+    }
+}
+
+void DoublePendulumBulirschStoer::denseOutput(double t, double *yout)
+{
+    if (t == m_tStep)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            yout[i] = m_y[i];
+        }
+
+        return;
+    }
+
+    // A step from the start of the last one straight to t, at the column
+    // it converged at; being shorter it is at least as accurate
+    for (int k = 0; k <= m_stepColumn; ++k)
+    {
+        extrapolate(m_yPrev, m_f0, t - m_tPrev, k);
+    }
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yout[i] = m_yPrev[i] + m_table[m_stepColumn][m_stepColumn][i];
+    }
+}
@@ -0,0 +1,123 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMBULIRSCHSTOER_H
+#define DOUBLEPENDULUMBULIRSCHSTOER_H
+
+#include "doublependulumadaptive.h"
+
+/**
+ * Bulirsch-Stoer extrapolation solver.
+ *
+ * Each step is taken with the modified midpoint rule for the substep counts
+ * 2, 4, 6, ... and the results extrapolated to zero substep size by
+ * Richardson (Aitken-Neville) extrapolation in h², one column of the
+ * tableau raising the order by two.  Both the order and the step size are
+ * chosen to minimise the work per unit step following Deuflhard (1983), as
+ * in the ODEX code of Hairer & Wanner.
+ *
+ * The steps taken are long, often several times those of DOP853, and low
+ * order interpolants are not accurate across them.  Dense output is instead
+ * by a fresh step from the start of the last one to the time wanted, which
+ * is as accurate as the step itself at the cost of a step per evaluation.
+ */
+class DoublePendulumBulirschStoer : public DoublePendulumAdaptive
+{
+public:
+    DoublePendulumBulirschStoer(const Pendulum& upper, const Pendulum& lower,
+                                double dt=0.005, double g=9.81,
+                                double tol=1e-10);
+
+    const char *solverMethod();
+
+    /**
+     * Takes a single step of size m_dt at the current order without any
+     * error control.
+     */
+    void solveODEs(const double *yin, double *yout);
+
+    void denseOutput(double t, double *yout);
+
+    /**
+     * Current column of the extrapolation tableau; the order is twice this
+     * plus two.
+     */
+    int column() const
+    {
+        return m_column;
+    }
+
+protected:
+    void step();
+
+private:
+    enum
+    {
+        MAX_COLUMNS = 8
+    };
+
+    /**
+     * Advances yin by h with n substeps of the modified midpoint rule,
+     * given f0 = f(yin), writing the smoothed increment to yin to dy.
+     */
+    void midpoint(const double *yin, const double *f0, double h, int n,
+                  double *dy);
+
+    /**
+     * Computes row k of the extrapolation tableau for a step of size h
+     * from yin, rows 0..k-1 already being in m_table.
+     */
+    void extrapolate(const double *yin, const double *f0, double h, int k);
+
+    /**
+     * Scaled RMS norm of the difference between diagonal entries k - 1 and
+     * k of the tableau.  This is the error of the former, whose order is
+     * that of m_table[k][k - 1], but unlike the difference along row k it
+     * does not shrink when the last columns happen to agree; at loose
+     * tolerances, where the steps are long, they often do.
+     */
+    double error(const double *yin, int k) const;
+
+    /**
+     * Extrapolation tableau of the increment over the step, which is more
+     * finely rounded than the state itself; m_table[k][j] is column j of
+     * row k.
+     */
+    double m_table[MAX_COLUMNS][MAX_COLUMNS][NUM_EQNS];
+
+    /**
+     * Column at which convergence is next expected, and the column at
+     * which the most recent step converged.
+     */
+    int m_column;
+    int m_stepColumn;
+
+    /**
+     * f at the start and end of the most recent step.
+     */
+    double m_f0[NUM_EQNS];
+    double m_f1[NUM_EQNS];
+
+    /**
+     * Whether m_f1 holds f(m_y), for reuse at the start of the next step.
+     */
+    bool m_haveF1;
+};
+
+#endif // DOUBLEPENDULUMBULIRSCHSTOER_H
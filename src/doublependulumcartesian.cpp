@@ -0,0 +1,294 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumcartesian.h"
+
+#include <cmath>
+#include <cassert>
+
+DoublePendulumCartesian::DoublePendulumCartesian(const Pendulum& upper,
+                                                 const Pendulum& lower,
+                                                 double dt, double g) :
+    DoublePendulum(upper, lower, dt, g)
+{
+    toCartesian(m_state->y, m_q, m_v);
+    resetTurns();
+
+    m_lambda[0] = m_lambda[1] = 0.0;
+}
+
+const char *DoublePendulumCartesian::solverMethod()
+{
+    return "RATTLE (Cartesian)";
+}
+
+void DoublePendulumCartesian::update(double newTime)
+{
+    assert(newTime >= m_time);
+
+    if (m_stopped)
+    {
+        return;
+    }
+
+    // The angles are only needed after each step when looking for events or
+    // sampling the state
+    const bool perStep = needsStepOutput();
+
+    do
+    {
+        double q[NUM_COORDS], v[NUM_COORDS];
+
+        rattle(m_q, m_v, q, v);
+        countTurns(m_q, q);
+
+        for (int i = 0; i < NUM_COORDS; ++i)
+        {
+            m_q[i] = q[i];
+            m_v[i] = v[i];
+        }
+
+        m_time += m_dt;
+
+        if (perStep)
+        {
+            const double yPrev[NUM_EQNS] = { m_state->y[THETA_1],
+                                             m_state->y[OMEGA_1],
+                                             m_state->y[THETA_2],
+                                             m_state->y[OMEGA_2] };
+
+            updateAngles();
+
+            stepTaken(m_time - m_dt, yPrev, m_time, m_state->y);
+            checkEvents(m_time, m_state->y);
+
+            if (m_stopped)
+            {
+                // Restart from the state at the event
+                toCartesian(m_state->y, m_q, m_v);
+                resetTurns();
+                return;
+            }
+        }
+    } while (m_time < newTime - 0.5 * m_dt);
+
+    if (!perStep)
+    {
+        updateAngles();
+    }
+}
+
+void DoublePendulumCartesian::solveODEs(const double *yin, double *yout)
+{
+    double q[NUM_COORDS], v[NUM_COORDS];
+    double qout[NUM_COORDS], vout[NUM_COORDS];
+
+    toCartesian(yin, q, v);
+    rattle(q, v, qout, vout);
+    toAngles(qout, vout, yin, yout);
+}
+
+double DoublePendulumCartesian::constraintError() const
+{
+    const double dx = m_q[X2] - m_q[X1], dy = m_q[Y2] - m_q[Y1];
+
+    const double e1 = fabs(sqrt(m_q[X1]*m_q[X1] + m_q[Y1]*m_q[Y1]) - m_l1);
+    const double e2 = fabs(sqrt(dx*dx + dy*dy) - m_l2);
+
+    return (e1 / m_l1 > e2 / m_l2) ? e1 / m_l1 : e2 / m_l2;
+}
+
+void DoublePendulumCartesian::rattle(const double *q, const double *v,
+                                     double *qout, double *vout)
+{
+    const double h = m_dt;
+    const double im1 = 1.0 / m_m1, im2 = 1.0 / m_m2;
+
+    // Constraint directions at the start of the step; the rod lengths are
+    // σ1 = |r1|² - l1² and σ2 = |r2 - r1|² - l2²
+    const double r1x = q[X1], r1y = q[Y1];
+    const double dx = q[X2] - q[X1], dy = q[Y2] - q[Y1];
+
+    // Unconstrained positions, r + h·v + ½h²·g
+    double qs[NUM_COORDS];
+
+    for (int i = 0; i < NUM_COORDS; ++i)
+    {
+        qs[i] = q[i] + h * v[i];
+    }
+
+    qs[Y1] -= 0.5 * h * h * m_g;
+    qs[Y2] -= 0.5 * h * h * m_g;
+
+    // SHAKE: find the (scaled) constraint forces, p, such that the rods
+    // have the right lengths at the end of the step
+    double p1 = m_lambda[0], p2 = m_lambda[1];
+
+    for (int i = 0; i < 20; ++i)
+    {
+        qout[X1] = qs[X1] - im1 * (p1*r1x - p2*dx);
+        qout[Y1] = qs[Y1] - im1 * (p1*r1y - p2*dy);
+        qout[X2] = qs[X2] - im2 * p2*dx;
+        qout[Y2] = qs[Y2] - im2 * p2*dy;
+
+        const double ex = qout[X2] - qout[X1], ey = qout[Y2] - qout[Y1];
+
+        const double s1 = qout[X1]*qout[X1] + qout[Y1]*qout[Y1] - m_l1*m_l1;
+        const double s2 = ex*ex + ey*ey - m_l2*m_l2;
+
+        if (fabs(s1) <= 1e-15 * m_l1*m_l1 && fabs(s2) <= 1e-15 * m_l2*m_l2)
+        {
+            break;
+        }
+
+        // Newton update using ∂σ/∂p
+        const double j11 = -2.0 * im1 * (qout[X1]*r1x + qout[Y1]*r1y);
+        const double j12 = 2.0 * im1 * (qout[X1]*dx + qout[Y1]*dy);
+        const double j21 = 2.0 * im1 * (ex*r1x + ey*r1y);
+        const double j22 = -2.0 * (im1 + im2) * (ex*dx + ey*dy);
+
+        const double det = j11*j22 - j12*j21;
+
+        p1 -= (j22*s1 - j12*s2) / det;
+        p2 -= (j11*s2 - j21*s1) / det;
+    }
+
+    m_lambda[0] = p1;
+    m_lambda[1] = p2;
+
+    // Velocity at the half step plus the second half kick from gravity
+    double w[NUM_COORDS];
+
+    for (int i = 0; i < NUM_COORDS; ++i)
+    {
+        w[i] = (qout[i] - q[i]) / h;
+    }
+
+    w[Y1] -= 0.5 * h * m_g;
+    w[Y2] -= 0.5 * h * m_g;
+
+    // RATTLE: remove the components of the velocity along the rods with a
+    // symmetric 2x2 solve for the constraint forces, μ
+    const double ex = qout[X2] - qout[X1], ey = qout[Y2] - qout[Y1];
+
+    const double a11 = im1 * (qout[X1]*qout[X1] + qout[Y1]*qout[Y1]);
+    const double a12 = -im1 * (qout[X1]*ex + qout[Y1]*ey);
+    const double a22 = (im1 + im2) * (ex*ex + ey*ey);
+
+    const double b1 = qout[X1]*w[X1] + qout[Y1]*w[Y1];
+    const double b2 = ex*(w[X2] - w[X1]) + ey*(w[Y2] - w[Y1]);
+
+    const double det = a11*a22 - a12*a12;
+    const double mu1 = (a22*b1 - a12*b2) / det;
+    const double mu2 = (a11*b2 - a12*b1) / det;
+
+    vout[X1] = w[X1] - im1 * (mu1*qout[X1] - mu2*ex);
+    vout[Y1] = w[Y1] - im1 * (mu1*qout[Y1] - mu2*ey);
+    vout[X2] = w[X2] - im2 * mu2*ex;
+    vout[Y2] = w[Y2] - im2 * mu2*ey;
+}
+
+void DoublePendulumCartesian::toCartesian(const double *y, double *q,
+                                          double *v) const
+{
+    const double s1 = sin(y[THETA_1]), c1 = cos(y[THETA_1]);
+    const double s2 = sin(y[THETA_2]), c2 = cos(y[THETA_2]);
+
+    q[X1] = m_l1 * s1;
+    q[Y1] = -m_l1 * c1;
+    q[X2] = q[X1] + m_l2 * s2;
+    q[Y2] = q[Y1] - m_l2 * c2;
+
+    v[X1] = m_l1 * y[OMEGA_1] * c1;
+    v[Y1] = m_l1 * y[OMEGA_1] * s1;
+    v[X2] = v[X1] + m_l2 * y[OMEGA_2] * c2;
+    v[Y2] = v[Y1] + m_l2 * y[OMEGA_2] * s2;
+}
+
+void DoublePendulumCartesian::countTurns(const double *qPrev,
+                                         const double *q)
+{
+    // An arm passes through the upward vertical when its x changes sign
+    // while it points up; a positive turn takes x from + to -
+    const double x[2][2] = { { qPrev[X1], q[X1] },
+                             { qPrev[X2] - qPrev[X1], q[X2] - q[X1] } };
+    const double y[2][2] = { { qPrev[Y1], q[Y1] },
+                             { qPrev[Y2] - qPrev[Y1], q[Y2] - q[Y1] } };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if ((x[i][0] < 0.0) != (x[i][1] < 0.0) && y[i][0] + y[i][1] > 0.0)
+        {
+            m_turns[i] += (x[i][1] < 0.0) ? 1 : -1;
+        }
+    }
+}
+
+void DoublePendulumCartesian::updateAngles()
+{
+    const double twoPi = 6.28318530717958647692;
+
+    const double dx = m_q[X2] - m_q[X1], dy = m_q[Y2] - m_q[Y1];
+    const double dvx = m_v[X2] - m_v[X1], dvy = m_v[Y2] - m_v[Y1];
+
+    m_state->y[THETA_1] = atan2(m_q[X1], -m_q[Y1]) + twoPi * m_turns[0];
+    m_state->y[THETA_2] = atan2(dx, -dy) + twoPi * m_turns[1];
+
+    m_state->y[OMEGA_1] = (m_q[X1]*m_v[Y1] - m_q[Y1]*m_v[X1])
+                        / (m_q[X1]*m_q[X1] + m_q[Y1]*m_q[Y1]);
+    m_state->y[OMEGA_2] = (dx*dvy - dy*dvx) / (dx*dx + dy*dy);
+}
+
+void DoublePendulumCartesian::resetTurns()
+{
+    const double twoPi = 6.28318530717958647692;
+
+    const double dx = m_q[X2] - m_q[X1], dy = m_q[Y2] - m_q[Y1];
+    const double base[2] = { atan2(m_q[X1], -m_q[Y1]), atan2(dx, -dy) };
+    const double theta[2] = { m_state->y[THETA_1], m_state->y[THETA_2] };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        m_turns[i] = int(floor((theta[i] - base[i]) / twoPi + 0.5));
+    }
+}
+
+void DoublePendulumCartesian::toAngles(const double *q, const double *v,
+                                       const double *yref, double *y) const
+{
+    const double twoPi = 6.28318530717958647692;
+
+    const double dx = q[X2] - q[X1], dy = q[Y2] - q[Y1];
+    const double dvx = v[X2] - v[X1], dvy = v[Y2] - v[Y1];
+
+    // θ is measured from the downward vertical
+    const double theta1 = atan2(q[X1], -q[Y1]);
+    const double theta2 = atan2(dx, -dy);
+
+    // Take the branch nearest to the reference angles
+    y[THETA_1] = yref[THETA_1] + (theta1 - yref[THETA_1])
+               - twoPi * floor((theta1 - yref[THETA_1]) / twoPi + 0.5);
+    y[THETA_2] = yref[THETA_2] + (theta2 - yref[THETA_2])
+               - twoPi * floor((theta2 - yref[THETA_2]) / twoPi + 0.5);
+
+    // dθ/dt = (r × v) / |r|²
+    y[OMEGA_1] = (q[X1]*v[Y1] - q[Y1]*v[X1])
+               / (q[X1]*q[X1] + q[Y1]*q[Y1]);
+    y[OMEGA_2] = (dx*dvy - dy*dvx) / (dx*dx + dy*dy);
+}
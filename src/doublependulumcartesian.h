@@ -0,0 +1,115 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMCARTESIAN_H
+#define DOUBLEPENDULUMCARTESIAN_H
+
+#include "doublependulum.h"
+
+/**
+ * Solves for the motion of the bobs in Cartesian coordinates, with the rods
+ * imposed as holonomic constraints, using the RATTLE scheme.
+ *
+ * Unlike the angle formulation the inner loop is free of transcendental
+ * functions: the positions are advanced under gravity, after which the
+ * constraint forces are found by a few Newton iterations on the rod lengths
+ * (SHAKE) and then by a single 2x2 solve for the velocities.  The scheme is
+ * second order, symplectic and keeps the rod lengths to round-off.
+ *
+ * The angles and angular velocities are recovered from the positions with
+ * atan2 once per call to update(), or after every step if any events or
+ * an observer are registered, so that the existing accessors (and items)
+ * work unchanged.  So that the angles land on the right turn however far
+ * the arms swing between calls, each step counts the times they pass
+ * through the upward vertical, where atan2 wraps around, with a sign test.
+ */
+class DoublePendulumCartesian : public DoublePendulum
+{
+public:
+    DoublePendulumCartesian(const Pendulum& upper, const Pendulum& lower,
+                            double dt=0.005, double g=9.81);
+
+    void update(double newTime);
+
+    const char *solverMethod();
+
+    void solveODEs(const double *yin, double *yout);
+
+    /**
+     * Returns the relative error in the rod lengths of the current state.
+     */
+    double constraintError() const;
+
+private:
+    enum
+    {
+        X1, Y1, X2, Y2,
+        NUM_COORDS
+    };
+
+    /**
+     * Takes a single RATTLE step of m_dt from (q, v) to (qout, vout).
+     */
+    void rattle(const double *q, const double *v, double *qout, double *vout);
+
+    /**
+     * Converts between angles and positions/velocities; the angles are
+     * unwrapped so as to lie within π of those in the reference state yref.
+     */
+    void toCartesian(const double *y, double *q, double *v) const;
+    void toAngles(const double *q, const double *v, const double *yref,
+                  double *y) const;
+
+    /**
+     * Updates m_turns for a step from qPrev to q.
+     */
+    void countTurns(const double *qPrev, const double *q);
+
+    /**
+     * Sets the state from m_q and m_v, placing the angles on the turns
+     * counted in m_turns.
+     */
+    void updateAngles();
+
+    /**
+     * Sets m_turns from the angles of the current state.
+     */
+    void resetTurns();
+
+    /**
+     * Positions and velocities of the bobs, (x1, y1, x2, y2), with y upwards
+     * and the pivot at the origin.
+     */
+    double m_q[NUM_COORDS];
+    double m_v[NUM_COORDS];
+
+    /**
+     * Scaled constraint forces from the last step, used as the starting
+     * guess for the next one.
+     */
+    double m_lambda[2];
+
+    /**
+     * Number of whole turns of each arm, such that its angle is atan2 of
+     * its position plus 2π times this.
+     */
+    int m_turns[2];
+};
+
+#endif // DOUBLEPENDULUMCARTESIAN_H
@@ -0,0 +1,91 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMDOP853_H
+#define DOUBLEPENDULUMDOP853_H
+
+#include "doublependulumadaptive.h"
+
+/**
+ * Dormand-Prince 8(5,3) explicit Runge Kutta solver.
+ *
+ * An eighth-order method with twelve stages (the last being reused as the
+ * first stage of the next step) whose error estimate combines embedded
+ * fifth- and third-order solutions.  Dense output of order seven is
+ * available at the cost of three additional stages, which are only computed
+ * when the solution is actually sampled within a step.
+ */
+class DoublePendulumDOP853 : public DoublePendulumAdaptive
+{
+public:
+    DoublePendulumDOP853(const Pendulum& upper, const Pendulum& lower,
+                         double dt=0.005, double g=9.81, double tol=1e-10);
+
+    const char *solverMethod();
+
+    /**
+     * Takes a single step of size m_dt without any error control.
+     */
+    void solveODEs(const double *yin, double *yout);
+
+    void denseOutput(double t, double *yout);
+
+protected:
+    void step();
+
+private:
+    enum
+    {
+        NUM_STAGES = 12,
+        NUM_DENSE_STAGES = 16
+    };
+
+    /**
+     * Evaluates stages 1..11 of a step of size h from yin, k[0] having
+     * already been set to f(yin), and writes the eighth-order solution to
+     * yout.
+     */
+    void evalStages(const double *yin, double h, double *yout);
+
+    /**
+     * Computes the extra stages and interpolation coefficients for the
+     * dense output of the most recent step.
+     */
+    void prepareDense();
+
+    /**
+     * Stage derivatives; k[12] is f at the end of the step and k[13..15]
+     * are the extra stages needed for dense output.
+     */
+    double m_k[NUM_DENSE_STAGES][NUM_EQNS];
+
+    /**
+     * Coefficients of the dense output polynomial.
+     */
+    double m_dense[7][NUM_EQNS];
+    bool m_denseReady;
+
+    /**
+     * Whether m_k[12] holds f(m_y), for reuse as the first stage of the
+     * next step (first same as last).
+     */
+    bool m_haveFsal;
+};
+
+#endif // DOUBLEPENDULUMDOP853_H
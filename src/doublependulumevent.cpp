@@ -0,0 +1,180 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumevent.h"
+#include "doublependulum.h"
+
+#include <cmath>
+#include <cassert>
+
+DoublePendulumEvent::DoublePendulumEvent(int actions, Direction direction,
+                                         int recordCapacity) :
+    m_actions(actions),
+    m_direction(direction),
+    m_capacity((actions & Record) ? recordCapacity : 0),
+    m_records(0),
+    m_count(0)
+{
+    assert(recordCapacity >= 0);
+
+    if (m_capacity > 0)
+    {
+        m_records = new double[RECORD_SIZE * m_capacity];
+    }
+}
+
+DoublePendulumEvent::~DoublePendulumEvent()
+{
+    delete[] m_records;
+}
+
+bool DoublePendulumEvent::accept(const DoublePendulum&, double, const double *)
+{
+    return true;
+}
+
+void DoublePendulumEvent::triggered(const DoublePendulum&, double,
+                                    const double *)
+{
+}
+
+void DoublePendulumEvent::reset()
+{
+    m_count = 0;
+}
+
+bool DoublePendulumEvent::crosses(double ga, double gb) const
+{
+    // A crossing must start strictly on one side so that an event located
+    // at the very start of a step is not reported a second time
+    switch (m_direction)
+    {
+        case Rising:
+            return ga < 0.0 && gb >= 0.0;
+        case Falling:
+            return ga > 0.0 && gb <= 0.0;
+        default:
+            return (ga < 0.0 && gb >= 0.0) || (ga > 0.0 && gb <= 0.0);
+    }
+}
+
+void DoublePendulumEvent::fire(const DoublePendulum& pendulum,
+                               double t, const double *y)
+{
+    if (m_count < m_capacity)
+    {
+        double *r = &m_records[RECORD_SIZE * m_count];
+
+        r[0] = t;
+
+        for (int i = 1; i < RECORD_SIZE; ++i)
+        {
+            r[i] = y[i - 1];
+        }
+    }
+
+    ++m_count;
+
+    if (m_actions & Callback)
+    {
+        triggered(pendulum, t, y);
+    }
+}
+
+DoublePendulumFlipEvent::DoublePendulumFlipEvent(int arm, int actions,
+                                                 int recordCapacity) :
+    DoublePendulumEvent(actions, Either, recordCapacity),
+    m_index(2 * (arm - 1))
+{
+    assert(arm == 1 || arm == 2);
+}
+
+double DoublePendulumFlipEvent::value(const DoublePendulum&, double,
+                                      const double *y)
+{
+    return sin(y[m_index]);
+}
+
+bool DoublePendulumFlipEvent::accept(const DoublePendulum&, double,
+                                     const double *y)
+{
+    // sin θ is also zero when hanging straight down
+    return cos(y[m_index]) < 0.0;
+}
+
+DoublePendulumAngleEvent::DoublePendulumAngleEvent(int arm, double limit,
+                                                   int actions,
+                                                   Direction direction,
+                                                   int recordCapacity) :
+    DoublePendulumEvent(actions, direction, recordCapacity),
+    m_index(2 * (arm - 1)),
+    m_limit(limit)
+{
+    assert(arm == 1 || arm == 2);
+}
+
+double DoublePendulumAngleEvent::value(const DoublePendulum&, double,
+                                       const double *y)
+{
+    return y[m_index] - m_limit;
+}
+
+DoublePendulumEnergyDriftEvent::DoublePendulumEnergyDriftEvent(double threshold,
+                                                               int actions) :
+    DoublePendulumEvent(actions, Rising),
+    m_threshold(threshold)
+{
+}
+
+double DoublePendulumEnergyDriftEvent::value(const DoublePendulum& pendulum,
+                                             double, const double *y)
+{
+    const double e0 = pendulum.initEnergy();
+    const double scale = (e0 != 0.0) ? fabs(e0) : 1.0;
+
+    return fabs(pendulum.energy(y) - e0) - m_threshold * scale;
+}
+
+PoincareSectionEvent::PoincareSectionEvent(PoincareListener *listener) :
+    DoublePendulumEvent(Callback, Rising),
+    m_listener(listener)
+{
+}
+
+double PoincareSectionEvent::value(const DoublePendulum&, double,
+                                   const double *y)
+{
+    return sin(y[0]);
+}
+
+bool PoincareSectionEvent::accept(const DoublePendulum&, double,
+                                  const double *y)
+{
+    // Discard the crossings through θ1 = π and those moving the wrong way
+    return cos(y[0]) > 0.0 && y[1] > 0.0;
+}
+
+void PoincareSectionEvent::triggered(const DoublePendulum&, double t,
+                                     const double *y)
+{
+    if (m_listener)
+    {
+        m_listener->sectionCrossed(t, y[1], y[2], y[3]);
+    }
+}
@@ -0,0 +1,280 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMEVENT_H
+#define DOUBLEPENDULUMEVENT_H
+
+class DoublePendulum;
+
+/**
+ * An event which occurs whenever a user-supplied function of the state,
+ * g(t, y), passes through zero.
+ *
+ * Events are registered with DoublePendulum::addEvent() and are checked
+ * after every step taken inside update().  When g changes sign over a step
+ * the crossing is located to round-off using the dense output of the step,
+ * after which the requested actions are carried out.  The state is always
+ * laid out as θ1, ω1, θ2, ω2.
+ */
+class DoublePendulumEvent
+{
+public:
+    /**
+     * What to do when the event occurs; these may be combined.
+     */
+    enum Action
+    {
+        Callback = 0x1,     /**< Call triggered() */
+        Record   = 0x2,     /**< Save the time and state of the event */
+        Stop     = 0x4      /**< Halt update() at the event */
+    };
+
+    /**
+     * Which zero crossings of g are of interest.
+     */
+    enum Direction
+    {
+        Falling = -1,
+        Either  =  0,
+        Rising  =  1
+    };
+
+    /**
+     * Creates an event which carries out the given actions.  Space for
+     * recordCapacity occurrences is allocated up front so that recording
+     * does not allocate inside the solver loop; once it is full further
+     * occurrences are counted but not saved.
+     */
+    DoublePendulumEvent(int actions, Direction direction = Either,
+                        int recordCapacity = 0);
+
+    virtual ~DoublePendulumEvent();
+
+    /**
+     * The event function; the event occurs at its zeros.
+     */
+    virtual double value(const DoublePendulum& pendulum,
+                         double t, const double *y) = 0;
+
+    /**
+     * Allows zeros of g to be rejected once located, for example to tell
+     * apart the two zeros of sin θ.  The default accepts all of them.
+     */
+    virtual bool accept(const DoublePendulum& pendulum,
+                        double t, const double *y);
+
+    /**
+     * Called at each occurrence of the event if the Callback action was
+     * requested.  The default does nothing.
+     */
+    virtual void triggered(const DoublePendulum& pendulum,
+                           double t, const double *y);
+
+    int actions() const
+    {
+        return m_actions;
+    }
+
+    Direction direction() const
+    {
+        return m_direction;
+    }
+
+    /**
+     * Returns the number of times the event has occurred.
+     */
+    int count() const
+    {
+        return m_count;
+    }
+
+    /**
+     * Returns the number of occurrences which have been recorded, which
+     * is at most the record capacity.
+     */
+    int recordCount() const
+    {
+        return m_count < m_capacity ? m_count : m_capacity;
+    }
+
+    double recordTime(int i) const
+    {
+        return m_records[RECORD_SIZE*i];
+    }
+
+    /**
+     * Returns the state θ1, ω1, θ2, ω2 at the i-th recorded occurrence.
+     */
+    const double *recordState(int i) const
+    {
+        return &m_records[RECORD_SIZE*i + 1];
+    }
+
+    /**
+     * Forgets all previous occurrences of the event.
+     */
+    void reset();
+
+private:
+    friend class DoublePendulum;
+
+    enum
+    {
+        RECORD_SIZE = 5
+    };
+
+    // Events own their record storage and so can not be copied
+    DoublePendulumEvent(const DoublePendulumEvent&);
+    DoublePendulumEvent& operator=(const DoublePendulumEvent&);
+
+    /**
+     * Returns true if g passing from ga to gb is a crossing of interest.
+     */
+    bool crosses(double ga, double gb) const;
+
+    /**
+     * Counts, records and calls back for an occurrence at (t, y).
+     */
+    void fire(const DoublePendulum& pendulum, double t, const double *y);
+
+    const int m_actions;
+    const Direction m_direction;
+
+    const int m_capacity;
+    double *m_records;
+
+    int m_count;
+};
+
+/**
+ * Fires when arm 1 (upper) or 2 (lower) passes over the top of its pivot,
+ * θ = π (mod 2π).
+ */
+class DoublePendulumFlipEvent : public DoublePendulumEvent
+{
+public:
+    DoublePendulumFlipEvent(int arm, int actions, int recordCapacity = 0);
+
+    double value(const DoublePendulum& pendulum, double t, const double *y);
+
+    bool accept(const DoublePendulum& pendulum, double t, const double *y);
+
+private:
+    const int m_index;
+};
+
+/**
+ * Fires when the angle of arm 1 or 2 reaches the given limit (in rad).
+ */
+class DoublePendulumAngleEvent : public DoublePendulumEvent
+{
+public:
+    DoublePendulumAngleEvent(int arm, double limit, int actions,
+                             Direction direction = Either,
+                             int recordCapacity = 0);
+
+    double value(const DoublePendulum& pendulum, double t, const double *y);
+
+private:
+    const int m_index;
+    const double m_limit;
+};
+
+/**
+ * Fires when the relative drift in the mechanical energy, |E - E0| / |E0|,
+ * grows past the given threshold; useful for stopping a run whose solver
+ * is no longer trustworthy.
+ */
+class DoublePendulumEnergyDriftEvent : public DoublePendulumEvent
+{
+public:
+    DoublePendulumEnergyDriftEvent(double threshold, int actions = Stop);
+
+    double value(const DoublePendulum& pendulum, double t, const double *y);
+
+private:
+    const double m_threshold;
+};
+
+/**
+ * Receives the points at which a trajectory crosses the Poincaré section
+ * θ1 = 0 (mod 2π) with ω1 > 0.
+ */
+class PoincareListener
+{
+public:
+    virtual ~PoincareListener() {}
+
+    virtual void sectionCrossed(double t, double omega1,
+                                double theta2, double omega2) = 0;
+};
+
+/**
+ * The Poincaré section θ1 = 0, ω1 > 0 expressed as an event which forwards
+ * its occurrences to a PoincareListener.
+ */
+class PoincareSectionEvent : public DoublePendulumEvent
+{
+public:
+    PoincareSectionEvent(PoincareListener *listener = 0);
+
+    void setListener(PoincareListener *listener)
+    {
+        m_listener = listener;
+    }
+
+    PoincareListener *listener() const
+    {
+        return m_listener;
+    }
+
+    double value(const DoublePendulum& pendulum, double t, const double *y);
+
+    bool accept(const DoublePendulum& pendulum, double t, const double *y);
+
+    void triggered(const DoublePendulum& pendulum, double t, const double *y);
+
+private:
+    PoincareListener *m_listener;
+};
+
+/**
+ * Receives the state of a pendulum at evenly spaced times, interpolated
+ * from the steps taken by the solver; see DoublePendulum::addObserver().
+ */
+class DoublePendulumObserver
+{
+public:
+    virtual ~DoublePendulumObserver() {}
+
+    virtual void sample(const DoublePendulum& pendulum,
+                        double t, const double *y) = 0;
+
+    /**
+     * Whether sample() may be called from a thread other than the one the
+     * observer lives in.  Samples for observers which are not are relayed
+     * back to it; see TimeWarpBuffer.
+     */
+    virtual bool isThreadSafe() const
+    {
+        return false;
+    }
+};
+
+#endif // DOUBLEPENDULUMEVENT_H
@@ -0,0 +1,142 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumfactory.h"
+#include "doublependulumarena.h"
+
+#include "doublependulumeuler.h"
+#include "doublependulumrk4.h"
+#include "doublependulumnormalmode.h"
+#include "doublependulumgausslegendre.h"
+#include "doublependulumdop853.h"
+#include "doublependulumtaylor.h"
+#include "doublependulumbulirschstoer.h"
+#include "doublependulumcartesian.h"
+
+QStringList DoublePendulumFactory::solvers()
+{
+    return QStringList() << "Euler"
+                         << "Runge Kutta (RK4)"
+                         << "Runge Kutta (RK4) + normal modes"
+                         << "Runge Kutta (RK4) + energy projection"
+                         << "Gauss-Legendre (2 stage)"
+                         << "Gauss-Legendre (3 stage)"
+                         << "Dormand-Prince (DOP853)"
+                         << "Taylor series"
+                         << "Bulirsch-Stoer"
+                         << "RATTLE (Cartesian)";
+}
+
+DoublePendulum *DoublePendulumFactory::create(const QString& solver,
+                                              const Pendulum& upper,
+                                              const Pendulum& lower,
+                                              double dt, double g,
+                                              DoublePendulumArena *arena)
+{
+    DoublePendulum *p = 0;
+
+    if (solver == "Euler")
+    {
+        p = new (arena) DoublePendulumEuler(upper, lower, dt, g);
+    }
+    else if (solver == "Runge Kutta (RK4)")
+    {
+        p = new (arena) DoublePendulumRK4(upper, lower, dt, g);
+    }
+    else if (solver == "Runge Kutta (RK4) + normal modes")
+    {
+        p = new (arena) DoublePendulumNormalMode(upper, lower, dt, g);
+    }
+    else if (solver == "Runge Kutta (RK4) + energy projection")
+    {
+        p = new (arena) DoublePendulumRK4(upper, lower, dt, g);
+        p->setEnergyProjection(true);
+    }
+    else if (solver == "Gauss-Legendre (2 stage)")
+    {
+        p = new (arena) DoublePendulumGaussLegendre(upper, lower, dt, g, 2);
+    }
+    else if (solver == "Gauss-Legendre (3 stage)")
+    {
+        p = new (arena) DoublePendulumGaussLegendre(upper, lower, dt, g, 3);
+    }
+    else if (solver == "Dormand-Prince (DOP853)")
+    {
+        p = new (arena) DoublePendulumDOP853(upper, lower, dt, g);
+    }
+    else if (solver == "Taylor series")
+    {
+        p = new (arena) DoublePendulumTaylor(upper, lower, dt, g);
+    }
+    else if (solver == "Bulirsch-Stoer")
+    {
+        p = new (arena) DoublePendulumBulirschStoer(upper, lower, dt, g);
+    }
+    else if (solver == "RATTLE (Cartesian)")
+    {
+        p = new (arena) DoublePendulumCartesian(upper, lower, dt, g);
+    }
+
+    if (p && arena)
+    {
+        arena->adopt(p);
+    }
+
+    return p;
+}
+
+size_t DoublePendulumFactory::objectSize(const QString& solver)
+{
+    if (solver == "Euler")
+    {
+        return sizeof(DoublePendulumEuler);
+    }
+    else if (solver == "Runge Kutta (RK4)"
+          || solver == "Runge Kutta (RK4) + energy projection")
+    {
+        return sizeof(DoublePendulumRK4);
+    }
+    else if (solver == "Runge Kutta (RK4) + normal modes")
+    {
+        return sizeof(DoublePendulumNormalMode);
+    }
+    else if (solver == "Gauss-Legendre (2 stage)"
+          || solver == "Gauss-Legendre (3 stage)")
+    {
+        return sizeof(DoublePendulumGaussLegendre);
+    }
+    else if (solver == "Dormand-Prince (DOP853)")
+    {
+        return sizeof(DoublePendulumDOP853);
+    }
+    else if (solver == "Taylor series")
+    {
+        return sizeof(DoublePendulumTaylor);
+    }
+    else if (solver == "Bulirsch-Stoer")
+    {
+        return sizeof(DoublePendulumBulirschStoer);
+    }
+    else if (solver == "RATTLE (Cartesian)")
+    {
+        return sizeof(DoublePendulumCartesian);
+    }
+
+    return 0;
+}
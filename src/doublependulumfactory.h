@@ -0,0 +1,60 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMFACTORY_H
+#define DOUBLEPENDULUMFACTORY_H
+
+#include <QString>
+#include <QStringList>
+
+#include <cstddef>
+
+#include "doublependulum.h"
+
+class DoublePendulumArena;
+
+/**
+ * Creates solvers from their solverMethod() names.
+ */
+class DoublePendulumFactory
+{
+public:
+    /**
+     * Returns the names of all of the available solvers.
+     */
+    static QStringList solvers();
+
+    /**
+     * Creates a new pendulum using the named solver, returning 0 if there is
+     * no such solver.  The caller takes ownership of the pendulum unless an
+     * arena is given, in which case it is created in and owned by the arena.
+     */
+    static DoublePendulum *create(const QString& solver,
+                                  const Pendulum& upper, const Pendulum& lower,
+                                  double dt, double g,
+                                  DoublePendulumArena *arena = 0);
+
+    /**
+     * Returns the size of a pendulum using the named solver, for reserving
+     * space in an arena, or 0 if there is no such solver.
+     */
+    static size_t objectSize(const QString& solver);
+};
+
+#endif // DOUBLEPENDULUMFACTORY_H
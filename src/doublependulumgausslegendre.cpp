@@ -0,0 +1,340 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumgausslegendre.h"
+
+#include <cmath>
+#include <cassert>
+
+namespace
+{
+    // Two stage (fourth-order) tableau; √3/6 = 0.2886751345948129
+    const double gl2A[3][3] =
+    {
+        { 0.25, 0.25 - 0.2886751345948128822545744, 0.0 },
+        { 0.25 + 0.2886751345948128822545744, 0.25, 0.0 },
+        { 0.0, 0.0, 0.0 }
+    };
+
+    const double gl2B[3] = { 0.5, 0.5, 0.0 };
+
+    // Three stage (sixth-order) tableau; √15 = 3.872983346207417
+    const double sqrt15 = 3.872983346207416885179265;
+
+    const double gl3A[3][3] =
+    {
+        { 5.0/36.0, 2.0/9.0 - sqrt15/15.0, 5.0/36.0 - sqrt15/30.0 },
+        { 5.0/36.0 + sqrt15/24.0, 2.0/9.0, 5.0/36.0 - sqrt15/24.0 },
+        { 5.0/36.0 + sqrt15/30.0, 2.0/9.0 + sqrt15/15.0, 5.0/36.0 }
+    };
+
+    const double gl3B[3] = { 5.0/18.0, 4.0/9.0, 5.0/18.0 };
+}
+
+DoublePendulumGaussLegendre::DoublePendulumGaussLegendre(const Pendulum& upper,
+                                                         const Pendulum& lower,
+                                                         double dt, double g,
+                                                         int stages) :
+    DoublePendulum(upper, lower, dt, g),
+    m_stages(stages),
+    m_a(stages == 3 ? gl3A : gl2A),
+    m_b(stages == 3 ? gl3B : gl2B),
+    m_newtonIterations(0),
+    m_newtonFailures(0)
+{
+    assert(stages == 2 || stages == 3);
+}
+
+const char *DoublePendulumGaussLegendre::solverMethod()
+{
+    return (m_stages == 3) ? "Gauss-Legendre (3 stage)"
+                           : "Gauss-Legendre (2 stage)";
+}
+
+void DoublePendulumGaussLegendre::solveODEs(const double *yin, double *yout)
+{
+    solveStep(yin, m_dt, yout, 0);
+}
+
+void DoublePendulumGaussLegendre::solveStep(const double *yin, double h,
+                                            double *yout, int depth)
+{
+    if (tryStep(yin, h, yout))
+    {
+        return;
+    }
+
+    // If the Newton iteration fails to converge take two half steps instead
+    if (depth < MAX_SPLITS)
+    {
+        double ymid[NUM_EQNS];
+
+        solveStep(yin, 0.5 * h, ymid, depth + 1);
+        solveStep(ymid, 0.5 * h, yout, depth + 1);
+    }
+    // Failing that, as a last resort, an explicit step
+    else
+    {
+        ++m_newtonFailures;
+
+        rk4Step(yin, h, yout);
+    }
+}
+
+void DoublePendulumGaussLegendre::rk4Step(const double *yin, double h,
+                                          double *yout)
+{
+    double k1[NUM_EQNS], k2[NUM_EQNS], k3[NUM_EQNS], k4[NUM_EQNS];
+    double yt[NUM_EQNS];
+
+    derivs(yin, k1);
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yt[i] = yin[i] + 0.5 * h * k1[i];
+    }
+
+    derivs(yt, k2);
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yt[i] = yin[i] + 0.5 * h * k2[i];
+    }
+
+    derivs(yt, k3);
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yt[i] = yin[i] + h * k3[i];
+    }
+
+    derivs(yt, k4);
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yout[i] = yin[i] + h * (k1[i] + 2.0 * (k2[i] + k3[i]) + k4[i]) / 6.0;
+    }
+}
+
+bool DoublePendulumGaussLegendre::tryStep(const double *yin, double h,
+                                          double *yout)
+{
+    const int n = m_stages * NUM_EQNS;
+
+    double jac[NUM_EQNS][NUM_EQNS];
+    double iter[MAX_UNKNOWNS][MAX_UNKNOWNS];
+    int perm[MAX_UNKNOWNS];
+
+    double z[MAX_STAGES][NUM_EQNS], f[MAX_STAGES][NUM_EQNS];
+    double yt[NUM_EQNS], res[MAX_UNKNOWNS];
+
+    // Build and factorise the simplified Newton matrix, I - h(A⊗J(y0))
+    jacobian(yin, jac);
+
+    for (int si = 0; si < m_stages; ++si)
+    {
+        for (int sj = 0; sj < m_stages; ++sj)
+        {
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                for (int j = 0; j < NUM_EQNS; ++j)
+                {
+                    iter[si*NUM_EQNS + i][sj*NUM_EQNS + j] =
+                        ((si == sj && i == j) ? 1.0 : 0.0)
+                      - h * m_a[si][sj] * jac[i][j];
+                }
+            }
+        }
+    }
+
+    luDecompose(iter, n, perm);
+
+    // Start from the explicit Euler predictor, Zi = ci·h·f(y0)
+    derivs(yin, f[0]);
+
+    for (int s = 0; s < m_stages; ++s)
+    {
+        double c = 0.0;
+        for (int r = 0; r < m_stages; ++r)
+        {
+            c += m_a[s][r];
+        }
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            z[s][i] = c * h * f[0][i];
+        }
+    }
+
+    double scale = 1.0;
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        scale += yin[i] * yin[i];
+    }
+
+    // Iterate on the stage increments Z = h(A⊗I)F(y0 + Z)
+    bool converged = false;
+    double prevNorm = 0.0;
+
+    for (int it = 0; it < MAX_ITERATIONS && !converged; ++it)
+    {
+        ++m_newtonIterations;
+
+        for (int s = 0; s < m_stages; ++s)
+        {
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                yt[i] = yin[i] + z[s][i];
+            }
+
+            derivs(yt, f[s]);
+        }
+
+        // Residual, h(A⊗I)F - Z
+        for (int s = 0; s < m_stages; ++s)
+        {
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                double sum = 0.0;
+                for (int r = 0; r < m_stages; ++r)
+                {
+                    sum += m_a[s][r] * f[r][i];
+                }
+
+                res[s*NUM_EQNS + i] = h * sum - z[s][i];
+            }
+        }
+
+        luSolve(iter, n, perm, res);
+
+        // Apply the correction
+        double norm = 0.0;
+        for (int s = 0; s < m_stages; ++s)
+        {
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                z[s][i] += res[s*NUM_EQNS + i];
+                norm += res[s*NUM_EQNS + i] * res[s*NUM_EQNS + i];
+            }
+        }
+
+        converged = (norm <= 1e-28 * scale);
+
+        // Give up if the iteration is not contracting
+        if (!converged && it > 0 && (norm != norm || norm > 0.5 * prevNorm))
+        {
+            return false;
+        }
+
+        prevNorm = norm;
+    }
+
+    if (!converged)
+    {
+        return false;
+    }
+
+    // Re-evaluate the stages at the converged increments
+    for (int s = 0; s < m_stages; ++s)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            yt[i] = yin[i] + z[s][i];
+        }
+
+        derivs(yt, f[s]);
+    }
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        double sum = 0.0;
+        for (int s = 0; s < m_stages; ++s)
+        {
+            sum += m_b[s] * f[s][i];
+        }
+
+        yout[i] = yin[i] + h * sum;
+    }
+
+    return true;
+}
+
+void DoublePendulumGaussLegendre::luDecompose(double a[][MAX_UNKNOWNS], int n,
+                                              int *perm)
+{
+    for (int k = 0; k < n; ++k)
+    {
+        // Find the pivot
+        int p = k;
+        for (int i = k + 1; i < n; ++i)
+        {
+            if (fabs(a[i][k]) > fabs(a[p][k]))
+            {
+                p = i;
+            }
+        }
+
+        perm[k] = p;
+
+        if (p != k)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                const double t = a[k][j];
+                a[k][j] = a[p][j];
+                a[p][j] = t;
+            }
+        }
+
+        // Eliminate below the pivot
+        for (int i = k + 1; i < n; ++i)
+        {
+            a[i][k] /= a[k][k];
+
+            for (int j = k + 1; j < n; ++j)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
+        }
+    }
+}
+
+void DoublePendulumGaussLegendre::luSolve(const double a[][MAX_UNKNOWNS], int n,
+                                          const int *perm, double *b)
+{
+    // Apply the row interchanges and forward substitute
+    for (int k = 0; k < n; ++k)
+    {
+        const double t = b[perm[k]];
+        b[perm[k]] = b[k];
+        b[k] = t;
+
+        for (int i = k + 1; i < n; ++i)
+        {
+            b[i] -= a[i][k] * b[k];
+        }
+    }
+
+    // Back substitute
+    for (int i = n - 1; i >= 0; --i)
+    {
+        for (int j = i + 1; j < n; ++j)
+        {
+            b[i] -= a[i][j] * b[j];
+        }
+
+        b[i] /= a[i][i];
+    }
+}
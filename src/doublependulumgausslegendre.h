@@ -0,0 +1,117 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMGAUSSLEGENDRE_H
+#define DOUBLEPENDULUMGAUSSLEGENDRE_H
+
+#include "doublependulum.h"
+
+/**
+ * Implicit Gauss-Legendre collocation solver with either two (fourth-order)
+ * or three (sixth-order) stages.
+ *
+ * The method is A-stable and symplectic, so it remains stable with large
+ * steps when the pendulum has extreme mass or length ratios.  The stage
+ * equations are solved with a simplified Newton iteration, the iteration
+ * matrix I - h(A⊗J) being built from the analytic Jacobian at the start of
+ * each step and factorised only once per step.  Should the iteration stop
+ * contracting the step is transparently split in two, and should it still
+ * fail after MAX_SPLITS splits that part of the step is taken with explicit
+ * RK4 instead.
+ */
+class DoublePendulumGaussLegendre : public DoublePendulum
+{
+public:
+    DoublePendulumGaussLegendre(const Pendulum& upper, const Pendulum& lower,
+                                double dt=0.005, double g=9.81,
+                                int stages=2);
+
+    const char *solverMethod();
+
+    /**
+     * Total number of Newton iterations performed so far.
+     */
+    long newtonIterations() const
+    {
+        return m_newtonIterations;
+    }
+
+    /**
+     * Number of (sub)steps on which the Newton iteration failed even after
+     * splitting, and which were taken with RK4 instead.
+     */
+    long newtonFailures() const
+    {
+        return m_newtonFailures;
+    }
+
+protected:
+    void solveODEs(const double *yin, double *yout);
+
+private:
+    enum
+    {
+        MAX_STAGES = 3,
+        MAX_UNKNOWNS = MAX_STAGES * NUM_EQNS,
+        MAX_ITERATIONS = 12,
+        MAX_SPLITS = 8
+    };
+
+    /**
+     * Advances yin by h, recursively halving the step should the Newton
+     * iteration fail to converge.
+     */
+    void solveStep(const double *yin, double h, double *yout, int depth);
+
+    /**
+     * Attempts a single collocation step of size h, returning false if the
+     * simplified Newton iteration does not converge.
+     */
+    bool tryStep(const double *yin, double h, double *yout);
+
+    /**
+     * Takes an explicit RK4 step of size h, for when tryStep() has failed.
+     */
+    void rk4Step(const double *yin, double h, double *yout);
+
+    /**
+     * LU factorises the n×n matrix a in place with partial pivoting.
+     */
+    static void luDecompose(double a[][MAX_UNKNOWNS], int n, int *perm);
+
+    /**
+     * Solves a·x = b, a having been factorised by luDecompose.  The solution
+     * overwrites b.
+     */
+    static void luSolve(const double a[][MAX_UNKNOWNS], int n,
+                        const int *perm, double *b);
+
+    const int m_stages;
+
+    /**
+     * Butcher tableau for the selected number of stages.
+     */
+    const double (*m_a)[MAX_STAGES];
+    const double *m_b;
+
+    long m_newtonIterations;
+    long m_newtonFailures;
+};
+
+#endif // DOUBLEPENDULUMGAUSSLEGENDRE_H
@@ -26,10 +26,18 @@
 
 #include <cmath>
 
+namespace
+{
+    // Beyond this many pendula the rest are summarised in a single line
+    const int MAX_LISTED = 16;
+}
+
 DoublePendulumInfoItem::DoublePendulumInfoItem()
     : m_iconSize(16.0)
     , m_horizontalPadding(10.0)
     , m_verticalPadding(5.0)
+    , m_pendula(0)
+    , m_rows(0)
 {
 }
 
@@ -46,7 +54,7 @@ QRectF DoublePendulumInfoItem::boundingRect() const
 
     return QRectF(0.0, 0.0,
                   2 * m_horizontalPadding + tw,
-                  2 * m_verticalPadding + 20.0 + m_pendula.count() * (m_iconSize + 3.0));
+                  2 * m_verticalPadding + 20.0 + m_rows * (m_iconSize + 3.0));
 }
 
 void DoublePendulumInfoItem::paint(QPainter *painter,
@@ -84,15 +92,24 @@ void DoublePendulumInfoItem::paint(QPainter *painter,
     QTextOption to;
     to.setTabStop(QApplication::fontMetrics().width("-00.0J "));
 
+    if (!m_pendula)
+    {
+        return;
+    }
+
     // Draw the individual pendulum energy
-    foreach (DoublePendulumItem *item, m_pendula)
+    const int listed = qMin(m_pendula->count(), MAX_LISTED);
+
+    for (int i = 0; i < listed; ++i)
     {
+        DoublePendulumItem *item = m_pendula->at(i);
+
         // First draw the icon
         item->drawIcon(painter, QRect(0, 0, m_iconSize, m_iconSize));
 
         // Next comes the text
-        const double currE= item->pendulum()->energy();
-        const double initE = item->pendulum()->initEnergy();
+        const double currE= item->energy();
+        const double initE = item->initEnergy();
         const double change = (currE - initE) / initE * 100.0;
 
         QString text = QString("%1J\t(%2%3%)").arg(currE, 2, 'f', 1)
@@ -108,17 +125,26 @@ void DoublePendulumInfoItem::paint(QPainter *painter,
         // Finally translate down a few units
         painter->translate(0.0, m_iconSize + 3.0);
     }
+
+    if (m_pendula->count() > listed)
+    {
+        painter->drawText(QRectF(0.0, 0.0, r.width(), r.height()),
+                          QString("... and %1 more").arg(m_pendula->count() - listed));
+    }
 }
 
-void DoublePendulumInfoItem::setPendula(const QMap<QString, DoublePendulumItem *> &pendula)
+void DoublePendulumInfoItem::setPendula(const PendulumRegistry *pendula)
 {
-    const int count = m_pendula.count();
-
     m_pendula = pendula;
 
-    // If the number of pendulums has changed then so has our bounding rect
-    if (count != m_pendula.count())
+    // One row per pendulum up to a limit, then one for the rest
+    const int rows = (m_pendula->count() > MAX_LISTED) ? MAX_LISTED + 1
+                                                       : m_pendula->count();
+
+    // If the number of rows has changed then so has our bounding rect
+    if (rows != m_rows)
     {
         prepareGeometryChange();
+        m_rows = rows;
     }
 }
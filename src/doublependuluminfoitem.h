@@ -23,6 +23,7 @@
 #include <QGraphicsItem>
 
 #include "doublependulumitem.h"
+#include "pendulumregistry.h"
 
 class DoublePendulumInfoItem : public QGraphicsItem
 {
@@ -30,7 +31,11 @@ public:
     DoublePendulumInfoItem();
     ~DoublePendulumInfoItem();
 
-    void setPendula(const QMap<QString, DoublePendulumItem *> &pendula);
+    /**
+     * Sets the pendula whose energies are shown; the registry is not copied
+     * and so must outlive the item.
+     */
+    void setPendula(const PendulumRegistry *pendula);
 
     QRectF boundingRect() const;
 
@@ -42,7 +47,12 @@ private:
     const double m_horizontalPadding;
     const double m_verticalPadding;
 
-    QMap<QString, DoublePendulumItem *> m_pendula;
+    const PendulumRegistry *m_pendula;
+
+    /**
+     * Number of rows our bounding rect was last computed for.
+     */
+    int m_rows;
 };
 
 #endif // DOUBLEPENDULUMINFOITEM_H
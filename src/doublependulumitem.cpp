@@ -18,6 +18,9 @@
 */
 
 #include "doublependulumitem.h"
+#include "doublependulumfactory.h"
+#include "fasttrig.h"
+#include "timewarpbuffer.h"
 
 #include <QtDebug>
 #include <QPainter>
@@ -26,6 +29,13 @@
 
 DoublePendulumItem::DoublePendulumItem()
     : m_pendulum(0)
+    , m_arena(0)
+    , m_buffer(0)
+    , m_bufferIndex(-1)
+    , m_autoTune(false)
+    , m_energyBudget(1e-3)
+    , m_horizon(600.0)
+    , m_sectionListener(0)
 {
 }
 
@@ -37,23 +47,58 @@ DoublePendulumItem::~DoublePendulumItem()
     }
 }
 
-void DoublePendulumItem::start()
+void DoublePendulumItem::start(DoublePendulumArena *arena,
+                               TimeWarpBuffer *buffer)
 {
     // Create the actual pendulum object
-    if (m_solver == "Euler")
-    {
-        m_pendulum = new DoublePendulumEuler(upper(), lower(), m_dt, m_g);
-    }
-    else if (m_solver == "Runge Kutta (RK4)")
+    m_pendulum = DoublePendulumFactory::create(m_solver, upper(), lower(),
+                                               m_dt, m_g, arena);
+    m_arena = arena;
+    m_buffer = 0;
+
+    if (m_pendulum)
     {
-        m_pendulum = new DoublePendulumRK4(upper(), lower(), m_dt, m_g);
+        if (buffer)
+        {
+            m_buffer = buffer;
+            m_bufferIndex = buffer->addPendulum(m_pendulum);
+
+            m_pendulum->setSectionListener(buffer->relay(m_sectionListener));
+
+            for (int i = 0; i < m_observers.size(); ++i)
+            {
+                m_pendulum->addObserver(buffer->relay(m_observers[i].first),
+                                        m_observers[i].second);
+            }
+        }
+        else
+        {
+            m_pendulum->setSectionListener(m_sectionListener);
+
+            for (int i = 0; i < m_observers.size(); ++i)
+            {
+                m_pendulum->addObserver(m_observers[i].first,
+                                        m_observers[i].second);
+            }
+        }
+
+        m_state.y[0] = m_pendulum->theta1();
+        m_state.y[1] = m_pendulum->omega1();
+        m_state.y[2] = m_pendulum->theta2();
+        m_state.y[3] = m_pendulum->omega2();
     }
 }
 
 void DoublePendulumItem::stop()
 {
-    delete m_pendulum;
+    if (!m_arena)
+    {
+        delete m_pendulum;
+    }
+
     m_pendulum = 0;
+    m_arena = 0;
+    m_buffer = 0;
 }
 
 const DoublePendulum *DoublePendulumItem::pendulum()
@@ -61,6 +106,16 @@ const DoublePendulum *DoublePendulumItem::pendulum()
     return m_pendulum;
 }
 
+double DoublePendulumItem::energy()
+{
+    return m_pendulum->energy(m_state.y);
+}
+
+double DoublePendulumItem::initEnergy()
+{
+    return m_pendulum->initEnergy();
+}
+
 Pendulum& DoublePendulumItem::upper()
 {
     return m_upper;
@@ -101,6 +156,36 @@ void DoublePendulumItem::setG(double g)
     m_g = g;
 }
 
+bool DoublePendulumItem::autoTune()
+{
+    return m_autoTune;
+}
+
+void DoublePendulumItem::setAutoTune(bool autoTune)
+{
+    m_autoTune = autoTune;
+}
+
+double DoublePendulumItem::energyBudget()
+{
+    return m_energyBudget;
+}
+
+void DoublePendulumItem::setEnergyBudget(double budget)
+{
+    m_energyBudget = budget;
+}
+
+double DoublePendulumItem::horizon()
+{
+    return m_horizon;
+}
+
+void DoublePendulumItem::setHorizon(double horizon)
+{
+    m_horizon = horizon;
+}
+
 QColor DoublePendulumItem::upperColour()
 {
     return m_upperColour;
@@ -131,6 +216,22 @@ void DoublePendulumItem::setOpacity(int opacity)
     m_opacity = opacity;
 }
 
+void DoublePendulumItem::setSectionListener(PoincareListener *listener)
+{
+    m_sectionListener = listener;
+}
+
+void DoublePendulumItem::addObserver(DoublePendulumObserver *observer,
+                                     double interval)
+{
+    m_observers.append(qMakePair(observer, interval));
+}
+
+void DoublePendulumItem::clearObservers()
+{
+    m_observers.clear();
+}
+
 QRectF DoublePendulumItem::boundingRect() const
 {
     if (!m_pendulum)
@@ -160,23 +261,27 @@ void DoublePendulumItem::paint(QPainter *painter,
     const double bobSize = 0.2 * m_scale;
     const double lineSize = 0.04 * m_scale;
 
+    // Drawing only needs screen precision, so use the fast trig kernels
+    const double theta[2] = { m_state.y[0], m_state.y[2] };
+    double s[2], c[2];
+
+    FastTrig::sinCos(theta, s, c, 2, FastTrig::Fast);
+
     // Scaled location of the upper bob
-    const QPointF upperBob = QPointF(m_pendulum->l1() * sin(m_pendulum->theta1()),
-                                     m_pendulum->l1() * cos(m_pendulum->theta1()))
+    const QPointF upperBob = QPointF(m_pendulum->l1() * s[0],
+                                     m_pendulum->l1() * c[0])
                            * m_scale;
 
     // Scaled location of the lower bob
-    const QPointF lowerBob = QPointF(m_pendulum->l2() * sin(m_pendulum->theta2()),
-                                     m_pendulum->l2() * cos(m_pendulum->theta2()))
+    const QPointF lowerBob = QPointF(m_pendulum->l2() * s[1],
+                                     m_pendulum->l2() * c[1])
                            * m_scale + upperBob;
 
     // Amount of material to omit from the end of the first connecting line
-    const QPointF upperCut = QPointF(sin(m_pendulum->theta1()),
-                                     cos(m_pendulum->theta1())) * bobSize;
+    const QPointF upperCut = QPointF(s[0], c[0]) * bobSize;
 
     // Amount of material to omit from both ends of the second line
-    const QPointF lowerCut = QPointF(sin(m_pendulum->theta2()),
-                                     cos(m_pendulum->theta2())) * bobSize;
+    const QPointF lowerCut = QPointF(s[1], c[1]) * bobSize;
 
     painter->setOpacity(m_opacity / 100.0);
 
@@ -231,15 +336,18 @@ void DoublePendulumItem::updateScale(double newScale)
     prepareGeometryChange();
 }
 
-void DoublePendulumItem::updateTime(double newTime)
+void DoublePendulumItem::updateState()
 {
-    // Actual time (s as opposed to ms)
-    double actualTime = newTime / 1000.0;
-
-    // Update the pendulum
-    if (actualTime > m_pendulum->time())
+    if (m_buffer)
+    {
+        m_state = m_buffer->state(m_bufferIndex);
+    }
+    else
     {
-        m_pendulum->update(actualTime);
+        m_state.y[0] = m_pendulum->theta1();
+        m_state.y[1] = m_pendulum->omega1();
+        m_state.y[2] = m_pendulum->theta2();
+        m_state.y[3] = m_pendulum->omega2();
     }
 
     prepareGeometryChange();
@@ -22,10 +22,13 @@
 
 #include <QColor>
 #include <QGraphicsItem>
+#include <QList>
+#include <QPair>
 
 #include "doublependulum.h"
-#include "doublependulumeuler.h"
-#include "doublependulumrk4.h"
+
+class DoublePendulumArena;
+class TimeWarpBuffer;
 
 class DoublePendulumItem : public QGraphicsItem
 {
@@ -33,7 +36,13 @@ public:
     DoublePendulumItem();
     ~DoublePendulumItem();
 
-    void start();
+    /**
+     * Creates the pendulum, in arena if one is given; stop() leaves the
+     * destruction of pendula in an arena to the arena.  If a buffer is given
+     * the pendulum is added to it, with the observers and section listener
+     * attached through its relays, and the item is drawn from its frames.
+     */
+    void start(DoublePendulumArena *arena = 0, TimeWarpBuffer *buffer = 0);
     void stop();
 
     Pendulum& upper();
@@ -41,6 +50,12 @@ public:
 
     const DoublePendulum *pendulum();
 
+    /**
+     * Energy of the state being displayed, and the initial energy.
+     */
+    double energy();
+    double initEnergy();
+
     QString solver();
     void setSolver(const QString& solver);
 
@@ -50,6 +65,20 @@ public:
     double g();
     void setG(double g);
 
+    /**
+     * Whether the solver and dt are to be chosen by DtTuner when the
+     * simulation starts, to keep the energy drift over horizon seconds
+     * within the (relative) energy budget.
+     */
+    bool autoTune();
+    void setAutoTune(bool autoTune);
+
+    double energyBudget();
+    void setEnergyBudget(double budget);
+
+    double horizon();
+    void setHorizon(double horizon);
+
     QColor upperColour();
     void setUpperColour(const QColor& colour);
 
@@ -59,6 +88,19 @@ public:
     int opacity();
     void setOpacity(int opacity);
 
+    /**
+     * Listener for Poincaré section crossings, attached to the pendulum
+     * whenever the simulation is started.
+     */
+    void setSectionListener(PoincareListener *listener);
+
+    /**
+     * Observers to be passed the state every interval seconds, attached to
+     * the pendulum whenever the simulation is started.
+     */
+    void addObserver(DoublePendulumObserver *observer, double interval);
+    void clearObservers();
+
     QRectF boundingRect() const;
 
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
@@ -67,15 +109,34 @@ public:
     void drawIcon(QPainter *painter, const QRect &rect);
 
     void updateScale(double newScale);
-    void updateTime(double newTime);
+
+    /**
+     * Picks up the latest state from the buffer the pendulum was started
+     * with, or from the pendulum itself if there is none.
+     */
+    void updateState();
 
 private:
     DoublePendulum *m_pendulum;
+    DoublePendulumArena *m_arena;
+
+    TimeWarpBuffer *m_buffer;
+    int m_bufferIndex;
+
+    /**
+     * State being displayed; the pendulum itself may be being stepped on
+     * another thread.
+     */
+    DoublePendulumState m_state;
 
     QString m_solver;
     double m_dt;
     double m_g;
 
+    bool m_autoTune;
+    double m_energyBudget;
+    double m_horizon;
+
     double m_scale;
 
     /**
@@ -86,6 +147,10 @@ private:
     QColor m_upperColour;
     QColor m_lowerColour;
     int m_opacity;
+
+    PoincareListener *m_sectionListener;
+
+    QList<QPair<DoublePendulumObserver *, double> > m_observers;
 };
 
 #endif // DOUBLEPENDULUMITEM_H
@@ -0,0 +1,288 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumlyapunov.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+DoublePendulumLyapunov::DoublePendulumLyapunov(const Pendulum& upper,
+                                               const Pendulum& lower,
+                                               double dt, double g,
+                                               int orthoInterval) :
+    DoublePendulum(upper, lower, dt, g),
+    m_orthoInterval(orthoInterval),
+    m_stepsSinceOrtho(0),
+    m_orthoTime(0.0),
+    m_onSurface(false)
+{
+    // Start with the tangent vectors aligned with the coordinate axes
+    for (int j = 0; j < NUM_EQNS; ++j)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_w[j][i] = (i == j) ? 1.0 : 0.0;
+        }
+
+        m_logSum[j] = 0.0;
+    }
+}
+
+const char *DoublePendulumLyapunov::solverMethod()
+{
+    return "Runge Kutta (RK4) + variational";
+}
+
+void DoublePendulumLyapunov::exponents(double *lambda) const
+{
+    for (int j = 0; j < NUM_EQNS; ++j)
+    {
+        lambda[j] = (m_orthoTime > 0.0) ? m_logSum[j] / m_orthoTime : 0.0;
+    }
+
+    // Gram-Schmidt almost always yields them in order, but not necessarily
+    std::sort(lambda, lambda + NUM_EQNS, std::greater<double>());
+}
+
+void DoublePendulumLyapunov::solveODEs(const double *yin, double *yout)
+{
+    double yt[NUM_EQNS], k[4][NUM_EQNS];
+    double jac[NUM_EQNS][NUM_EQNS];
+    double wt[NUM_EQNS][NUM_EQNS], kw[4][NUM_EQNS][NUM_EQNS];
+
+    // Coefficients for the intermediate RK4 stages
+    static const double c[3] = { 0.5, 0.5, 1.0 };
+
+    // Once projecting, the vectors must start out on the surface, else the
+    // first projection would count as a contraction
+    if (energyProjection() && !m_onSurface)
+    {
+        surfaceBasis(yin);
+    }
+
+    m_onSurface = energyProjection();
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yt[i] = yin[i];
+    }
+
+    for (int j = 0; j < NUM_EQNS; ++j)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            wt[j][i] = m_w[j][i];
+        }
+    }
+
+    for (int s = 0; s < 4; ++s)
+    {
+        // State and Jacobian at this stage
+        derivs(yt, k[s]);
+        jacobian(yt, jac);
+
+        // Tangent dynamics, J·w, for each of the vectors
+        for (int j = 0; j < NUM_EQNS; ++j)
+        {
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                double sum = 0.0;
+                for (int l = 0; l < NUM_EQNS; ++l)
+                {
+                    sum += jac[i][l] * wt[j][l];
+                }
+
+                kw[s][j][i] = sum;
+            }
+        }
+
+        // Prepare the input to the next stage
+        if (s < 3)
+        {
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                yt[i] = yin[i] + c[s] * m_dt * k[s][i];
+            }
+
+            for (int j = 0; j < NUM_EQNS; ++j)
+            {
+                for (int i = 0; i < NUM_EQNS; ++i)
+                {
+                    wt[j][i] = m_w[j][i] + c[s] * m_dt * kw[s][j][i];
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        yout[i] = yin[i] + m_dt / 6.0 * (k[0][i] + 2.0*k[1][i] + 2.0*k[2][i] + k[3][i]);
+    }
+
+    for (int j = 0; j < NUM_EQNS; ++j)
+    {
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_w[j][i] += m_dt / 6.0 * (kw[0][j][i] + 2.0*kw[1][j][i]
+                                     + 2.0*kw[2][j][i] + kw[3][j][i]);
+        }
+    }
+
+    // The projection moves the state along ∇E; its linearisation does the
+    // same to the tangent vectors, keeping all but the last on the surface
+    if (energyProjection())
+    {
+        projectTangents(yout);
+    }
+
+    if (++m_stepsSinceOrtho == m_orthoInterval)
+    {
+        orthonormalise();
+    }
+}
+
+void DoublePendulumLyapunov::projectTangents(const double *y)
+{
+    double grad[NUM_EQNS];
+    energyGradient(y, grad);
+
+    double norm2 = 0.0;
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        norm2 += grad[i] * grad[i];
+    }
+
+    // At the equilibria there is no surface to project onto
+    if (norm2 == 0.0)
+    {
+        return;
+    }
+
+    for (int j = 0; j < NUM_EQNS - 1; ++j)
+    {
+        double dot = 0.0;
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            dot += grad[i] * m_w[j][i];
+        }
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_w[j][i] -= dot / norm2 * grad[i];
+        }
+    }
+}
+
+void DoublePendulumLyapunov::surfaceBasis(const double *y)
+{
+    double grad[NUM_EQNS];
+    energyGradient(y, grad);
+
+    double norm = 0.0;
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        norm += grad[i] * grad[i];
+    }
+    norm = sqrt(norm);
+
+    if (norm == 0.0)
+    {
+        return;
+    }
+
+    // Project all the axes bar the one closest to the normal, as otherwise
+    // some of the projections may coincide (at rest ∇E lies in the θ plane)
+    int normalAxis = 0;
+    for (int i = 1; i < NUM_EQNS; ++i)
+    {
+        if (fabs(grad[i]) > fabs(grad[normalAxis]))
+        {
+            normalAxis = i;
+        }
+    }
+
+    for (int j = 0, axis = 0; j < NUM_EQNS - 1; ++j, ++axis)
+    {
+        if (axis == normalAxis)
+        {
+            ++axis;
+        }
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_w[j][i] = (i == axis) ? 1.0 : 0.0;
+        }
+    }
+
+    projectTangents(y);
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        m_w[NUM_EQNS - 1][i] = grad[i] / norm;
+    }
+
+    // A change of basis rather than any stretching by the flow
+    orthonormalise(false);
+}
+
+void DoublePendulumLyapunov::orthonormalise(bool accumulate)
+{
+    for (int j = 0; j < NUM_EQNS; ++j)
+    {
+        // Remove the components along the previously processed vectors
+        for (int k = 0; k < j; ++k)
+        {
+            double dot = 0.0;
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                dot += m_w[j][i] * m_w[k][i];
+            }
+
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                m_w[j][i] -= dot * m_w[k][i];
+            }
+        }
+
+        // Normalise, the norm being the diagonal entry Rjj
+        double norm = 0.0;
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            norm += m_w[j][i] * m_w[j][i];
+        }
+        norm = sqrt(norm);
+
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            m_w[j][i] /= norm;
+        }
+
+        if (accumulate)
+        {
+            m_logSum[j] += log(norm);
+        }
+    }
+
+    if (accumulate)
+    {
+        m_orthoTime += m_stepsSinceOrtho * m_dt;
+        m_stepsSinceOrtho = 0;
+    }
+}
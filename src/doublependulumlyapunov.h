@@ -0,0 +1,107 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMLYAPUNOV_H
+#define DOUBLEPENDULUMLYAPUNOV_H
+
+#include "doublependulum.h"
+
+/**
+ * Fourth-order Runge Kutta solver which, alongside the state, integrates the
+ * variational equations dW/dt = J(y)·W for a set of NUM_EQNS tangent vectors.
+ *
+ * Every orthoInterval steps the tangent vectors are re-orthonormalised using
+ * a QR decomposition (modified Gram-Schmidt); the logarithms of the diagonal
+ * of R accumulate into the full Lyapunov spectrum of the trajectory.
+ *
+ * With energy projection enabled the first NUM_EQNS - 1 tangent vectors are
+ * projected onto the energy surface after every step, as the state is.  They
+ * start out as a basis of the surface's tangent space and the last vector as
+ * its normal, whose exponent measures the (vanishing) growth across it.
+ */
+class DoublePendulumLyapunov : public DoublePendulum
+{
+public:
+    DoublePendulumLyapunov(const Pendulum& upper, const Pendulum& lower,
+                           double dt=0.005, double g=9.81,
+                           int orthoInterval=10);
+
+    const char *solverMethod();
+
+    /**
+     * Number of exponents in the spectrum.
+     */
+    static int numExponents()
+    {
+        return NUM_EQNS;
+    }
+
+    /**
+     * Writes the current estimate of the Lyapunov spectrum (in s^-1) into
+     * lambda, which must have room for numExponents() values.  Exponents are
+     * ordered from largest to smallest.
+     */
+    void exponents(double *lambda) const;
+
+protected:
+    void solveODEs(const double *yin, double *yout);
+
+    /**
+     * Re-orthonormalises m_w, accumulating the stretching factors unless
+     * accumulate is false.
+     */
+    void orthonormalise(bool accumulate = true);
+
+    /**
+     * Removes the ∇E component, evaluated at y, from all but the last of
+     * the tangent vectors.
+     */
+    void projectTangents(const double *y);
+
+    /**
+     * Replaces m_w with an orthonormal basis whose last vector is the unit
+     * normal to the energy surface at y, the rest spanning its tangent space.
+     */
+    void surfaceBasis(const double *y);
+
+    /**
+     * Tangent vectors, m_w[j] being the j-th vector.
+     */
+    double m_w[NUM_EQNS][NUM_EQNS];
+
+    /**
+     * Running sums of log |Rjj| from each orthonormalisation.
+     */
+    double m_logSum[NUM_EQNS];
+
+    const int m_orthoInterval;
+    int m_stepsSinceOrtho;
+
+    /**
+     * Integration time covered by m_logSum.
+     */
+    double m_orthoTime;
+
+    /**
+     * If m_w is adapted to the energy surface, as projection requires.
+     */
+    bool m_onSurface;
+};
+
+#endif // DOUBLEPENDULUMLYAPUNOV_H
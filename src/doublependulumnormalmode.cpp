@@ -0,0 +1,268 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumnormalmode.h"
+
+#include <cmath>
+#include <cassert>
+
+DoublePendulumNormalMode::DoublePendulumNormalMode(const Pendulum& upper,
+                                                   const Pendulum& lower,
+                                                   double dt, double g,
+                                                   double tol) :
+    DoublePendulumRK4(upper, lower, dt, g),
+    m_tol(tol),
+    m_normalModes(false),
+    m_t0(0.0),
+    m_entryEnergy(0.0),
+    m_freqError(0.0),
+    m_tEnd(0.0),
+    m_phaseError(0.0)
+{
+    const double M = m_m1 + m_m2;
+
+    // Linearised mass and (diagonal) stiffness matrices
+    m_mass[0][0] = M * m_l1 * m_l1;
+    m_mass[0][1] = m_mass[1][0] = m_m2 * m_l1 * m_l2;
+    m_mass[1][1] = m_m2 * m_l2 * m_l2;
+
+    const double k1 = M * m_g * m_l1;
+    const double k2 = m_m2 * m_g * m_l2;
+
+    // det(K - λM) = aλ² + bλ + c = 0 gives the squared frequencies
+    const double a = m_mass[0][0]*m_mass[1][1] - m_mass[0][1]*m_mass[0][1];
+    const double b = -(k1*m_mass[1][1] + k2*m_mass[0][0]);
+    const double c = k1 * k2;
+    const double q = -0.5 * (b - sqrt(b*b - 4.0*a*c));
+
+    // Written so as to avoid cancellation in the smaller root
+    const double lambda[2] = { c / q, q / a };
+
+    for (int k = 0; k < 2; ++k)
+    {
+        m_freq[k] = sqrt(lambda[k]);
+
+        // From the first row of (K - λM)·v = 0
+        double v[2] = { lambda[k] * m_mass[0][1],
+                        k1 - lambda[k] * m_mass[0][0] };
+
+        // Normalise such that vᵀMv = 1
+        const double vMv = v[0]*(m_mass[0][0]*v[0] + m_mass[0][1]*v[1])
+                         + v[1]*(m_mass[1][0]*v[0] + m_mass[1][1]*v[1]);
+
+        m_modes[k][0] = v[0] / sqrt(vMv);
+        m_modes[k][1] = v[1] / sqrt(vMv);
+    }
+
+    m_restEnergy = -M * m_g * m_l1 - m_m2 * m_g * m_l2;
+
+    m_eta[0] = m_eta[1] = 0.0;
+    m_etaDot[0] = m_etaDot[1] = 0.0;
+    m_offset[0] = m_offset[1] = 0.0;
+}
+
+const char *DoublePendulumNormalMode::solverMethod()
+{
+    return "Runge Kutta (RK4) + normal modes";
+}
+
+void DoublePendulumNormalMode::update(double newTime)
+{
+    assert(newTime >= m_time);
+
+    if (m_stopped)
+    {
+        return;
+    }
+
+    if (!m_normalModes && !enterNormalModes())
+    {
+        DoublePendulumRK4::update(newTime);
+        return;
+    }
+
+    // With events registered the interval is split up so that no more
+    // than one crossing of any of them can fall in a single piece
+    const double twoPi = 6.28318530717958647692;
+    const double hMax = m_numEvents ? 0.0625 * twoPi / m_freq[1]
+                                    : newTime - m_time;
+
+    // The stretch ends early should the phase error budget run out
+    const double tStop = (m_tEnd < newTime) ? m_tEnd : newTime;
+
+    while (m_time < tStop)
+    {
+        const double yPrev[NUM_EQNS] = { m_state->y[THETA_1],
+                                         m_state->y[OMEGA_1],
+                                         m_state->y[THETA_2],
+                                         m_state->y[OMEGA_2] };
+        const double tPrev = m_time;
+        const double t = (tStop - m_time > hMax) ? m_time + hMax : tStop;
+        double y[NUM_EQNS];
+
+        evaluate(t, y);
+
+        m_state->y[THETA_1] = y[THETA_1];
+        m_state->y[OMEGA_1] = y[OMEGA_1];
+        m_state->y[THETA_2] = y[THETA_2];
+        m_state->y[OMEGA_2] = y[OMEGA_2];
+
+        m_time = t;
+
+        stepTaken(tPrev, yPrev, t, y);
+        checkEvents(t, y);
+
+        if (m_stopped)
+        {
+            return;
+        }
+    }
+
+    // Check that the linearisation is still a faithful one; as the
+    // nonlinear terms are O(θ²) relative to the linear ones so is the
+    // drift in energy
+    const double drift = fabs(energy() - m_entryEnergy)
+                       / (m_entryEnergy - m_restEnergy);
+
+    if (drift > m_tol || m_time >= m_tEnd)
+    {
+        m_phaseError = phaseError();
+        m_normalModes = false;
+    }
+
+    // Finish off with RK4 should the stretch have been cut short
+    if (m_time < newTime)
+    {
+        DoublePendulumRK4::update(newTime);
+    }
+}
+
+double DoublePendulumNormalMode::phaseError() const
+{
+    return m_normalModes ? m_phaseError
+                         + m_freqError * m_freq[1] * (m_time - m_t0)
+                         : m_phaseError;
+}
+
+void DoublePendulumNormalMode::denseOutput(double t, double *yout)
+{
+    if (m_normalModes)
+    {
+        evaluate(t, yout);
+    }
+    else
+    {
+        DoublePendulumRK4::denseOutput(t, yout);
+    }
+}
+
+bool DoublePendulumNormalMode::enterNormalModes()
+{
+    const double twoPi = 6.28318530717958647692;
+
+    // Linearise about the nearest downward-hanging configuration
+    const double offset[2] = { twoPi * floor(m_state->y[THETA_1] / twoPi + 0.5),
+                               twoPi * floor(m_state->y[THETA_2] / twoPi + 0.5) };
+    const double q[2] = { m_state->y[THETA_1] - offset[0],
+                          m_state->y[THETA_2] - offset[1] };
+    const double qDot[2] = { m_state->y[OMEGA_1], m_state->y[OMEGA_2] };
+
+    double eta[2], etaDot[2];
+    double bound[3] = { 0.0, 0.0, 0.0 };
+
+    for (int k = 0; k < 2; ++k)
+    {
+        // Modal coordinates, η = vᵀMq
+        const double *v = m_modes[k];
+        const double Mv[2] = { m_mass[0][0]*v[0] + m_mass[0][1]*v[1],
+                               m_mass[1][0]*v[0] + m_mass[1][1]*v[1] };
+
+        eta[k] = Mv[0]*q[0] + Mv[1]*q[1];
+        etaDot[k] = Mv[0]*qDot[0] + Mv[1]*qDot[1];
+
+        const double amp = sqrt(eta[k]*eta[k] + etaDot[k]*etaDot[k]
+                                              / (m_freq[k]*m_freq[k]));
+
+        // Bounds on the largest θ1, θ2 and θ1 - θ2 reached over the motion
+        bound[0] += fabs(v[0]) * amp;
+        bound[1] += fabs(v[1]) * amp;
+        bound[2] += fabs(v[0] - v[1]) * amp;
+    }
+
+    double maxAmp = bound[0];
+
+    for (int i = 1; i < 3; ++i)
+    {
+        maxAmp = (bound[i] > maxAmp) ? bound[i] : maxAmp;
+    }
+
+    // The terms dropped from sin θ, cos(θ1 - θ2) and those in ω² are all
+    // within a factor of ½θ² of the retained ones; require the estimate to
+    // be well inside the tolerance so as to not flip back and forth
+    if (0.5 * maxAmp * maxAmp > 0.5 * m_tol || m_phaseError >= m_tol)
+    {
+        return false;
+    }
+
+    m_normalModes = true;
+    m_t0 = m_time;
+
+    // The frequencies are out by up to the relative error in the forces,
+    // so the phase of the fast mode drifts the quickest
+    m_freqError = 0.5 * maxAmp * maxAmp;
+    m_tEnd = (m_freqError > 0.0)
+           ? m_t0 + (m_tol - m_phaseError) / (m_freqError * m_freq[1])
+           : HUGE_VAL;
+
+    for (int k = 0; k < 2; ++k)
+    {
+        m_eta[k] = eta[k];
+        m_etaDot[k] = etaDot[k];
+        m_offset[k] = offset[k];
+    }
+
+    m_entryEnergy = energy();
+
+    return true;
+}
+
+void DoublePendulumNormalMode::evaluate(double t, double *yout) const
+{
+    const double tau = t - m_t0;
+
+    yout[THETA_1] = m_offset[0];
+    yout[OMEGA_1] = 0.0;
+    yout[THETA_2] = m_offset[1];
+    yout[OMEGA_2] = 0.0;
+
+    for (int k = 0; k < 2; ++k)
+    {
+        const double w = m_freq[k];
+        const double s = sin(w * tau), c = cos(w * tau);
+
+        // η(τ) = η0 cos ωτ + (η'0/ω) sin ωτ
+        const double eta = m_eta[k]*c + m_etaDot[k]/w * s;
+        const double etaDot = m_etaDot[k]*c - m_eta[k]*w * s;
+
+        yout[THETA_1] += m_modes[k][0] * eta;
+        yout[OMEGA_1] += m_modes[k][0] * etaDot;
+        yout[THETA_2] += m_modes[k][1] * eta;
+        yout[OMEGA_2] += m_modes[k][1] * etaDot;
+    }
+}
@@ -0,0 +1,142 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMNORMALMODE_H
+#define DOUBLEPENDULUMNORMALMODE_H
+
+#include "doublependulumrk4.h"
+
+/**
+ * RK4 with a closed-form fast path for small-amplitude motion.
+ *
+ * For small angles the equations of motion reduce to M·q'' + K·q = 0 with
+ * q = (θ1, θ2), whose solution is a superposition of two normal modes which
+ * can be evaluated directly at any time.  Whenever the amplitude of the
+ * motion is small enough for the neglected terms to be below the tolerance
+ * this is used instead of stepping; should the nonlinear energy of the
+ * closed-form solution drift from its starting value by more than the
+ * tolerance the solver drops back to RK4.
+ *
+ * The tolerance bounds the relative error in the restoring forces, and
+ * hence in the frequencies of the motion, so the phase error of the closed
+ * form grows as ε·ω·t for a relative frequency error ε ≤ ½tol, something
+ * the energy check can not see.  Each closed-form stretch is therefore cut
+ * short once the phase error it is estimated to have accumulated, along
+ * with that of any earlier stretches, reaches tol radians, after which the
+ * solver keeps to RK4.
+ */
+class DoublePendulumNormalMode : public DoublePendulumRK4
+{
+public:
+    DoublePendulumNormalMode(const Pendulum& upper, const Pendulum& lower,
+                             double dt=0.005, double g=9.81, double tol=1e-4);
+
+    void update(double newTime);
+
+    void denseOutput(double t, double *yout);
+
+    const char *solverMethod();
+
+    /**
+     * Returns true if the closed-form solution is currently in use.
+     */
+    bool usingNormalModes() const
+    {
+        return m_normalModes;
+    }
+
+    /**
+     * Returns the angular frequency (in rad/s) of the slow (0) or fast (1)
+     * normal mode.
+     */
+    double frequency(int mode) const
+    {
+        return m_freq[mode];
+    }
+
+    double tolerance() const
+    {
+        return m_tol;
+    }
+
+    /**
+     * Estimate of the phase error (in rad) accumulated in the closed-form
+     * stretches so far.
+     */
+    double phaseError() const;
+
+private:
+    /**
+     * Projects the current state onto the normal modes and, if the motion
+     * is small enough, switches over to the closed-form solution.
+     */
+    bool enterNormalModes();
+
+    /**
+     * Evaluates the closed-form solution at time t.
+     */
+    void evaluate(double t, double *yout) const;
+
+    const double m_tol;
+
+    /**
+     * M-orthonormal mode shapes, m_modes[k] = (θ1, θ2) for mode k, and
+     * their angular frequencies.
+     */
+    double m_modes[2][2];
+    double m_freq[2];
+
+    /**
+     * Mass matrix of the linearised system.
+     */
+    double m_mass[2][2];
+
+    /**
+     * Rest energy, with both bobs hanging straight down.
+     */
+    double m_restEnergy;
+
+    bool m_normalModes;
+
+    /**
+     * Time at which the closed-form solution was started along with the
+     * modal displacements and velocities at that time.  The angles are
+     * taken relative to the nearest multiples of 2π, m_offset.
+     */
+    double m_t0;
+    double m_eta[2];
+    double m_etaDot[2];
+    double m_offset[2];
+
+    /**
+     * Nonlinear energy at the start of the closed-form solution.
+     */
+    double m_entryEnergy;
+
+    /**
+     * Estimated relative frequency error of the current closed-form
+     * stretch, the time at which its share of the phase error budget runs
+     * out, and the phase error of the stretches before it.
+     */
+    double m_freqError;
+    double m_tEnd;
+    double m_phaseError;
+};
+
+#endif // DOUBLEPENDULUMNORMALMODE_H
@@ -0,0 +1,231 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "doublependulumtaylor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /*
+     * Jet arithmetic.  Each function computes the k-th coefficient of the
+     * result given coefficients 0..k of the arguments (and 0..k-1 of the
+     * result itself where the recurrence needs them).
+     */
+    inline double mulK(const double *a, const double *b, int k)
+    {
+        double sum = 0.0;
+        for (int j = 0; j <= k; ++j)
+        {
+            sum += a[j] * b[k - j];
+        }
+
+        return sum;
+    }
+
+    inline void divK(const double *a, const double *b, double *q, int k)
+    {
+        double sum = a[k];
+        for (int j = 1; j <= k; ++j)
+        {
+            sum -= b[j] * q[k - j];
+        }
+
+        q[k] = sum / b[0];
+    }
+
+    // From s' = c·u' and c' = -s·u'
+    inline void sinCosK(const double *u, double *s, double *c, int k)
+    {
+        if (k == 0)
+        {
+            s[0] = sin(u[0]);
+            c[0] = cos(u[0]);
+            return;
+        }
+
+        double ss = 0.0, cs = 0.0;
+        for (int j = 1; j <= k; ++j)
+        {
+            ss += j * u[j] * c[k - j];
+            cs += j * u[j] * s[k - j];
+        }
+
+        s[k] = ss / k;
+        c[k] = -cs / k;
+    }
+}
+
+DoublePendulumTaylor::DoublePendulumTaylor(const Pendulum& upper,
+                                           const Pendulum& lower,
+                                           double dt, double g, double tol) :
+    DoublePendulumAdaptive(upper, lower, dt, g, tol),
+    m_order(std::min(int(MAX_ORDER),
+                     std::max(4, int(ceil(-0.5 * log(tol) + 1.0)))))
+{
+}
+
+const char *DoublePendulumTaylor::solverMethod()
+{
+    return "Taylor series";
+}
+
+void DoublePendulumTaylor::computeCoefficients(const double *yin)
+{
+    double *th1 = m_coeffs[THETA_1], *w1 = m_coeffs[OMEGA_1];
+    double *th2 = m_coeffs[THETA_2], *w2 = m_coeffs[OMEGA_2];
+
+    // Jets of the intermediate quantities in derivs()
+    double delta[MAX_ORDER + 1], s[MAX_ORDER + 1], c[MAX_ORDER + 1];
+    double s1[MAX_ORDER + 1], c1[MAX_ORDER + 1];
+    double s2[MAX_ORDER + 1], c2[MAX_ORDER + 1];
+    double ww1[MAX_ORDER + 1], ww2[MAX_ORDER + 1];
+    double sc[MAX_ORDER + 1], cc[MAX_ORDER + 1];
+    double den1[MAX_ORDER + 1], den2[MAX_ORDER + 1];
+    double n1[MAX_ORDER + 1], n2[MAX_ORDER + 1];
+    double a1[MAX_ORDER + 1], a2[MAX_ORDER + 1];
+
+    const double M = m_m1 + m_m2;
+
+    th1[0] = yin[THETA_1];
+    w1[0] = yin[OMEGA_1];
+    th2[0] = yin[THETA_2];
+    w2[0] = yin[OMEGA_2];
+
+    for (int k = 0; k < m_order; ++k)
+    {
+        delta[k] = th2[k] - th1[k];
+
+        sinCosK(delta, s, c, k);
+        sinCosK(th1, s1, c1, k);
+        sinCosK(th2, s2, c2, k);
+
+        ww1[k] = mulK(w1, w1, k);
+        ww2[k] = mulK(w2, w2, k);
+        sc[k] = mulK(s, c, k);
+        cc[k] = mulK(c, c, k);
+
+        den1[k] = ((k == 0) ? M*m_l1 : 0.0) - m_m2*m_l1*cc[k];
+        den2[k] = den1[k] * m_l2 / m_l1;
+
+        n1[k] = m_m2*m_l1*mulK(ww1, sc, k) + m_m2*m_g*mulK(s2, c, k)
+              + m_m2*m_l2*mulK(ww2, s, k) - M*m_g*s1[k];
+
+        n2[k] = -m_m2*m_l2*mulK(ww2, sc, k) + M*m_g*mulK(s1, c, k)
+              - M*m_l1*mulK(ww1, s, k) - M*m_g*s2[k];
+
+        divK(n1, den1, a1, k);
+        divK(n2, den2, a2, k);
+
+        // Integrate: dθ/dt = ω and dω/dt = α
+        th1[k + 1] = w1[k] / (k + 1);
+        w1[k + 1] = a1[k] / (k + 1);
+        th2[k + 1] = w2[k] / (k + 1);
+        w2[k + 1] = a2[k] / (k + 1);
+    }
+}
+
+void DoublePendulumTaylor::evaluate(double h, double *yout) const
+{
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        double y = m_coeffs[i][m_order];
+        for (int k = m_order - 1; k >= 0; --k)
+        {
+            y = y * h + m_coeffs[i][k];
+        }
+
+        yout[i] = y;
+    }
+}
+
+void DoublePendulumTaylor::solveODEs(const double *yin, double *yout)
+{
+    computeCoefficients(yin);
+    evaluate(m_dt, yout);
+}
+
+void DoublePendulumTaylor::step()
+{
+    computeCoefficients(m_y);
+
+    // Estimate the radius of convergence from the last two coefficients
+    double scale = 1.0;
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        scale = std::max(scale, fabs(m_y[i]));
+    }
+
+    double h = m_h * 10.0;
+    double norms[2];
+    for (int k = m_order - 1; k <= m_order; ++k)
+    {
+        double norm = 0.0;
+        for (int i = 0; i < NUM_EQNS; ++i)
+        {
+            norm = std::max(norm, fabs(m_coeffs[i][k]));
+        }
+
+        if (norm > 0.0)
+        {
+            h = std::min(h, pow(m_tol * scale / norm, 1.0 / k));
+        }
+
+        norms[k - m_order + 1] = norm;
+    }
+
+    // Safety factor, as the series is truncated rather than exact
+    h *= 0.9;
+
+    /*
+     * The first term left out of the series, with its coefficient taken to
+     * decay at the rate of the last two, must be within the tolerance too;
+     * if not, the step is retried shorter with the same coefficients.
+     */
+    if (norms[0] > 0.0)
+    {
+        const double next = norms[1] * norms[1] / norms[0];
+        const int k = m_order + 1;
+
+        if (next * pow(h, k) > m_tol * scale)
+        {
+            h = 0.9 * pow(m_tol * scale / next, 1.0 / k);
+            ++m_rejectedSteps;
+        }
+    }
+
+    m_tPrev = m_tStep;
+    m_tStep += h;
+
+    for (int i = 0; i < NUM_EQNS; ++i)
+    {
+        m_yPrev[i] = m_y[i];
+    }
+
+    evaluate(h, m_y);
+
+    m_h = h;
+    ++m_acceptedSteps;
+}
+
+void DoublePendulumTaylor::denseOutput(double t, double *yout)
+{
+    evaluate(t - m_tPrev, yout);
+}
@@ -0,0 +1,88 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DOUBLEPENDULUMTAYLOR_H
+#define DOUBLEPENDULUMTAYLOR_H
+
+#include "doublependulumadaptive.h"
+
+/**
+ * Taylor series solver of arbitrary order.
+ *
+ * The Taylor coefficients of the solution are generated recursively by
+ * automatic differentiation of the equations of motion, every intermediate
+ * quantity in derivs() (products, sin/cos and the final division) being
+ * represented as a truncated power series, or jet.  The order is fixed from
+ * the tolerance and only the step size adapts, from the decay of the last
+ * coefficients, following Jorba & Zou (2005).  A step is retried shorter,
+ * reusing its coefficients, if the first term left out of the series looks
+ * to exceed the tolerance.  The series itself serves as dense output.
+ */
+class DoublePendulumTaylor : public DoublePendulumAdaptive
+{
+public:
+    DoublePendulumTaylor(const Pendulum& upper, const Pendulum& lower,
+                         double dt=0.005, double g=9.81, double tol=1e-15);
+
+    const char *solverMethod();
+
+    /**
+     * Takes a single step of size m_dt at the chosen order.  This replaces
+     * the series used for dense output and so should not be mixed with
+     * update().
+     */
+    void solveODEs(const double *yin, double *yout);
+
+    void denseOutput(double t, double *yout);
+
+    int order() const
+    {
+        return m_order;
+    }
+
+protected:
+    void step();
+
+private:
+    enum
+    {
+        MAX_ORDER = 40
+    };
+
+    /**
+     * Generates the Taylor coefficients of the solution through yin up to
+     * m_order, storing them in m_coeffs.
+     */
+    void computeCoefficients(const double *yin);
+
+    /**
+     * Evaluates the series in m_coeffs at an offset of h.
+     */
+    void evaluate(double h, double *yout) const;
+
+    const int m_order;
+
+    /**
+     * Taylor coefficients of θ1, ω1, θ2 and ω2 about the start of the most
+     * recent step.
+     */
+    double m_coeffs[NUM_EQNS][MAX_ORDER + 1];
+};
+
+#endif // DOUBLEPENDULUMTAYLOR_H
@@ -18,6 +18,7 @@
 */
 
 #include "doublependulumwidget.h"
+#include "doublependulumfactory.h"
 #include "doublependulumitem.h"
 
 #include <QGraphicsScene>
@@ -58,23 +59,34 @@ DoublePendulumWidget::~DoublePendulumWidget()
 {
 }
 
-void DoublePendulumWidget::addPendulum(const QString &name, DoublePendulumItem *pendulum)
+PendulumRegistry::Handle DoublePendulumWidget::addPendulum(const QString &name,
+                                                           DoublePendulumItem *pendulum)
 {
+    if (m_pendula.isFull())
+    {
+        return PendulumRegistry::Null;
+    }
+
     scene()->addItem(pendulum);
     pendulum->setPos(0.0, 0.0);
     pendulum->updateScale(m_pScaleFactor);
 
-    m_pendula[name] = pendulum;
+    return m_pendula.insert(name, pendulum);
 }
 
-void DoublePendulumWidget::removePendulum(const QString &name)
+DoublePendulumItem *DoublePendulumWidget::removePendulum(PendulumRegistry::Handle handle)
 {
-    scene()->removeItem(m_pendula[name]);
+    DoublePendulumItem *pendulum = m_pendula.remove(handle);
+
+    if (pendulum)
+    {
+        scene()->removeItem(pendulum);
+    }
 
-    m_pendula.remove(name);
+    return pendulum;
 }
 
-QMap<QString, DoublePendulumItem *> DoublePendulumWidget::pendula()
+const PendulumRegistry& DoublePendulumWidget::pendula() const
 {
     return m_pendula;
 }
@@ -88,14 +100,28 @@ void DoublePendulumWidget::startSim()
     // Reset the frame count
     m_numFrames = 0;
 
+    // Make room for all of the pendulums in one go
+    size_t objectBytes = 0;
+
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
+    {
+        const size_t size = DoublePendulumFactory::objectSize(pendulum->solver());
+        objectBytes += DoublePendulumArena::objectSize(size);
+    }
+
+    m_arena.reserve(m_pendula.count(), objectBytes);
+
     // Start of all of the pendulums
-    foreach (DoublePendulumItem *pendulum, m_pendula)
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
     {
-        pendulum->start();
+        pendulum->start(&m_arena, &m_buffer);
     }
 
+    // Have them integrated ahead of the display, a frame per update
+    m_buffer.start(m_simUpdateFreq / 1000.0);
+
     // Update the info box with the current set of pendulums
-    m_info->setPendula(m_pendula);
+    m_info->setPendula(&m_pendula);
     m_info->show();
 
     // Start the timers
@@ -134,12 +160,18 @@ void DoublePendulumWidget::stopSim()
     m_simTimer->stop();
     m_fpsTimer->stop();
 
+    // Stop integrating before the pendulums go away
+    m_buffer.stop();
+
     // Stop all of the pendulums
-    foreach (DoublePendulumItem *pendulum, m_pendula)
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
     {
         pendulum->stop();
     }
 
+    // Destroy them, keeping the memory for the next run
+    m_arena.clear();
+
     // We are not paused
     m_isPaused = false;
 
@@ -160,6 +192,16 @@ int DoublePendulumWidget::framesPerSecond()
     return m_framesPerSecond;
 }
 
+double DoublePendulumWidget::timeWarp()
+{
+    return m_buffer.timeWarp();
+}
+
+void DoublePendulumWidget::setTimeWarp(double warp)
+{
+    m_buffer.setTimeWarp(qBound(1.0, warp, 1000.0));
+}
+
 double DoublePendulumWidget::pendulumScaleFactor()
 {
     return m_pScaleFactor;
@@ -178,7 +220,7 @@ void DoublePendulumWidget::setScaleFactor(double sf)
     // Compute the new pendulum scale factor
     m_pScaleFactor = qMin(sceneRect().width(), sceneRect().height()) / m_scale;
 
-    foreach (DoublePendulumItem *pendulum, m_pendula)
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
     {
         pendulum->updateScale(m_pScaleFactor);
     }
@@ -192,7 +234,7 @@ double DoublePendulumWidget::idealScaleFactor()
     double largestPendulm = 0;
 
     // Loop over each pendulum looking for the largest
-    foreach (DoublePendulumItem *pendulum, m_pendula)
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
     {
         // Get the bounds of the pendulum
         QRectF bounds = pendulum->boundingRect();
@@ -211,8 +253,9 @@ double DoublePendulumWidget::idealScaleFactor()
 
 void DoublePendulumWidget::advanceSimulation()
 {
-    // Advance the simulation forward by the amount of time that has passed
-    m_simTime += m_lastUpdate.elapsed();
+    // Advance the simulation forward by the amount of time that has passed,
+    // warped, so far as the integration has got
+    m_simTime = 1000.0 * m_buffer.advance(m_lastUpdate.elapsed() / 1000.0);
 
     // Reset the last update time
     m_lastUpdate.restart();
@@ -221,9 +264,9 @@ void DoublePendulumWidget::advanceSimulation()
     ++m_numFrames;
 
     // Update the scene
-    foreach (DoublePendulumItem *pendulum, m_pendula)
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
     {
-        pendulum->updateTime(m_simTime);
+        pendulum->updateState();
     }
 
     m_info->update();
@@ -249,7 +292,7 @@ void DoublePendulumWidget::resizeEvent(QResizeEvent *event)
     // Ensure the range of the smaller axis is between 0..m_scale
     m_pScaleFactor = qMin(newSceneRect.width(), newSceneRect.height()) / m_scale;
 
-    foreach (DoublePendulumItem *pendulum, m_pendula)
+    foreach (DoublePendulumItem *pendulum, m_pendula.items())
     {
         pendulum->updateScale(m_pScaleFactor);
     }
@@ -23,10 +23,12 @@
 #include <QGraphicsView>
 #include <QTime>
 #include <QTimer>
-#include <QMap>
 
+#include "doublependulumarena.h"
 #include "doublependulumitem.h"
 #include "doublependuluminfoitem.h"
+#include "pendulumregistry.h"
+#include "timewarpbuffer.h"
 
 class DoublePendulumWidget : public QGraphicsView
 {
@@ -36,9 +38,14 @@ public:
     DoublePendulumWidget(QWidget *parent);
     ~DoublePendulumWidget();
 
-    void addPendulum(const QString &name, DoublePendulumItem *pendulum);
-    void removePendulum(const QString &name);
-    QMap<QString, DoublePendulumItem *> pendula();
+    /**
+     * Adds the pendulum to the scene, returning its handle, or Null if the
+     * registry is full, in which case the pendulum is not added.
+     */
+    PendulumRegistry::Handle addPendulum(const QString &name,
+                                         DoublePendulumItem *pendulum);
+    DoublePendulumItem *removePendulum(PendulumRegistry::Handle handle);
+    const PendulumRegistry& pendula() const;
 
     void startSim();
     void pauseSim();
@@ -47,6 +54,13 @@ public:
     double time();
     int framesPerSecond();
 
+    /**
+     * Rate at which simulated time passes relative to wall time, from 1 to
+     * 1000; may be changed while the simulation is running.
+     */
+    double timeWarp();
+    void setTimeWarp(double warp);
+
     double pendulumScaleFactor();
 
     double scaleFactor();
@@ -75,7 +89,18 @@ private:
 
     bool m_isPaused;
 
-    QMap<QString, DoublePendulumItem *> m_pendula;
+    PendulumRegistry m_pendula;
+
+    /**
+     * Storage for the running pendula, kept between runs.
+     */
+    DoublePendulumArena m_arena;
+
+    /**
+     * Integrates the pendula ahead of the display; must go after m_arena so
+     * that it is stopped before the pendula are destroyed.
+     */
+    TimeWarpBuffer m_buffer;
 
     DoublePendulumInfoItem *m_info;
 };
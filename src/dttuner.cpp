@@ -0,0 +1,285 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "dttuner.h"
+#include "doublependulumfactory.h"
+
+#include <QtConcurrentMap>
+
+#include <cmath>
+
+namespace
+{
+    struct Candidate
+    {
+        const char *solver;
+        bool symplectic;
+    };
+
+    const Candidate candidates[] =
+    {
+        { "Runge Kutta (RK4)", false },
+        { "Gauss-Legendre (2 stage)", true },
+        { "Gauss-Legendre (3 stage)", true }
+    };
+
+    const int numCandidates = sizeof(candidates) / sizeof(candidates[0]);
+
+    // Step sizes tried, largest first, within the range of the dt box
+    const double DT_MAX = 0.05;
+    const double DT_MIN = 1e-4;
+    const double DT_FACTOR = 0.7;
+
+    // Length of the probes (s), and how often the energy is checked
+    const double PROBE_TIME = 5.0;
+    const int PROBE_CHECKS = 20;
+
+    struct Probe
+    {
+        double drift;
+        double cost;
+    };
+
+    Probe probe(const char *solver, const Pendulum& upper,
+                const Pendulum& lower, double g, double dt, double duration)
+    {
+        DoublePendulum *p = DoublePendulumFactory::create(solver, upper, lower,
+                                                          dt, g);
+
+        const double e0 = p->initEnergy();
+        const double scale = (upper.m + lower.m) * g * (upper.l + lower.l);
+
+        double maxError = 0.0;
+
+        for (int i = 1; i <= PROBE_CHECKS; ++i)
+        {
+            p->update(duration * i / PROBE_CHECKS);
+
+            const double error = fabs(p->energy() - e0);
+
+            // Also catches a blow up to NaN
+            if (!(error < HUGE_VAL))
+            {
+                maxError = HUGE_VAL;
+                break;
+            }
+
+            maxError = qMax(maxError, error);
+        }
+
+        Probe result;
+        result.drift = (scale > 0.0) ? maxError / scale : maxError;
+        result.cost = p->derivsEvaluations() / duration;
+
+        delete p;
+
+        return result;
+    }
+
+    /**
+     * Bin of the energy of the pendulum above its rest energy, in units of
+     * the energy scale (m1 + m2)·g·(l1 + l2).
+     */
+    double energyBin(const Pendulum& upper, const Pendulum& lower, double g)
+    {
+        const double M = upper.m + lower.m;
+        const double w1 = upper.omega, w2 = lower.omega;
+
+        const double kinetic = 0.5*M*upper.l*upper.l*w1*w1
+                             + 0.5*lower.m*lower.l*lower.l*w2*w2
+                             + lower.m*upper.l*lower.l*w1*w2
+                             * cos(upper.theta - lower.theta);
+        const double potential = M*g*upper.l*(1.0 - cos(upper.theta))
+                               + lower.m*g*lower.l*(1.0 - cos(lower.theta));
+
+        const double scale = M * g * (upper.l + lower.l);
+        const double e = (scale > 0.0) ? (kinetic + potential) / scale
+                                       : kinetic + potential;
+
+        return floor(e * DtTuner::ENERGY_BINS);
+    }
+}
+
+void DtTuner::addPendulum(const Pendulum& upper, const Pendulum& lower,
+                          double g, double budget, double horizon)
+{
+    Job job;
+    job.upper = upper;
+    job.lower = lower;
+    job.g = g;
+    job.budget = budget;
+    job.horizon = horizon;
+
+    // Everything which goes into the choice, the initial state only by way
+    // of its energy
+    const double params[] =
+    {
+        upper.l, upper.m, lower.l, lower.m, g, budget, horizon,
+        energyBin(upper, lower, g)
+    };
+
+    job.key = QByteArray(reinterpret_cast<const char *>(params),
+                         sizeof(params));
+    job.shared = false;
+    job.cached = false;
+
+    // Share the probes of any alike pendulum already added
+    const int i = m_jobIndex.value(job.key, -1);
+
+    if (i >= 0)
+    {
+        m_members.append(i);
+        m_jobs[i].shared = true;
+    }
+    else
+    {
+        m_jobIndex.insert(job.key, m_jobs.count());
+        m_members.append(m_jobs.count());
+        m_jobs.append(job);
+    }
+}
+
+void DtTuner::clear()
+{
+    m_jobs.clear();
+    m_members.clear();
+    m_jobIndex.clear();
+}
+
+int DtTuner::count() const
+{
+    return m_members.count();
+}
+
+int DtTuner::probeCount() const
+{
+    return m_jobs.count();
+}
+
+QFuture<void> DtTuner::start()
+{
+    for (int i = 0; i < m_jobs.count(); ++i)
+    {
+        Job& job = m_jobs[i];
+
+        // Shared choices are made to a tighter budget, so are cached apart
+        job.cacheKey = job.shared ? job.key + 's' : job.key;
+        job.cached = m_cache.contains(job.cacheKey);
+
+        if (job.cached)
+        {
+            job.result = m_cache.value(job.cacheKey);
+        }
+    }
+
+    return QtConcurrent::map(m_jobs, DtTuner::runJob);
+}
+
+QVector<DtChoice> DtTuner::results()
+{
+    for (int i = 0; i < m_jobs.count(); ++i)
+    {
+        m_cache.insert(m_jobs[i].cacheKey, m_jobs[i].result);
+    }
+
+    QVector<DtChoice> choices(m_members.count());
+
+    for (int i = 0; i < m_members.count(); ++i)
+    {
+        choices[i] = m_jobs[m_members[i]].result;
+    }
+
+    return choices;
+}
+
+QVector<DtChoice> DtTuner::run()
+{
+    start().waitForFinished();
+
+    return results();
+}
+
+void DtTuner::clearCache()
+{
+    m_cache.clear();
+}
+
+void DtTuner::runJob(Job& job)
+{
+    if (!job.cached)
+    {
+        const double budget = job.shared ? job.budget / SHARED_MARGIN
+                                         : job.budget;
+
+        job.result = tune(job.upper, job.lower, job.g, budget, job.horizon);
+        job.result.withinBudget = job.result.drift <= job.budget;
+    }
+}
+
+DtChoice DtTuner::tune(const Pendulum& upper, const Pendulum& lower,
+                       double g, double budget, double horizon)
+{
+    const double duration = qMin(horizon, PROBE_TIME);
+
+    DtChoice best;
+    best.solver = candidates[0].solver;
+    best.dt = DT_MIN;
+    best.drift = HUGE_VAL;
+    best.withinBudget = false;
+
+    double bestCost = HUGE_VAL;
+
+    for (int c = 0; c < numCandidates; ++c)
+    {
+        const Candidate& candidate = candidates[c];
+
+        for (double dt = DT_MAX; dt >= DT_MIN; dt *= DT_FACTOR)
+        {
+            const Probe p = probe(candidate.solver, upper, lower, g, dt,
+                                  duration);
+
+            const double drift = candidate.symplectic
+                               ? p.drift
+                               : p.drift * horizon / duration;
+
+            if (drift <= budget)
+            {
+                // The largest step to meet the budget is the cheapest
+                if (!best.withinBudget || p.cost < bestCost)
+                {
+                    best.solver = candidate.solver;
+                    best.dt = dt;
+                    best.drift = drift;
+                    best.withinBudget = true;
+                    bestCost = p.cost;
+                }
+
+                break;
+            }
+            else if (!best.withinBudget && drift < best.drift)
+            {
+                best.solver = candidate.solver;
+                best.dt = dt;
+                best.drift = drift;
+            }
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,153 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef DTTUNER_H
+#define DTTUNER_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "doublependulum.h"
+
+/**
+ * A solver and step size picked by DtTuner.
+ */
+struct DtChoice
+{
+    QString solver;
+    double dt;
+
+    /**
+     * Energy drift projected over the horizon, relative to the energy scale
+     * (m1 + m2)·g·(l1 + l2) of the pendulum.
+     */
+    double drift;
+
+    /**
+     * False if no candidate met the budget, in which case the choice is the
+     * one with the least drift.
+     */
+    bool withinBudget;
+};
+
+/**
+ * Picks, for each of a set of pendula, the cheapest of the fixed step
+ * solvers and the largest step size which keep the energy drift over a
+ * horizon within a budget.
+ *
+ * Each candidate solver is run for a short probe at a decreasing series of
+ * step sizes until the drift projected from the probe meets the budget.
+ * The energy error of the symplectic Gauss-Legendre solvers stays bounded
+ * and so is taken as is; that of RK4 grows secularly and so is scaled up
+ * linearly from the probe to the horizon.  Of the candidates meeting the
+ * budget the one making the fewest evaluations of the equations of motion
+ * per simulated second wins.
+ *
+ * Pendula alike in their masses, lengths, g, budget and horizon, and whose
+ * energies fall in the same 1/ENERGY_BINS of the energy scale, share a
+ * single set of probes, so that an ensemble varying only its initial
+ * angles costs a handful of probes rather than one per member.  As alike
+ * pendula need not drift alike, a shared choice is made against a budget
+ * tightened by SHARED_MARGIN.  The probes
+ * are run in parallel, either in the background with start() or blocking
+ * with run().  Choices are cached by the same key so that re-running an
+ * unchanged set of pendula is free.
+ */
+class DtTuner
+{
+public:
+    enum
+    {
+        /**
+         * Number of bins the energy range is split into when deciding
+         * whether two pendula may share their probes.
+         */
+        ENERGY_BINS = 64,
+
+        /**
+         * Factor by which the budget is tightened for shared probes.
+         */
+        SHARED_MARGIN = 8
+    };
+
+    void addPendulum(const Pendulum& upper, const Pendulum& lower, double g,
+                     double budget, double horizon);
+    void clear();
+    int count() const;
+
+    /**
+     * Starts the probes on the global thread pool and returns at once.  The
+     * pendula must not be changed until the future has finished, after
+     * which results() gives the choices.
+     */
+    QFuture<void> start();
+
+    /**
+     * Returns the choices for each pendulum in the order they were added,
+     * once the probes started by start() are complete.
+     */
+    QVector<DtChoice> results();
+
+    /**
+     * Starts the probes and blocks until they are complete, returning the
+     * choices.
+     */
+    QVector<DtChoice> run();
+
+    /**
+     * Number of distinct sets of probes needed by the pendula added.
+     */
+    int probeCount() const;
+
+    void clearCache();
+
+    /**
+     * Runs the probes for a single pendulum, ignoring the cache.
+     */
+    static DtChoice tune(const Pendulum& upper, const Pendulum& lower,
+                         double g, double budget, double horizon);
+
+private:
+    struct Job
+    {
+        Pendulum upper, lower;
+        double g, budget, horizon;
+
+        QByteArray key, cacheKey;
+        bool shared;
+        bool cached;
+        DtChoice result;
+    };
+
+    static void runJob(Job& job);
+
+    /**
+     * Distinct jobs, and for each pendulum added the job it shares.
+     */
+    QVector<Job> m_jobs;
+    QVector<int> m_members;
+    QHash<QByteArray, int> m_jobIndex;
+
+    QHash<QByteArray, DtChoice> m_cache;
+};
+
+#endif // DTTUNER_H
@@ -0,0 +1,188 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ensembledialog.h"
+#include "pendulumregistry.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+#include <QGridLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+#include <climits>
+
+namespace
+{
+    const char *const PARAMETER_NAMES[] =
+    {
+        "θ1 (rad)", "ω1 (rad/s)", "m1 (kg)", "l1 (m)",
+        "θ2 (rad)", "ω2 (rad/s)", "m2 (kg)", "l2 (m)"
+    };
+
+    // Largest ensemble which may be created in one go; the registry must
+    // also have room for it alongside the pendula already there
+    const int MAX_COUNT = qMin(1000000, int(PendulumRegistry::CAPACITY));
+
+    bool isPositive(int p)
+    {
+        // Masses and lengths
+        return p % 4 >= 2;
+    }
+}
+
+EnsembleDialog::EnsembleDialog(const Pendulum& upper, const Pendulum& lower,
+                               QWidget *parent)
+    : QDialog(parent)
+    , m_upper(upper)
+    , m_lower(lower)
+    , m_mode(new QComboBox(this))
+    , m_count(new QSpinBox(this))
+    , m_seed(new QSpinBox(this))
+    , m_total(new QLabel(this))
+    , m_buttons(new QDialogButtonBox(QDialogButtonBox::Ok
+                                   | QDialogButtonBox::Cancel,
+                                     Qt::Horizontal, this))
+{
+    setWindowTitle(tr("Add Ensemble"));
+
+    m_mode->addItem(tr("Grid"));
+    m_mode->addItem(tr("Linear sweep"));
+    m_mode->addItem(tr("Random perturbation"));
+
+    m_count->setRange(1, MAX_COUNT);
+    m_count->setValue(100);
+
+    m_seed->setRange(0, INT_MAX);
+
+    QGridLayout *settings = new QGridLayout;
+    settings->addWidget(new QLabel(tr("Mode"), this), 0, 0);
+    settings->addWidget(m_mode, 0, 1);
+    settings->addWidget(new QLabel(tr("Pendula"), this), 1, 0);
+    settings->addWidget(m_count, 1, 1);
+    settings->addWidget(new QLabel(tr("Seed"), this), 2, 0);
+    settings->addWidget(m_seed, 2, 1);
+
+    // One row per parameter, defaulting to a small spread about the base
+    QGridLayout *ranges = new QGridLayout;
+    ranges->addWidget(new QLabel(tr("From"), this), 0, 1);
+    ranges->addWidget(new QLabel(tr("To"), this), 0, 2);
+    ranges->addWidget(new QLabel(tr("Steps"), this), 0, 3);
+
+    for (int p = 0; p < EnsembleGenerator::NUM_PARAMETERS; ++p)
+    {
+        const double base = EnsembleGenerator::base(EnsembleGenerator::Parameter(p),
+                                                    m_upper, m_lower);
+        const double spread = isPositive(p) ? 0.1*base : 0.1;
+
+        m_varies[p] = new QCheckBox(QString::fromUtf8(PARAMETER_NAMES[p]), this);
+        m_from[p] = new QDoubleSpinBox(this);
+        m_to[p] = new QDoubleSpinBox(this);
+        m_steps[p] = new QSpinBox(this);
+
+        QDoubleSpinBox *ends[] = { m_from[p], m_to[p] };
+
+        for (int e = 0; e < 2; ++e)
+        {
+            ends[e]->setDecimals(4);
+            ends[e]->setSingleStep(0.01);
+            ends[e]->setRange(isPositive(p) ? 0.01 : -1000.0, 1000.0);
+        }
+
+        m_from[p]->setValue(base - spread);
+        m_to[p]->setValue(base + spread);
+
+        m_steps[p]->setRange(1, MAX_COUNT);
+        m_steps[p]->setValue(10);
+
+        ranges->addWidget(m_varies[p], p + 1, 0);
+        ranges->addWidget(m_from[p], p + 1, 1);
+        ranges->addWidget(m_to[p], p + 1, 2);
+        ranges->addWidget(m_steps[p], p + 1, 3);
+
+        connect(m_varies[p], SIGNAL(toggled(bool)), this, SLOT(updateControls()));
+        connect(m_steps[p], SIGNAL(valueChanged(int)), this, SLOT(updateControls()));
+    }
+
+    connect(m_mode, SIGNAL(currentIndexChanged(int)), this, SLOT(updateControls()));
+    connect(m_count, SIGNAL(valueChanged(int)), this, SLOT(updateControls()));
+
+    connect(m_buttons, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(m_buttons, SIGNAL(rejected()), this, SLOT(reject()));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(settings);
+    layout->addLayout(ranges);
+    layout->addWidget(m_total);
+    layout->addWidget(m_buttons);
+
+    // Start off with a grid over the two initial angles
+    m_varies[EnsembleGenerator::Theta1]->setChecked(true);
+    m_varies[EnsembleGenerator::Theta2]->setChecked(true);
+
+    updateControls();
+}
+
+EnsembleGenerator EnsembleDialog::generator() const
+{
+    EnsembleGenerator gen(m_upper, m_lower);
+
+    gen.setMode(EnsembleGenerator::Mode(m_mode->currentIndex()));
+    gen.setCount(m_count->value());
+    gen.setSeed(m_seed->value());
+
+    for (int p = 0; p < EnsembleGenerator::NUM_PARAMETERS; ++p)
+    {
+        if (m_varies[p]->isChecked())
+        {
+            gen.setRange(EnsembleGenerator::Parameter(p), m_from[p]->value(),
+                         m_to[p]->value(), m_steps[p]->value());
+        }
+    }
+
+    return gen;
+}
+
+void EnsembleDialog::updateControls()
+{
+    const EnsembleGenerator::Mode mode = EnsembleGenerator::Mode(m_mode->currentIndex());
+
+    m_count->setEnabled(mode != EnsembleGenerator::Grid);
+    m_seed->setEnabled(mode == EnsembleGenerator::Random);
+
+    for (int p = 0; p < EnsembleGenerator::NUM_PARAMETERS; ++p)
+    {
+        const bool varies = m_varies[p]->isChecked();
+
+        m_from[p]->setEnabled(varies);
+        m_to[p]->setEnabled(varies);
+        m_steps[p]->setEnabled(varies && mode == EnsembleGenerator::Grid);
+    }
+
+    const int count = generator().count();
+    const bool valid = count > 0 && count <= MAX_COUNT;
+
+    m_total->setText(valid ? tr("%n pendula", 0, count)
+                           : tr("Too many pendula (at most %1)").arg(MAX_COUNT));
+    m_buttons->button(QDialogButtonBox::Ok)->setEnabled(valid);
+}
@@ -0,0 +1,70 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ENSEMBLEDIALOG_H
+#define ENSEMBLEDIALOG_H
+
+#include <QDialog>
+
+#include "ensemblegenerator.h"
+
+class QCheckBox;
+class QComboBox;
+class QDialogButtonBox;
+class QDoubleSpinBox;
+class QLabel;
+class QSpinBox;
+
+/**
+ * Dialog for describing an ensemble of pendula as a grid, sweep or random
+ * perturbation about a base pendulum.
+ */
+class EnsembleDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    EnsembleDialog(const Pendulum& upper, const Pendulum& lower,
+                   QWidget *parent = 0);
+
+    /**
+     * Returns a generator for the ensemble as currently described.
+     */
+    EnsembleGenerator generator() const;
+
+private slots:
+    void updateControls();
+
+private:
+    const Pendulum m_upper;
+    const Pendulum m_lower;
+
+    QComboBox *m_mode;
+    QSpinBox *m_count;
+    QSpinBox *m_seed;
+    QLabel *m_total;
+    QDialogButtonBox *m_buttons;
+
+    QCheckBox *m_varies[EnsembleGenerator::NUM_PARAMETERS];
+    QDoubleSpinBox *m_from[EnsembleGenerator::NUM_PARAMETERS];
+    QDoubleSpinBox *m_to[EnsembleGenerator::NUM_PARAMETERS];
+    QSpinBox *m_steps[EnsembleGenerator::NUM_PARAMETERS];
+};
+
+#endif // ENSEMBLEDIALOG_H
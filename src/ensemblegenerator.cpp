@@ -0,0 +1,181 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ensemblegenerator.h"
+
+#include <QtGlobal>
+
+#include <climits>
+
+namespace
+{
+    /**
+     * The SplitMix64 finaliser; a bijection on 64-bit integers which mixes
+     * consecutive inputs into statistically independent outputs.
+     */
+    quint64 mix(quint64 z)
+    {
+        z += Q_UINT64_C(0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+
+        return z ^ (z >> 31);
+    }
+
+    double *field(EnsembleGenerator::Parameter p,
+                  Pendulum *upper, Pendulum *lower)
+    {
+        Pendulum *arm = (p < EnsembleGenerator::Theta2) ? upper : lower;
+
+        switch (p % 4)
+        {
+            case 0:
+                return &arm->theta;
+            case 1:
+                return &arm->omega;
+            case 2:
+                return &arm->m;
+            default:
+                return &arm->l;
+        }
+    }
+}
+
+EnsembleGenerator::EnsembleGenerator(const Pendulum& upper,
+                                     const Pendulum& lower)
+    : m_upper(upper)
+    , m_lower(lower)
+    , m_mode(Grid)
+    , m_count(1)
+    , m_seed(0)
+{
+    for (int p = 0; p < NUM_PARAMETERS; ++p)
+    {
+        clearRange(Parameter(p));
+    }
+}
+
+void EnsembleGenerator::setMode(Mode mode)
+{
+    m_mode = mode;
+}
+
+void EnsembleGenerator::setRange(Parameter p, double from, double to,
+                                 int steps)
+{
+    m_ranges[p].varies = true;
+    m_ranges[p].from = from;
+    m_ranges[p].to = to;
+    m_ranges[p].steps = qMax(1, steps);
+}
+
+void EnsembleGenerator::clearRange(Parameter p)
+{
+    m_ranges[p].varies = false;
+    m_ranges[p].from = m_ranges[p].to = base(p, m_upper, m_lower);
+    m_ranges[p].steps = 1;
+}
+
+void EnsembleGenerator::setCount(int count)
+{
+    m_count = qMax(0, count);
+}
+
+void EnsembleGenerator::setSeed(unsigned int seed)
+{
+    m_seed = seed;
+}
+
+int EnsembleGenerator::count() const
+{
+    if (m_mode != Grid)
+    {
+        return m_count;
+    }
+
+    qint64 n = 1;
+
+    for (int p = 0; p < NUM_PARAMETERS; ++p)
+    {
+        if (m_ranges[p].varies)
+        {
+            n *= m_ranges[p].steps;
+
+            if (n > INT_MAX)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return int(n);
+}
+
+void EnsembleGenerator::generate(int i, Pendulum *upper, Pendulum *lower) const
+{
+    *upper = m_upper;
+    *lower = m_lower;
+
+    // In a grid the last varying parameter changes fastest
+    int rest = i;
+
+    for (int p = NUM_PARAMETERS - 1; p >= 0; --p)
+    {
+        const Range& r = m_ranges[p];
+
+        if (!r.varies)
+        {
+            continue;
+        }
+
+        double x;
+
+        switch (m_mode)
+        {
+            case Grid:
+                x = (r.steps > 1) ? double(rest % r.steps) / (r.steps - 1) : 0.0;
+                rest /= r.steps;
+                break;
+            case Sweep:
+                x = (m_count > 1) ? double(i) / (m_count - 1) : 0.0;
+                break;
+            default:
+                x = uniform(i, Parameter(p));
+                break;
+        }
+
+        *field(Parameter(p), upper, lower) = r.from + x*(r.to - r.from);
+    }
+}
+
+double EnsembleGenerator::base(Parameter p, const Pendulum& upper,
+                               const Pendulum& lower)
+{
+    Pendulum u = upper, l = lower;
+
+    return *field(p, &u, &l);
+}
+
+double EnsembleGenerator::uniform(int i, Parameter p) const
+{
+    const quint64 key = mix(m_seed) + quint64(i) * NUM_PARAMETERS + p;
+
+    // Top 53 bits as a double in [0, 1)
+    return (mix(key) >> 11) * (1.0 / 9007199254740992.0);
+}
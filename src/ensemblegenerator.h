@@ -0,0 +1,120 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ENSEMBLEGENERATOR_H
+#define ENSEMBLEGENERATOR_H
+
+#include "doublependulum.h"
+
+/**
+ * Describes an ensemble of double pendula as variations on a base pendulum,
+ * with any subset of the initial angles, angular velocities, masses and
+ * lengths varying over a range.
+ *
+ * In Grid mode each varying parameter takes steps evenly spaced values and
+ * the ensemble is every combination of them; in Sweep mode they all move
+ * together from one end of their range to the other over count pendula; and
+ * in Random mode each is drawn uniformly from its range for each of count
+ * pendula.
+ *
+ * Members of the ensemble are generated independently from their index, the
+ * random ones with a counter-based generator, so they may be produced in any
+ * order and the same seed always gives the same ensemble.
+ */
+class EnsembleGenerator
+{
+public:
+    enum Parameter
+    {
+        Theta1,
+        Omega1,
+        Mass1,
+        Length1,
+        Theta2,
+        Omega2,
+        Mass2,
+        Length2,
+        NUM_PARAMETERS
+    };
+
+    enum Mode
+    {
+        Grid,
+        Sweep,
+        Random
+    };
+
+    EnsembleGenerator(const Pendulum& upper, const Pendulum& lower);
+
+    Mode mode() const { return m_mode; }
+    void setMode(Mode mode);
+
+    /**
+     * Varies parameter p over [from, to]; steps is only used in Grid mode.
+     */
+    void setRange(Parameter p, double from, double to, int steps=2);
+    void clearRange(Parameter p);
+
+    bool varies(Parameter p) const { return m_ranges[p].varies; }
+
+    /**
+     * Number of pendula in Sweep and Random modes.
+     */
+    void setCount(int count);
+
+    void setSeed(unsigned int seed);
+
+    /**
+     * Number of pendula in the ensemble, or -1 if a grid would have more
+     * than INT_MAX members.
+     */
+    int count() const;
+
+    /**
+     * Generates the initial state of pendulum i of the ensemble.
+     */
+    void generate(int i, Pendulum *upper, Pendulum *lower) const;
+
+    static double base(Parameter p, const Pendulum& upper,
+                       const Pendulum& lower);
+
+private:
+    struct Range
+    {
+        bool varies;
+        double from;
+        double to;
+        int steps;
+    };
+
+    /**
+     * Returns a uniform deviate in [0, 1) for parameter p of pendulum i.
+     */
+    double uniform(int i, Parameter p) const;
+
+    const Pendulum m_upper;
+    const Pendulum m_lower;
+
+    Mode m_mode;
+    Range m_ranges[NUM_PARAMETERS];
+    int m_count;
+    unsigned int m_seed;
+};
+
+#endif // ENSEMBLEGENERATOR_H
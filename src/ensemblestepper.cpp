@@ -0,0 +1,463 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ensemblestepper.h"
+#include "doublependulumfactory.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    // SplitMix64 finaliser
+    quint64 mix(quint64 z)
+    {
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+
+        return z ^ (z >> 31);
+    }
+
+    /*
+     * Hash of the i-th state; summing these gives a checksum which does not
+     * care what order the pendula are visited in.
+     */
+    quint64 hashState(int i, const DoublePendulumState& state)
+    {
+        quint64 words[4];
+        memcpy(words, state.y, sizeof(words));
+
+        quint64 h = mix(quint64(i));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            h = mix(h ^ words[j]);
+        }
+
+        return h;
+    }
+}
+
+class EnsembleStepper::Worker : public QThread
+{
+public:
+    Worker(EnsembleStepper *stepper, int index, int begin, int end, int cpu)
+        : m_stepper(stepper)
+        , m_index(index)
+        , m_begin(begin)
+        , m_end(end)
+        , m_cpu(cpu)
+        , m_arena(stepper->m_pages)
+    {
+        // Where our partial energy sums go, and how many pendula each covers
+        if (stepper->m_deterministic)
+        {
+            m_energy = stepper->m_energies.data() + begin / CHUNK_SIZE;
+            m_chunkSize = CHUNK_SIZE;
+        }
+        else
+        {
+            m_energy = stepper->m_energies.data() + index;
+            m_chunkSize = qMax(end - begin, 1);
+        }
+
+        m_checksum = stepper->m_checksums.data() + index;
+    }
+
+    const DoublePendulumArena& arena() const
+    {
+        return m_arena;
+    }
+
+protected:
+    void run()
+    {
+        if (m_cpu >= 0)
+        {
+            pin(m_cpu);
+        }
+
+        build();
+        step(0.0);
+
+        EnsembleStepper *s = m_stepper;
+        QMutexLocker locker(&s->m_mutex);
+
+        s->workerDone();
+
+        for (int seen = s->m_generation;;)
+        {
+            while (s->m_generation == seen)
+            {
+                s->m_command.wait(&s->m_mutex);
+            }
+
+            seen = s->m_generation;
+
+            if (s->m_quit)
+            {
+                break;
+            }
+
+            const double target = s->m_target;
+
+            locker.unlock();
+            step(target);
+            locker.relock();
+
+            s->workerDone();
+        }
+
+        locker.unlock();
+
+        // Free the slice from the thread which touched it
+        m_arena.clear();
+    }
+
+private:
+    static void pin(int cpu)
+    {
+#ifdef Q_OS_LINUX
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+
+        // Failure (say, a cpu outside our cpuset) just leaves us unpinned
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        Q_UNUSED(cpu);
+#endif
+    }
+
+    /**
+     * Advances our pendula to target and works out our partial results.
+     */
+    void step(double target)
+    {
+        const DoublePendulumState *states = m_arena.states();
+        const int n = m_arena.count();
+
+        quint64 checksum = 0;
+
+        for (int i = 0, k = 0; i < n; i += m_chunkSize, ++k)
+        {
+            const int end = qMin(i + m_chunkSize, n);
+            double energy = 0.0;
+
+            for (int j = i; j < end; ++j)
+            {
+                DoublePendulum *p = m_arena.at(j);
+
+                p->update(target);
+
+                energy += p->energy();
+                checksum += hashState(m_begin + j, states[j]);
+            }
+
+            m_energy[k] = energy;
+        }
+
+        *m_checksum = checksum;
+    }
+
+    void build()
+    {
+        const EnsembleStepper *s = m_stepper;
+        const size_t size = DoublePendulumArena::objectSize(
+            DoublePendulumFactory::objectSize(s->m_solver));
+
+        m_arena.reserve(m_end - m_begin, (m_end - m_begin) * size);
+
+        for (int i = m_begin; i < m_end; ++i)
+        {
+            DoublePendulumFactory::create(s->m_solver, s->m_upper[i],
+                                          s->m_lower[i], s->m_dt, s->m_g,
+                                          &m_arena);
+        }
+    }
+
+    EnsembleStepper *m_stepper;
+    const int m_index;
+    const int m_begin;
+    const int m_end;
+    const int m_cpu;
+
+    double *m_energy;
+    int m_chunkSize;
+    quint64 *m_checksum;
+
+    DoublePendulumArena m_arena;
+};
+
+EnsembleStepper::EnsembleStepper(const QString& solver, double dt, double g)
+    : m_solver(solver)
+    , m_dt(dt)
+    , m_g(g)
+    , m_threadCount(QThread::idealThreadCount())
+    , m_pinThreads(true)
+    , m_pages(DoublePendulumArena::MappedPages)
+    , m_deterministic(false)
+    , m_time(0.0)
+    , m_meanEnergy(0.0)
+    , m_checksum(0)
+    , m_generation(0)
+    , m_pending(0)
+    , m_target(0.0)
+    , m_quit(false)
+{
+}
+
+EnsembleStepper::~EnsembleStepper()
+{
+    stop();
+}
+
+void EnsembleStepper::addInitialCondition(const Pendulum& upper,
+                                          const Pendulum& lower)
+{
+    m_upper.append(upper);
+    m_lower.append(lower);
+}
+
+void EnsembleStepper::clear()
+{
+    stop();
+
+    m_upper.clear();
+    m_lower.clear();
+}
+
+int EnsembleStepper::count() const
+{
+    return m_upper.size();
+}
+
+int EnsembleStepper::threadCount() const
+{
+    return m_threadCount;
+}
+
+void EnsembleStepper::setThreadCount(int threads)
+{
+    m_threadCount = qMax(threads, 1);
+}
+
+bool EnsembleStepper::pinThreads() const
+{
+    return m_pinThreads;
+}
+
+void EnsembleStepper::setPinThreads(bool pin)
+{
+    m_pinThreads = pin;
+}
+
+QVector<int> EnsembleStepper::cpus() const
+{
+    return m_cpus;
+}
+
+void EnsembleStepper::setCpus(const QVector<int>& cpus)
+{
+    m_cpus = cpus;
+}
+
+DoublePendulumArena::PageMode EnsembleStepper::pageMode() const
+{
+    return m_pages;
+}
+
+void EnsembleStepper::setPageMode(DoublePendulumArena::PageMode pages)
+{
+    m_pages = pages;
+}
+
+bool EnsembleStepper::isDeterministic() const
+{
+    return m_deterministic;
+}
+
+void EnsembleStepper::setDeterministic(bool deterministic)
+{
+    m_deterministic = deterministic;
+}
+
+void EnsembleStepper::start()
+{
+    stop();
+
+    const int n = count();
+    const int threads = qMax(qMin(m_threadCount, n), 1);
+
+    const int chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    m_time = 0.0;
+    m_quit = false;
+    m_pending = threads;
+
+    m_energies = QVector<double>(m_deterministic ? chunks : threads, 0.0);
+    m_checksums = QVector<quint64>(threads, 0);
+
+    for (int i = 0; i < threads; ++i)
+    {
+        // Balanced contiguous slices, cut on chunk boundaries if deterministic
+        int begin = int(qint64(n) * i / threads);
+        int end = int(qint64(n) * (i + 1) / threads);
+
+        if (m_deterministic)
+        {
+            begin = qMin(int(qint64(chunks) * i / threads) * CHUNK_SIZE, n);
+            end = qMin(int(qint64(chunks) * (i + 1) / threads) * CHUNK_SIZE, n);
+        }
+
+        int cpu = -1;
+
+        if (m_pinThreads)
+        {
+            cpu = m_cpus.isEmpty() ? i : m_cpus[i % m_cpus.size()];
+        }
+
+        Worker *worker = new Worker(this, i, begin, end, cpu);
+        m_workers.append(worker);
+        worker->start();
+    }
+
+    // Wait for the pendula to be built
+    QMutexLocker locker(&m_mutex);
+
+    while (m_pending > 0)
+    {
+        m_done.wait(&m_mutex);
+    }
+
+    reduce();
+}
+
+void EnsembleStepper::advance(double newTime)
+{
+    if (m_workers.isEmpty())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    m_target = newTime;
+    m_pending = m_workers.size();
+    ++m_generation;
+
+    m_command.wakeAll();
+
+    while (m_pending > 0)
+    {
+        m_done.wait(&m_mutex);
+    }
+
+    m_time = newTime;
+
+    reduce();
+}
+
+void EnsembleStepper::stop()
+{
+    if (m_workers.isEmpty())
+    {
+        return;
+    }
+
+    m_mutex.lock();
+    m_quit = true;
+    ++m_generation;
+    m_command.wakeAll();
+    m_mutex.unlock();
+
+    for (int i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i]->wait();
+    }
+
+    qDeleteAll(m_workers);
+    m_workers.clear();
+}
+
+bool EnsembleStepper::isRunning() const
+{
+    return !m_workers.isEmpty();
+}
+
+double EnsembleStepper::time() const
+{
+    return m_time;
+}
+
+void EnsembleStepper::states(DoublePendulumState *out) const
+{
+    for (int i = 0; i < m_workers.size(); ++i)
+    {
+        const DoublePendulumArena& arena = m_workers[i]->arena();
+
+        memcpy(out, arena.states(), arena.count() * sizeof(DoublePendulumState));
+        out += arena.count();
+    }
+}
+
+double EnsembleStepper::meanEnergy() const
+{
+    return m_meanEnergy;
+}
+
+quint64 EnsembleStepper::checksum() const
+{
+    return m_checksum;
+}
+
+void EnsembleStepper::reduce()
+{
+    double energy = 0.0;
+    quint64 checksum = 0;
+
+    // In order, so that the sum is the same from run to run
+    for (int i = 0; i < m_energies.size(); ++i)
+    {
+        energy += m_energies[i];
+    }
+
+    for (int i = 0; i < m_checksums.size(); ++i)
+    {
+        checksum += m_checksums[i];
+    }
+
+    m_meanEnergy = (count() > 0) ? energy / count() : 0.0;
+    m_checksum = checksum;
+}
+
+void EnsembleStepper::workerDone()
+{
+    if (--m_pending == 0)
+    {
+        m_done.wakeAll();
+    }
+}
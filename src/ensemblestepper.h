@@ -0,0 +1,182 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ENSEMBLESTEPPER_H
+#define ENSEMBLESTEPPER_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "doublependulum.h"
+#include "doublependulumarena.h"
+
+/**
+ * Steps a large ensemble of pendula forward in lockstep across a set of
+ * long-lived worker threads.
+ *
+ * The initial conditions are split into one contiguous slice per worker,
+ * and each worker creates the pendula of its slice itself, in an arena of
+ * its own, so that with the kernel's first-touch policy their memory ends
+ * up on the NUMA node of the core stepping them.  For this to hold the
+ * workers must stay put, and so by default they are pinned, the i-th
+ * worker to the i-th entry of cpus() (or to core i if no cpus are given).
+ * For ensembles of millions of pendula the arenas may also be backed by
+ * huge pages; see DoublePendulumArena::PageMode.
+ *
+ * After each start() and advance() the workers also reduce the ensemble to
+ * its mean energy and a checksum of the states.  The states themselves do
+ * not depend on how the pendula are split between workers, and nor does
+ * the checksum, which is a sum of per-pendulum hashes, but by default the
+ * mean energy is summed per worker and so varies in its last bits with the
+ * thread count.  In deterministic mode the energy is instead summed over
+ * fixed chunks of CHUNK_SIZE pendula, which are then added up in order,
+ * making every result bitwise identical whatever the number of threads.
+ * The chunks are small, so the slices, which are cut on chunk boundaries,
+ * stay balanced to within a chunk.  (The build turns off FMA contraction so that the
+ * solvers and trig kernels round alike on every instruction set.)
+ *
+ * The threads, pinning, page mode and determinism take effect on the next
+ * start().
+ */
+class EnsembleStepper
+{
+public:
+    enum
+    {
+        /**
+         * Pendula per chunk in deterministic mode.
+         */
+        CHUNK_SIZE = 256
+    };
+
+    EnsembleStepper(const QString& solver, double dt, double g=9.81);
+    ~EnsembleStepper();
+
+    void addInitialCondition(const Pendulum& upper, const Pendulum& lower);
+    void clear();
+    int count() const;
+
+    int threadCount() const;
+    void setThreadCount(int threads);
+
+    bool pinThreads() const;
+    void setPinThreads(bool pin);
+
+    QVector<int> cpus() const;
+    void setCpus(const QVector<int>& cpus);
+
+    DoublePendulumArena::PageMode pageMode() const;
+    void setPageMode(DoublePendulumArena::PageMode pages);
+
+    bool isDeterministic() const;
+    void setDeterministic(bool deterministic);
+
+    /**
+     * Creates the pendula, blocking until every worker has built its slice.
+     */
+    void start();
+
+    /**
+     * Advances all of the pendula to newTime, blocking until they are there.
+     */
+    void advance(double newTime);
+
+    /**
+     * Destroys the pendula and stops the workers.
+     */
+    void stop();
+
+    bool isRunning() const;
+    double time() const;
+
+    /**
+     * Copies the current states into out, which must have room for count()
+     * of them, in the order in which they were added.
+     */
+    void states(DoublePendulumState *out) const;
+
+    /**
+     * Mean mechanical energy of the pendula at time().
+     */
+    double meanEnergy() const;
+
+    /**
+     * Checksum of the states at time(); for checking that two runs agree.
+     */
+    quint64 checksum() const;
+
+private:
+    // Owns its workers and so can not be copied
+    EnsembleStepper(const EnsembleStepper&);
+    EnsembleStepper& operator=(const EnsembleStepper&);
+
+    class Worker;
+    friend class Worker;
+
+    /**
+     * Called by the workers with the mutex held when their command is done.
+     */
+    void workerDone();
+
+    /**
+     * Combines the workers' partial results once they are done.
+     */
+    void reduce();
+
+    const QString m_solver;
+    const double m_dt;
+    const double m_g;
+
+    int m_threadCount;
+    bool m_pinThreads;
+    QVector<int> m_cpus;
+    DoublePendulumArena::PageMode m_pages;
+    bool m_deterministic;
+
+    QVector<Pendulum> m_upper, m_lower;
+
+    QVector<Worker *> m_workers;
+    double m_time;
+
+    /**
+     * Partial energy sums, one per chunk in deterministic mode and one per
+     * worker otherwise, and partial checksums, one per worker.
+     */
+    QVector<double> m_energies;
+    QVector<quint64> m_checksums;
+
+    double m_meanEnergy;
+    quint64 m_checksum;
+
+    /**
+     * Commands are issued by bumping m_generation under the mutex and waking
+     * the workers, who count m_pending down as they finish.
+     */
+    QMutex m_mutex;
+    QWaitCondition m_command;
+    QWaitCondition m_done;
+    int m_generation;
+    int m_pending;
+    double m_target;
+    bool m_quit;
+};
+
+#endif // ENSEMBLESTEPPER_H
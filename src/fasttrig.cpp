@@ -0,0 +1,250 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "fasttrig.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Largest argument which is reduced in-house
+    const double MAX_ARG = 1.0e5;
+
+    void sinCosLibm(const double *x, double *s, double *c, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            s[i] = sin(x[i]);
+            c[i] = cos(x[i]);
+        }
+    }
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    typedef double V2D __attribute__((vector_size(16)));
+    typedef unsigned long long V2U __attribute__((vector_size(16)));
+    typedef double V4D __attribute__((vector_size(32)));
+    typedef unsigned long long V4U __attribute__((vector_size(32)));
+    typedef double V8D __attribute__((vector_size(64)));
+    typedef unsigned long long V8U __attribute__((vector_size(64)));
+
+    // 2/π and 1.5·2⁵², adding which rounds to the nearest integer
+    const double TWO_OVER_PI = 6.36619772367581382433e-01;
+    const double ROUND = 6755399441055744.0;
+
+    // π/2 split so that k·PIO2_1 and k·PIO2_2 are exact for |k| < 2²⁰
+    const double PIO2_1  = 1.57079632673412561417e+00;
+    const double PIO2_1T = 6.07710050650619224932e-11;
+    const double PIO2_2  = 6.07710050630396597660e-11;
+    const double PIO2_2T = 2.02226624879595063154e-21;
+
+    // fdlibm kernel coefficients
+    const double S1 = -1.66666666666666324348e-01;
+    const double S2 =  8.33333333332248946124e-03;
+    const double S3 = -1.98412698298579493134e-04;
+    const double S4 =  2.75573137070700676789e-06;
+    const double S5 = -2.50507602534068634195e-08;
+    const double S6 =  1.58969099521155010221e-10;
+
+    const double C1 =  4.16666666666666019037e-02;
+    const double C2 = -1.38888888888741095749e-03;
+    const double C3 =  2.48015872894767294178e-05;
+    const double C4 = -2.75573143513906633035e-07;
+    const double C5 =  2.08757232129817482790e-09;
+    const double C6 = -1.13596475577881948265e-11;
+
+    /**
+     * Computes the sine and cosine of each lane of x; this is inlined into
+     * the per-instruction-set wrappers below so that it is compiled for each.
+     */
+    template <typename VD, typename VU>
+    inline __attribute__((always_inline))
+    void sinCosKernel(const VD& x, VD& s, VD& c, bool fast)
+    {
+        // Nearest multiple of π/2, k, and the quadrant, k mod 4
+        const VD kr = x * TWO_OVER_PI + ROUND;
+        const VD k = kr - ROUND;
+        const VU quadrant = (VU) kr & 3;
+
+        VD sinr, cosr;
+
+        if (fast)
+        {
+            const VD y = (x - k*PIO2_1) - k*PIO2_1T;
+            const VD z = y * y;
+
+            sinr = y + z*y*(S1 + z*(S2 + z*(S3 + z*S4)));
+            cosr = 1.0 - 0.5*z + z*z*(C1 + z*(C2 + z*C3));
+        }
+        else
+        {
+            // Reduce to y0 + y1 in double-double precision
+            const VD t = x - k*PIO2_1;
+            VD w = k * PIO2_2;
+            const VD r = t - w;
+            w = k*PIO2_2T - ((t - r) - w);
+
+            const VD y0 = r - w;
+            const VD y1 = (r - y0) - w;
+
+            const VD z = y0 * y0;
+            const VD zz = z * z;
+            const VD v = z * y0;
+
+            const VD rs = S2 + z*(S3 + z*S4) + z*zz*(S5 + z*S6);
+            sinr = y0 - ((z*(0.5*y1 - v*rs) - y1) - v*S1);
+
+            const VD rc = z*(C1 + z*(C2 + z*C3)) + zz*zz*(C4 + z*(C5 + z*C6));
+            const VD hz = 0.5 * z;
+            const VD ww = 1.0 - hz;
+            cosr = ww + (((1.0 - ww) - hz) + (z*rc - y0*y1));
+        }
+
+        // Odd quadrants swap sin and cos; the signs follow from bit 1 of
+        // k for sin and of k + 1 for cos
+        const VU swap = (VU) ((quadrant & 1) != 0);
+        const VU sinSign = (quadrant & 2) << 62;
+        const VU cosSign = ((quadrant + 1) & 2) << 62;
+
+        s = (VD) ((((VU) cosr & swap) | ((VU) sinr & ~swap)) ^ sinSign);
+        c = (VD) ((((VU) sinr & swap) | ((VU) cosr & ~swap)) ^ cosSign);
+    }
+
+    template <typename VD, typename VU, int W>
+    inline __attribute__((always_inline))
+    void sinCosBatch(const double *x, double *s, double *c, int n, bool fast)
+    {
+        for (int i = 0; i < n; i += W)
+        {
+            const int m = (n - i < W) ? n - i : W;
+
+            double xb[W], sb[W], cb[W];
+
+            for (int j = 0; j < W; ++j)
+            {
+                xb[j] = (j < m) ? x[i + j] : 0.0;
+            }
+
+            VD xv, sv, cv;
+            memcpy(&xv, xb, sizeof(xv));
+
+            sinCosKernel<VD, VU>(xv, sv, cv, fast);
+
+            memcpy(sb, &sv, sizeof(sv));
+            memcpy(cb, &cv, sizeof(cv));
+
+            for (int j = 0; j < m; ++j)
+            {
+                // Also catches NaNs
+                if (fabs(xb[j]) <= MAX_ARG)
+                {
+                    s[i + j] = sb[j];
+                    c[i + j] = cb[j];
+                }
+                else
+                {
+                    sinCosLibm(&xb[j], &s[i + j], &c[i + j], 1);
+                }
+            }
+        }
+    }
+
+    // At two lanes the double-double reduction of the faithful mode costs
+    // about as much as libm, so only the fast mode is vectorised
+    __attribute__((target("sse2")))
+    void sinCosSSE2(const double *x, double *s, double *c, int n, bool fast)
+    {
+        if (fast)
+        {
+            sinCosBatch<V2D, V2U, 2>(x, s, c, n, true);
+        }
+        else
+        {
+            sinCosLibm(x, s, c, n);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void sinCosAVX2(const double *x, double *s, double *c, int n, bool fast)
+    {
+        sinCosBatch<V4D, V4U, 4>(x, s, c, n, fast);
+    }
+
+    __attribute__((target("avx512f")))
+    void sinCosAVX512(const double *x, double *s, double *c, int n, bool fast)
+    {
+        sinCosBatch<V8D, V8U, 8>(x, s, c, n, fast);
+    }
+#endif
+
+    typedef void (*SinCosFunction)(const double *, double *, double *, int,
+                                   bool);
+
+    struct Implementation
+    {
+        SinCosFunction function;
+        const char *name;
+    };
+
+    void sinCosScalar(const double *x, double *s, double *c, int n, bool)
+    {
+        sinCosLibm(x, s, c, n);
+    }
+
+    Implementation selectImplementation()
+    {
+        Implementation impl = { sinCosScalar, "libm" };
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            impl.function = sinCosAVX512;
+            impl.name = "AVX-512";
+        }
+        else if (__builtin_cpu_supports("avx2"))
+        {
+            impl.function = sinCosAVX2;
+            impl.name = "AVX2";
+        }
+        else if (__builtin_cpu_supports("sse2"))
+        {
+            impl.function = sinCosSSE2;
+            impl.name = "SSE2";
+        }
+#endif
+
+        return impl;
+    }
+
+    // Chosen once, when the program is loaded
+    const Implementation implementation = selectImplementation();
+}
+
+void FastTrig::sinCos(const double *x, double *s, double *c, int n,
+                      Accuracy accuracy)
+{
+    implementation.function(x, s, c, n, accuracy == Fast);
+}
+
+const char *FastTrig::instructionSet()
+{
+    return implementation.name;
+}
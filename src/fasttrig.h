@@ -0,0 +1,67 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef FASTTRIG_H
+#define FASTTRIG_H
+
+/**
+ * Vectorised sin/cos for batches of angles.
+ *
+ * Arguments are reduced modulo π/2 with a Cody-Waite scheme and then fed
+ * to minimax polynomials on [-π/4, π/4] (those of fdlibm), with the
+ * quadrant applied branch-free.  The kernel is written once using GCC
+ * vector extensions and compiled for SSE2, AVX2 and AVX-512, with the
+ * widest one supported by the CPU picked at run time; other compilers and
+ * architectures fall back to libm, as does the faithful mode on CPUs with
+ * only SSE2.
+ *
+ * Arguments too large to be reduced accurately (|x| > 1e5) and non-finite
+ * ones are passed to libm.
+ */
+class FastTrig
+{
+public:
+    enum Accuracy
+    {
+        /**
+         * Within 1 ULP; reduction is carried out in double-double precision
+         * and the full fdlibm polynomials are used.
+         */
+        Faithful,
+
+        /**
+         * Relative error below 1e-7; single-word reduction and truncated
+         * polynomials.
+         */
+        Fast
+    };
+
+    /**
+     * Computes s[i] = sin x[i] and c[i] = cos x[i] for i < n.
+     */
+    static void sinCos(const double *x, double *s, double *c, int n,
+                       Accuracy accuracy=Faithful);
+
+    /**
+     * Returns the name of the instruction set which sinCos() is using.
+     */
+    static const char *instructionSet();
+};
+
+#endif // FASTTRIG_H
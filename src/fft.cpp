@@ -0,0 +1,68 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "fft.h"
+
+#include <cmath>
+#include <cassert>
+
+void FFT::transform(std::complex<double> *data, int n)
+{
+    assert(isPowerOfTwo(n));
+
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; ++i)
+    {
+        int bit = n >> 1;
+
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+
+        j ^= bit;
+
+        if (i < j)
+        {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    // Butterflies; the twiddle factors are computed directly rather than
+    // by recurrence so that the error does not grow with n
+    for (int len = 2; len <= n; len <<= 1)
+    {
+        const int half = len >> 1;
+        const double theta = -2.0 * 3.14159265358979323846 / len;
+
+        for (int j = 0; j < half; ++j)
+        {
+            const std::complex<double> w(cos(theta * j), sin(theta * j));
+
+            for (int i = j; i < n; i += len)
+            {
+                const std::complex<double> u = data[i];
+                const std::complex<double> v = data[i + half] * w;
+
+                data[i] = u + v;
+                data[i + half] = u - v;
+            }
+        }
+    }
+}
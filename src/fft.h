@@ -0,0 +1,43 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+
+/**
+ * In-place iterative radix-2 fast Fourier transform.
+ */
+class FFT
+{
+public:
+    /**
+     * Replaces data, of length n (a power of two), with its forward discrete
+     * Fourier transform, X_k = Σ x_m exp(-2πikm/n).
+     */
+    static void transform(std::complex<double> *data, int n);
+
+    static bool isPowerOfTwo(int n)
+    {
+        return n > 0 && (n & (n - 1)) == 0;
+    }
+};
+
+#endif // FFT_H
@@ -0,0 +1,81 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "lyapunovensemble.h"
+#include "doublependulumlyapunov.h"
+
+#include <QtConcurrentMap>
+
+LyapunovEnsemble::LyapunovEnsemble(double dt, double g, int orthoInterval)
+    : m_dt(dt)
+    , m_g(g)
+    , m_orthoInterval(orthoInterval)
+{
+}
+
+void LyapunovEnsemble::addInitialCondition(const Pendulum& upper,
+                                           const Pendulum& lower)
+{
+    Job job;
+    job.upper = upper;
+    job.lower = lower;
+
+    m_jobs.append(job);
+}
+
+void LyapunovEnsemble::clear()
+{
+    m_jobs.clear();
+}
+
+int LyapunovEnsemble::count() const
+{
+    return m_jobs.count();
+}
+
+QVector<LyapunovSpectrum> LyapunovEnsemble::run(double duration)
+{
+    for (int i = 0; i < m_jobs.count(); ++i)
+    {
+        m_jobs[i].dt = m_dt;
+        m_jobs[i].g = m_g;
+        m_jobs[i].duration = duration;
+        m_jobs[i].orthoInterval = m_orthoInterval;
+    }
+
+    // Each trajectory is independent so simply map them over the thread pool
+    QtConcurrent::blockingMap(m_jobs, LyapunovEnsemble::runJob);
+
+    QVector<LyapunovSpectrum> spectra(m_jobs.count());
+    for (int i = 0; i < m_jobs.count(); ++i)
+    {
+        spectra[i] = m_jobs[i].result;
+    }
+
+    return spectra;
+}
+
+void LyapunovEnsemble::runJob(Job& job)
+{
+    DoublePendulumLyapunov p(job.upper, job.lower, job.dt, job.g,
+                             job.orthoInterval);
+
+    p.update(job.duration);
+    p.exponents(job.result.lambda);
+}
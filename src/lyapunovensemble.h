@@ -0,0 +1,73 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef LYAPUNOVENSEMBLE_H
+#define LYAPUNOVENSEMBLE_H
+
+#include <QVector>
+
+#include "doublependulum.h"
+
+/**
+ * The Lyapunov spectrum of a single trajectory, largest exponent first.
+ */
+struct LyapunovSpectrum
+{
+    double lambda[4];
+};
+
+/**
+ * Computes the Lyapunov spectra of many initial conditions at once, the
+ * trajectories being farmed out across all available cores.
+ */
+class LyapunovEnsemble
+{
+public:
+    LyapunovEnsemble(double dt=0.005, double g=9.81, int orthoInterval=10);
+
+    void addInitialCondition(const Pendulum& upper, const Pendulum& lower);
+    void clear();
+    int count() const;
+
+    /**
+     * Integrates each initial condition for the given duration (in s) and
+     * returns their spectra in the order they were added.  Blocks until all
+     * of the trajectories are complete.
+     */
+    QVector<LyapunovSpectrum> run(double duration);
+
+private:
+    struct Job
+    {
+        Pendulum upper, lower;
+        double dt, g, duration;
+        int orthoInterval;
+        LyapunovSpectrum result;
+    };
+
+    static void runJob(Job& job);
+
+    const double m_dt;
+    const double m_g;
+    const int m_orthoInterval;
+
+    QVector<Job> m_jobs;
+};
+
+#endif // LYAPUNOVENSEMBLE_H
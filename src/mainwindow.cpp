@@ -19,9 +19,14 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "spectralanalyser.h"
+#include "recurrenceanalyser.h"
+#include "ensembledialog.h"
 
 #include <cmath>
 
+#include <QApplication>
+#include <QDockWidget>
 #include <QPixmap>
 #include <QMessageBox>
 #include <QDesktopServices>
@@ -29,17 +34,34 @@
 
 #include <QDebug>
 
+namespace
+{
+    // Number of pendula given their own section, spectrum, chart and
+    // recurrence plots
+    const int MAX_PLOTTED_PENDULA = 16;
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindowClass)
     , m_statusBarTimer(new QTimer(this))
     , m_statusBarTime(new QLabel(this))
     , m_statusBarFps(new QLabel(this))
+    , m_sectionView(new PoincareSectionWidget(this))
+    , m_spectrumView(new SpectrogramWidget(this))
+    , m_chartView(new StripChartWidget(this))
+    , m_densityView(new PhaseDensityWidget(this))
+    , m_recurrenceView(new RecurrencePlotWidget(this))
+    , m_tuning(false)
     , m_pendulumCount(0)
     , m_maskUpdates(false)
 {
     ui->setupUi(this);
 
+    // List of pendula, backed by the registry of the pendulum view
+    m_pendulumModel = new PendulumListModel(ui->pendulumView, this);
+    ui->pendulums->setModel(m_pendulumModel);
+
     // Create a timer to update the status bar
     connect(m_statusBarTimer, SIGNAL(timeout()), this, SLOT(updateStatusBar()));
 
@@ -61,13 +83,55 @@ MainWindow::MainWindow(QWidget *parent)
     // Showing/hiding the settings dock
     ui->menuView->addAction(ui->dockWidget_model->toggleViewAction());
 
+    // Poincaré section dock
+    QDockWidget *sectionDock = new QDockWidget(QString::fromUtf8("Poincaré Section"),
+                                               this);
+    sectionDock->setObjectName("dockWidget_section");
+    sectionDock->setWidget(m_sectionView);
+    addDockWidget(Qt::RightDockWidgetArea, sectionDock);
+    ui->menuView->addAction(sectionDock->toggleViewAction());
+
+    // Spectrogram dock
+    QDockWidget *spectrumDock = new QDockWidget(tr("Spectrogram"), this);
+    spectrumDock->setObjectName("dockWidget_spectrum");
+    spectrumDock->setWidget(m_spectrumView);
+    addDockWidget(Qt::RightDockWidgetArea, spectrumDock);
+    ui->menuView->addAction(spectrumDock->toggleViewAction());
+
+    // Strip chart dock
+    QDockWidget *chartDock = new QDockWidget(tr("Time Series"), this);
+    chartDock->setObjectName("dockWidget_chart");
+    chartDock->setWidget(m_chartView);
+    addDockWidget(Qt::BottomDockWidgetArea, chartDock);
+    ui->menuView->addAction(chartDock->toggleViewAction());
+
+    // Phase space density dock
+    QDockWidget *densityDock = new QDockWidget(tr("Phase Density"), this);
+    densityDock->setObjectName("dockWidget_density");
+    densityDock->setWidget(m_densityView);
+    addDockWidget(Qt::RightDockWidgetArea, densityDock);
+    ui->menuView->addAction(densityDock->toggleViewAction());
+
+    // Recurrence plot dock
+    QDockWidget *recurrenceDock = new QDockWidget(tr("Recurrence Plot"), this);
+    recurrenceDock->setObjectName("dockWidget_recurrence");
+    recurrenceDock->setWidget(m_recurrenceView);
+    addDockWidget(Qt::RightDockWidgetArea, recurrenceDock);
+    ui->menuView->addAction(recurrenceDock->toggleViewAction());
+
     // Adding/removing pendulums
     connect(ui->toolButton_addPendulum, SIGNAL(clicked()),
             this, SLOT(addPendulum()));
+    connect(ui->toolButton_addEnsemble, SIGNAL(clicked()),
+            this, SLOT(addEnsemble()));
+
+    connect(&m_tunerWatcher, SIGNAL(finished()),
+            this, SLOT(tuningFinished()));
     connect(ui->toolButton_removePendulum, SIGNAL(clicked()),
             this, SLOT(removePendulum()));
-    connect(ui->pendulums, SIGNAL(currentIndexChanged(int)),
-            this, SLOT(changePendulum(int)));
+    connect(ui->pendulums->selectionModel(),
+            SIGNAL(currentChanged(QModelIndex, QModelIndex)),
+            this, SLOT(changePendulum()));
 
     // Starting/stopping/pausing the simulation
     connect(ui->actionStart, SIGNAL(triggered()), this, SLOT(startSim()));
@@ -79,6 +143,22 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->actionZoomOut, SIGNAL(triggered()), this, SLOT(zoomOut()));
     connect(ui->actionBestFit, SIGNAL(triggered()), this, SLOT(zoomBestFit()));
 
+    // Time warp, on the toolbar so that it can be changed while running
+    m_timeWarp = new QComboBox(this);
+    m_timeWarp->setToolTip(tr("Rate of simulated time to real time"));
+
+    const int warps[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+
+    for (unsigned i = 0; i < sizeof(warps) / sizeof(warps[0]); ++i)
+    {
+        m_timeWarp->addItem(QString("%1x").arg(warps[i]), warps[i]);
+    }
+
+    ui->mainToolBar->addSeparator();
+    ui->mainToolBar->addWidget(m_timeWarp);
+    connect(m_timeWarp, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(changeTimeWarp(int)));
+
     // Update ODE solving method
     connect(ui->odeSolver, SIGNAL(currentIndexChanged(QString)), this, SLOT(updatePendulum()));
 
@@ -86,6 +166,11 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->dt, SIGNAL(valueChanged(double)), this, SLOT(updatePendulum()));
     connect(ui->g, SIGNAL(valueChanged(double)), this, SLOT(updatePendulum()));
 
+    // Update the automatic choice of solver and dt
+    connect(ui->autoTune, SIGNAL(toggled(bool)), this, SLOT(updatePendulum()));
+    connect(ui->energyBudget, SIGNAL(valueChanged(double)), this, SLOT(updatePendulum()));
+    connect(ui->horizon, SIGNAL(valueChanged(double)), this, SLOT(updatePendulum()));
+
     // Updating initial starting conditions (upper bob)
     connect(ui->theta1, SIGNAL(valueChanged(double)), this, SLOT(updatePendulum()));
     connect(ui->omega1, SIGNAL(valueChanged(double)), this, SLOT(updatePendulum()));
@@ -116,6 +201,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // The probes refer to the tuner, so must be done with before it goes
+    m_tunerWatcher.cancel();
+    m_tunerWatcher.waitForFinished();
+
     delete ui;
 }
 
@@ -145,7 +234,7 @@ void MainWindow::webPage()
 
 DoublePendulumItem *MainWindow::activeItem()
 {
-    return ui->pendulumView->pendula()[ui->pendulums->currentText()];
+    return m_pendulumModel->item(ui->pendulums->currentIndex());
 }
 
 void MainWindow::resetStatusBar()
@@ -157,80 +246,145 @@ void MainWindow::resetStatusBar()
 
 void MainWindow::addPendulum()
 {
+    if (m_pendulumModel->rowCount() >= PendulumRegistry::CAPACITY)
+    {
+        QMessageBox::warning(this, tr("Add Pendulum"),
+                             tr("No more pendula may be added."));
+        return;
+    }
+
     // Create a new pendulum
     DoublePendulumItem *pendulum = new DoublePendulumItem();
 
     // Generate the name of the new pendulum
     QString name = QString("Pendulum %1").arg(++m_pendulumCount);
 
-    // Add the pendulum to the scene
-    ui->pendulumView->addPendulum(name, pendulum);
-
-    // Add an item in the Pendulum's combo box for the new pendulum
-    ui->pendulums->addItem(name);
-
-    // Get the index of the newly added item
-    int index = ui->pendulums->findText(name);
-
-    // Make this the selected item
-    ui->pendulums->setCurrentIndex(index);
+    // Add the pendulum to the scene and list, making it the selected item
+    ui->pendulums->setCurrentIndex(m_pendulumModel->addPendulum(name, pendulum));
 
     // Set the values to the defaults
     setDefaults();
 
     // Enable the remove button if there are >= 2 pendulums present
-    if (ui->pendulums->count() >= 2)
+    if (m_pendulumModel->rowCount() >= 2)
     {
         ui->toolButton_removePendulum->setEnabled(true);
     }
 }
 
-void MainWindow::removePendulum()
+void MainWindow::addEnsemble()
 {
+    // The ensemble is made of variations on the selected pendulum
     DoublePendulumItem *active = activeItem();
+    EnsembleDialog dialog(active->upper(), active->lower(), this);
+
+    if (dialog.exec() != QDialog::Accepted)
+    {
+        return;
+    }
+
+    const EnsembleGenerator generator = dialog.generator();
+    const int count = generator.count();
+
+    if (count > PendulumRegistry::CAPACITY - m_pendulumModel->rowCount())
+    {
+        QMessageBox::warning(this, tr("Add Ensemble"),
+                             tr("There is only room for %1 more pendula.")
+                             .arg(PendulumRegistry::CAPACITY
+                                  - m_pendulumModel->rowCount()));
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    QStringList names;
+    QList<DoublePendulumItem *> items;
+
+    names.reserve(count);
+    items.reserve(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        DoublePendulumItem *item = new DoublePendulumItem();
+
+        generator.generate(i, &item->upper(), &item->lower());
 
-    // Remove the item from the scene
-    ui->pendulumView->removePendulum(ui->pendulums->currentText());
+        item->setSolver(active->solver());
+        item->setDt(active->dt());
+        item->setG(active->g());
+        item->setAutoTune(active->autoTune());
+        item->setEnergyBudget(active->energyBudget());
+        item->setHorizon(active->horizon());
+        item->setOpacity(active->opacity());
 
-    // Release the memory associated with item
-    delete active;
+        // Spread the members of the ensemble around the colour wheel
+        const double hue = double(i) / count;
 
-    // Remove the item from the combo box
-    ui->pendulums->removeItem(ui->pendulums->currentIndex());
+        item->setUpperColour(QColor::fromHsvF(hue, 1.0, 1.0));
+        item->setLowerColour(QColor::fromHsvF(fmod(hue + 0.3, 1.0), 1.0, 1.0));
+
+        names << QString("Pendulum %1").arg(++m_pendulumCount);
+        items << item;
+    }
+
+    // Add them all at once, selecting the first
+    ui->pendulums->setCurrentIndex(m_pendulumModel->addPendula(names, items));
+    ui->toolButton_removePendulum->setEnabled(m_pendulumModel->rowCount() >= 2);
+
+    QApplication::restoreOverrideCursor();
+}
+
+void MainWindow::removePendulum()
+{
+    // Remove the item from the scene and list and release its memory
+    delete m_pendulumModel->removePendulum(ui->pendulums->currentIndex().row());
 
     // If there is only one pendulum left, disable the button
-    if (ui->pendulums->count() == 1)
+    if (m_pendulumModel->rowCount() == 1)
     {
         ui->toolButton_removePendulum->setEnabled(false);
     }
 }
 
-void MainWindow::changePendulum(int)
+void MainWindow::changePendulum()
 {
+    DoublePendulumItem *item = activeItem();
+
+    if (!item)
+    {
+        return;
+    }
+
     // Mask update events
     m_maskUpdates = true;
 
     // Update the solver
-    ui->odeSolver->setCurrentIndex(ui->odeSolver->findText(activeItem()->solver()));
+    ui->odeSolver->setCurrentIndex(ui->odeSolver->findText(item->solver()));
 
     // dt & g
-    ui->dt->setValue(activeItem()->dt());
-    ui->g->setValue(activeItem()->g());
+    ui->dt->setValue(item->dt());
+    ui->g->setValue(item->g());
+
+    // Automatic tuning, with the budget shown as a percentage
+    ui->autoTune->setChecked(item->autoTune());
+    ui->energyBudget->setValue(100.0 * item->energyBudget());
+    ui->horizon->setValue(item->horizon());
+    updateAutoTuneControls();
 
     // Update the spin-box values
-    ui->theta1->setValue(activeItem()->upper().theta);
-    ui->omega1->setValue(activeItem()->upper().omega);
-    ui->m1->setValue(activeItem()->upper().m);
-    ui->l1->setValue(activeItem()->upper().l);
+    ui->theta1->setValue(item->upper().theta);
+    ui->omega1->setValue(item->upper().omega);
+    ui->m1->setValue(item->upper().m);
+    ui->l1->setValue(item->upper().l);
 
-    ui->theta2->setValue(activeItem()->lower().theta);
-    ui->omega2->setValue(activeItem()->lower().omega);
-    ui->m2->setValue(activeItem()->lower().m);
-    ui->l2->setValue(activeItem()->lower().l);
+    ui->theta2->setValue(item->lower().theta);
+    ui->omega2->setValue(item->lower().omega);
+    ui->m2->setValue(item->lower().m);
+    ui->l2->setValue(item->lower().l);
 
-    ui->lowerColour->setColour(activeItem()->lowerColour());
-    ui->upperColour->setColour(activeItem()->upperColour());
-    ui->opacity->setValue(activeItem()->opacity());
+    ui->lowerColour->setColour(item->lowerColour());
+    ui->upperColour->setColour(item->upperColour());
+    ui->opacity->setValue(item->opacity());
 
     // Unmask updates
     m_maskUpdates = false;
@@ -242,10 +396,24 @@ void MainWindow::startSim()
     ui->actionStart->setEnabled(false);
     ui->dockWidgetContents_model->setEnabled(false);
 
-    // Enable the stop and pause actions
-    ui->actionPause->setEnabled(true);
+    // Enable the stop action; pausing has to wait until we are running
     ui->actionStop->setEnabled(true);
 
+    // Pick solvers and step sizes first, as the observers depend on dt;
+    // the probes run in the background, keeping the GUI responsive
+    m_tuning = tunePendula();
+
+    if (!m_tuning)
+    {
+        beginSim();
+    }
+}
+
+void MainWindow::beginSim()
+{
+    // Enable the pause action
+    ui->actionPause->setEnabled(true);
+
     // Enable the zoom controls
     ui->actionZoomIn->setEnabled(true);
     ui->actionZoomOut->setEnabled(true);
@@ -254,9 +422,130 @@ void MainWindow::startSim()
     // Start updating the status bar
     m_statusBarTimer->start(75);
 
+    // Plot each pendulum's section points in the colour of its lower bob,
+    // and likewise give each one a spectral analyser, a strip chart recorder
+    // and a recurrence analyser.  These all keep a good deal of state per
+    // pendulum and a plot of thousands of pendula is unreadable anyway, so
+    // only the first few of a large ensemble get them.
+    //
+    // Every pendulum contributes to the phase density, binning the state at
+    // each step of the fixed step solvers (or as often for the adaptive
+    // ones, so that the density is not skewed by their step size control)
+    m_sectionView->clear();
+    m_spectrumView->clear();
+    m_chartView->clear();
+    m_densityView->clear();
+    m_recurrenceView->clear();
+
+    const PendulumRegistry& pendula = ui->pendulumView->pendula();
+    DoublePendulumObserver *densitySampler = m_densityView->createSampler();
+
+    for (int i = 0; i < pendula.count(); ++i)
+    {
+        DoublePendulumItem *item = pendula.at(i);
+
+        item->clearObservers();
+        item->addObserver(densitySampler, item->dt());
+
+        if (i >= MAX_PLOTTED_PENDULA)
+        {
+            item->setSectionListener(0);
+            continue;
+        }
+
+        item->setSectionListener(m_sectionView->createListener(item->lowerColour()));
+
+        SpectralAnalyser *analyser = m_spectrumView->createAnalyser(item->lowerColour());
+        item->addObserver(analyser, analyser->sampleInterval());
+
+        item->addObserver(m_chartView->createRecorder(item->lowerColour()),
+                          m_chartView->sampleInterval());
+
+        RecurrenceAnalyser *recurrence = m_recurrenceView->createAnalyser(item->lowerColour());
+        item->addObserver(recurrence, recurrence->sampleInterval());
+    }
+
     ui->pendulumView->startSim();
 }
 
+void MainWindow::updateAutoTuneControls()
+{
+    const bool autoTune = ui->autoTune->isChecked();
+
+    // The solver and dt are chosen for us when tuning
+    ui->odeSolver->setEnabled(!autoTune);
+    ui->dt->setEnabled(!autoTune);
+    ui->energyBudget->setEnabled(autoTune);
+    ui->horizon->setEnabled(autoTune);
+}
+
+bool MainWindow::tunePendula()
+{
+    const PendulumRegistry& pendula = ui->pendulumView->pendula();
+
+    m_tuner.clear();
+    m_tuned.clear();
+
+    for (int i = 0; i < pendula.count(); ++i)
+    {
+        DoublePendulumItem *item = pendula.at(i);
+
+        if (item->autoTune())
+        {
+            m_tuner.addPendulum(item->upper(), item->lower(), item->g(),
+                                item->energyBudget(), item->horizon());
+            m_tuned << item;
+        }
+    }
+
+    if (m_tuned.isEmpty())
+    {
+        return false;
+    }
+
+    statusBar()->showMessage(tr("Tuning the step sizes..."));
+    m_tunerWatcher.setFuture(m_tuner.start());
+
+    return true;
+}
+
+void MainWindow::tuningFinished()
+{
+    // Stopped before the choices could be used
+    if (!m_tuning)
+    {
+        return;
+    }
+
+    m_tuning = false;
+    statusBar()->clearMessage();
+
+    const QVector<DtChoice> choices = m_tuner.results();
+    int overBudget = 0;
+
+    for (int i = 0; i < m_tuned.count(); ++i)
+    {
+        m_tuned[i]->setSolver(choices[i].solver);
+        m_tuned[i]->setDt(choices[i].dt);
+
+        if (!choices[i].withinBudget)
+        {
+            ++overBudget;
+        }
+    }
+
+    // Show the choice for the selected pendulum
+    changePendulum();
+
+    if (overBudget > 0)
+    {
+        statusBar()->showMessage(tr("%1 pendula can not meet their energy "
+                                    "budget").arg(overBudget), 5000);
+    }
+
+    beginSim();
+}
+
 void MainWindow::pauseSim()
 {
     ui->pendulumView->pauseSim();
@@ -264,6 +553,17 @@ void MainWindow::pauseSim()
 
 void MainWindow::stopSim()
 {
+    // Abandon any tuning still under way; finished() may follow, even
+    // if the probes are already done, but is ignored
+    if (m_tuning)
+    {
+        m_tuning = false;
+        statusBar()->clearMessage();
+
+        m_tunerWatcher.cancel();
+        m_tunerWatcher.waitForFinished();
+    }
+
     // Enable the options dock and start buttons again
     ui->actionStart->setEnabled(true);
     ui->dockWidgetContents_model->setEnabled(true);
@@ -309,6 +609,11 @@ void MainWindow::zoomBestFit()
     ui->pendulumView->setScaleFactor(idealScale);
 }
 
+void MainWindow::changeTimeWarp(int index)
+{
+    ui->pendulumView->setTimeWarp(m_timeWarp->itemData(index).toDouble());
+}
+
 void MainWindow::useOpenGL(bool on)
 {
     if (on)
@@ -342,6 +647,12 @@ void MainWindow::updatePendulum()
     item->setDt(ui->dt->value());
     item->setG(ui->g->value());
 
+    // Automatic tuning
+    item->setAutoTune(ui->autoTune->isChecked());
+    item->setEnergyBudget(ui->energyBudget->value() / 100.0);
+    item->setHorizon(ui->horizon->value());
+    updateAutoTuneControls();
+
     // Upper bob
     item->upper().theta = ui->theta1->value();
     item->upper().omega = ui->omega1->value();
@@ -362,15 +673,8 @@ void MainWindow::updatePendulum()
 
 void MainWindow::updatePendulumIcon()
 {
-    int index = ui->pendulums->currentIndex();
-
-    QPixmap pm(ui->pendulums->iconSize());
-    QPainter painter(&pm);
-
-    activeItem()->drawIcon(&painter, pm.rect());
-
-    // Set the icon to be the generated pixmap
-    ui->pendulums->setItemIcon(index, QIcon(pm));
+    // The list draws its icons on demand, so just tell it to redraw
+    m_pendulumModel->itemChanged(ui->pendulums->currentIndex());
 }
 
 void MainWindow::updateStatusBar()
@@ -401,6 +705,10 @@ void MainWindow::setDefaults()
     ui->dt->setValue(0.005);
     ui->g->setValue(9.81);
 
+    ui->autoTune->setChecked(false);
+    ui->energyBudget->setValue(0.1);
+    ui->horizon->setValue(600.0);
+
     ui->theta1->setValue(1.0);
     ui->omega1->setValue(0.0);
     ui->m1->setValue(1.0);
@@ -20,6 +20,9 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QComboBox>
+#include <QFutureWatcher>
+#include <QList>
 #include <QMainWindow>
 #include <QTimer>
 #include <QLabel>
@@ -28,6 +31,13 @@
 #include <QColor>
 
 #include "doublependulumitem.h"
+#include "dttuner.h"
+#include "pendulumlistmodel.h"
+#include "phasedensitywidget.h"
+#include "poincaresectionwidget.h"
+#include "recurrenceplotwidget.h"
+#include "spectrogramwidget.h"
+#include "stripchartwidget.h"
 
 namespace Ui
 {
@@ -47,6 +57,19 @@ protected:
 
     void resetStatusBar();
 
+    void updateAutoTuneControls();
+
+    /**
+     * Starts DtTuner on the pendula which are to be tuned, returning false
+     * if there are none; tuningFinished() follows once it is done.
+     */
+    bool tunePendula();
+
+    /**
+     * Attaches the analysers to the pendula and sets them going.
+     */
+    void beginSim();
+
     static QPair<QColor, QColor> randBobColour();
 
 protected slots:
@@ -54,17 +77,22 @@ protected slots:
     void webPage();
 
     void addPendulum();
+    void addEnsemble();
     void removePendulum();
-    void changePendulum(int index);
+    void changePendulum();
 
     void startSim();
     void pauseSim();
     void stopSim();
 
+    void tuningFinished();
+
     void zoomIn();
     void zoomOut();
     void zoomBestFit();
 
+    void changeTimeWarp(int index);
+
     void useOpenGL(bool on);
 
     void updatePendulumIcon();
@@ -83,6 +111,26 @@ private:
     QLabel *m_statusBarTime;
     QLabel *m_statusBarFps;
 
+    QComboBox *m_timeWarp;
+
+    PendulumListModel *m_pendulumModel;
+
+    PoincareSectionWidget *m_sectionView;
+    SpectrogramWidget *m_spectrumView;
+    StripChartWidget *m_chartView;
+    PhaseDensityWidget *m_densityView;
+    RecurrencePlotWidget *m_recurrenceView;
+
+    DtTuner m_tuner;
+    QFutureWatcher<void> m_tunerWatcher;
+    QList<DoublePendulumItem *> m_tuned;
+
+    /**
+     * Set while a start is waiting on the tuner; cleared by a stop, as
+     * finished() may still be on its way after the probes are done.
+     */
+    bool m_tuning;
+
     int m_pendulumCount;
     bool m_maskUpdates;
 };
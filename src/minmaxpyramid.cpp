@@ -0,0 +1,134 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "minmaxpyramid.h"
+
+#include <limits>
+
+MinMaxPyramid::MinMaxPyramid()
+{
+}
+
+void MinMaxPyramid::clear()
+{
+    m_levels.clear();
+}
+
+void MinMaxPyramid::append(float value)
+{
+    if (m_levels.isEmpty())
+    {
+        m_levels.append(QVector<float>());
+    }
+
+    m_levels[0].append(value);
+
+    // Each time a level completes a pair of entries summarise them in the
+    // level above, which may in turn complete a pair of its own
+    for (int l = 0; ; ++l)
+    {
+        const QVector<float>& level = m_levels.at(l);
+        const int stride = (l == 0) ? 1 : 2;
+        const int n = level.size() / stride;
+
+        if (n % 2 != 0)
+        {
+            break;
+        }
+
+        float lo, hi;
+
+        if (l == 0)
+        {
+            lo = qMin(level.at(n - 2), level.at(n - 1));
+            hi = qMax(level.at(n - 2), level.at(n - 1));
+        }
+        else
+        {
+            lo = qMin(level.at(2*n - 4), level.at(2*n - 2));
+            hi = qMax(level.at(2*n - 3), level.at(2*n - 1));
+        }
+
+        if (m_levels.size() == l + 1)
+        {
+            m_levels.append(QVector<float>());
+        }
+
+        m_levels[l + 1].append(lo);
+        m_levels[l + 1].append(hi);
+    }
+}
+
+void MinMaxPyramid::minMax(long first, long last, float *min, float *max) const
+{
+    *min = std::numeric_limits<float>::max();
+    *max = -std::numeric_limits<float>::max();
+
+    first = qMax(first, 0L);
+    last = qMin(last, count() - 1);
+
+    if (first > last)
+    {
+        return;
+    }
+
+    // Pick the level whose blocks are the largest no longer than the range
+    int l = 0;
+
+    while (l + 1 < m_levels.size() && (2L << l) <= last - first + 1)
+    {
+        ++l;
+    }
+
+    long i = first >> l;
+
+    for (;; --l)
+    {
+        const QVector<float>& level = m_levels.at(l);
+        const long end = last >> l;
+
+        if (l == 0)
+        {
+            for (long j = i; j <= end; ++j)
+            {
+                *min = qMin(*min, level.at(j));
+                *max = qMax(*max, level.at(j));
+            }
+
+            break;
+        }
+
+        // Only complete blocks are present, so the tail of the range may
+        // need to be found from the level below
+        const long n = level.size() / 2;
+
+        for (long j = i; j <= end && j < n; ++j)
+        {
+            *min = qMin(*min, level.at(2*j));
+            *max = qMax(*max, level.at(2*j + 1));
+        }
+
+        if (end < n)
+        {
+            break;
+        }
+
+        i = qMax(i, n) << 1;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QVector>
+
+/**
+ * A series of evenly spaced samples stored along with a multi-resolution
+ * summary of their extremes.
+ *
+ * Level 0 holds the samples themselves and entry i of level l the minimum
+ * and maximum of samples [i·2^l, (i + 1)·2^l).  Levels are extended as the
+ * samples arrive, at an amortised cost of O(1) per sample.  Level 1 holds
+ * as many floats as there are samples and each level above half as many
+ * as the one below, so together the levels take up about twice the space
+ * of the samples.  The extremes over any range of N samples can then be
+ * found by examining at most a handful of entries of the level whose
+ * blocks are about N long, which is what allows a plot to be drawn in time
+ * proportional to its width rather than the number of samples.
+ */
+class MinMaxPyramid
+{
+public:
+    MinMaxPyramid();
+
+    void append(float value);
+
+    void clear();
+
+    long count() const
+    {
+        return m_levels.isEmpty() ? 0 : m_levels.first().size();
+    }
+
+    float value(long i) const
+    {
+        return m_levels.first().at(i);
+    }
+
+    /**
+     * Finds the extremes of samples first to last inclusive.  Blocks which
+     * only partly overlap the range are included whole, so the result may
+     * take in up to a block's worth of samples either side of it, where a
+     * block is the largest power of two no longer than the range.
+     */
+    void minMax(long first, long last, float *min, float *max) const;
+
+private:
+    /**
+     * Level 0 is the samples; the minima and maxima of level l > 0 are
+     * held interleaved in m_levels[l].
+     */
+    QVector<QVector<float> > m_levels;
+};
+
+#endif // MINMAXPYRAMID_H
@@ -0,0 +1,456 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "multiratestepper.h"
+#include "doublependulumrk4.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+namespace
+{
+    const int B = MultiRateStepper::BATCH_SIZE;
+
+    /**
+     * Parameters of a batch of pendula, one array entry per pendulum.
+     */
+    struct BatchParams
+    {
+        const double *l1, *m1, *l2, *m2, *g;
+        FastTrig::Accuracy accuracy;
+    };
+
+    /**
+     * DoublePendulum::derivs() for n pendula at once; the expressions are
+     * those of derivs(), so that each pendulum is rounded alike.
+     */
+    void derivsBatch(const BatchParams& p, int n,
+                     const double (*y)[B], double (*dydx)[B])
+    {
+        // The angles are already in rows of their own, bar the difference;
+        // zeroed, as the compiler can not see that the loop fills what
+        // sinCos() reads
+        double delta[B] = { 0.0 }, sinDelta[B], cosDelta[B];
+        double sinTheta1[B], cosTheta1[B], sinTheta2[B], cosTheta2[B];
+
+        for (int i = 0; i < n; ++i)
+        {
+            delta[i] = y[2][i] - y[0][i];
+        }
+
+        FastTrig::sinCos(delta, sinDelta, cosDelta, n, p.accuracy);
+        FastTrig::sinCos(y[0], sinTheta1, cosTheta1, n, p.accuracy);
+        FastTrig::sinCos(y[2], sinTheta2, cosTheta2, n, p.accuracy);
+
+        for (int i = 0; i < n; ++i)
+        {
+
+            const double l1 = p.l1[i], m2 = p.m2[i], l2 = p.l2[i];
+            const double g = p.g[i];
+            const double M = p.m1[i] + m2;
+
+            const double w1 = y[1][i], w2 = y[3][i];
+
+            const double sd = sinDelta[i], cd = cosDelta[i];
+            const double s1 = sinTheta1[i], s2 = sinTheta2[i];
+
+            double den = M*l1 - m2*l1*cd*cd;
+
+            dydx[0][i] = w1;
+            dydx[1][i] = (m2*l1*w1*w1*sd*cd
+                       + m2*g*s2*cd
+                       + m2*l2*w2*w2*sd
+                       - M*g*s1) / den;
+
+            dydx[2][i] = w2;
+
+            den *= l2 / l1;
+
+            dydx[3][i] = (-m2*l2*w2*w2*sd*cd
+                       + M*g*s1*cd
+                       - M*l1*w1*w1*sd
+                       - M*g*s2) / den;
+        }
+    }
+
+    /**
+     * Whether the pendulum steps exactly as DoublePendulumRK4 does, and so
+     * may be batched.
+     */
+    bool isBatchable(const DoublePendulum *pendulum)
+    {
+        return typeid(*pendulum) == typeid(DoublePendulumRK4)
+            && !pendulum->energyProjection();
+    }
+}
+
+MultiRateStepper::MultiRateStepper()
+    : m_prepared(true)
+{
+}
+
+void MultiRateStepper::addPendulum(DoublePendulum *pendulum)
+{
+    m_pendula.push_back(pendulum);
+    m_prepared = false;
+}
+
+void MultiRateStepper::clear()
+{
+    m_pendula.clear();
+    m_classes.clear();
+    m_others.clear();
+    m_prepared = true;
+}
+
+int MultiRateStepper::count() const
+{
+    return int(m_pendula.size());
+}
+
+int MultiRateStepper::classCount()
+{
+    prepare();
+
+    return int(m_classes.size());
+}
+
+double MultiRateStepper::classDt(int i)
+{
+    prepare();
+
+    return m_classes[i].dt;
+}
+
+int MultiRateStepper::classSize(int i)
+{
+    prepare();
+
+    return int(m_classes[i].pendula.size());
+}
+
+void MultiRateStepper::prepare()
+{
+    if (m_prepared)
+    {
+        return;
+    }
+
+    m_classes.clear();
+    m_others.clear();
+
+    // Classes are the largest dt over powers of two
+    double dtMax = 0.0;
+
+    for (size_t i = 0; i < m_pendula.size(); ++i)
+    {
+        if (isBatchable(m_pendula[i]))
+        {
+            dtMax = std::max(dtMax, m_pendula[i]->m_dt);
+        }
+    }
+
+    for (size_t i = 0; i < m_pendula.size(); ++i)
+    {
+        DoublePendulum *p = m_pendula[i];
+
+        if (!isBatchable(p) || !(p->m_dt > 0.0))
+        {
+            m_others.push_back(p);
+            continue;
+        }
+
+        // Halving is exact, so pendula of equal dt share a class exactly
+        double dt = dtMax;
+        while (dt > p->m_dt)
+        {
+            dt *= 0.5;
+        }
+
+        size_t k = 0;
+        while (k < m_classes.size()
+            && (m_classes[k].dt != dt
+             || m_classes[k].accuracy != p->m_trigAccuracy))
+        {
+            ++k;
+        }
+
+        if (k == m_classes.size())
+        {
+            m_classes.push_back(DtClass());
+            m_classes[k].dt = dt;
+            m_classes[k].time = p->m_time;
+            m_classes[k].accuracy = p->m_trigAccuracy;
+        }
+
+        DtClass& c = m_classes[k];
+
+        c.pendula.push_back(p);
+        c.l1.push_back(p->m_l1);
+        c.m1.push_back(p->m_m1);
+        c.l2.push_back(p->m_l2);
+        c.m2.push_back(p->m_m2);
+        c.g.push_back(p->m_g);
+    }
+
+    for (size_t k = 0; k < m_classes.size(); ++k)
+    {
+        const size_t n = m_classes[k].pendula.size();
+
+        for (int j = 0; j < 4; ++j)
+        {
+            m_classes[k].y[j].resize(n);
+            m_classes[k].yNext[j].resize(n);
+        }
+    }
+
+    m_prepared = true;
+}
+
+void MultiRateStepper::advance(double newTime)
+{
+    prepare();
+
+    for (size_t k = 0; k < m_classes.size(); ++k)
+    {
+        advanceClass(m_classes[k], newTime);
+    }
+
+    // An event may have stopped a pendulum just beyond newTime
+    for (size_t i = 0; i < m_others.size(); ++i)
+    {
+        if (m_others[i]->time() <= newTime)
+        {
+            m_others[i]->update(newTime);
+        }
+    }
+}
+
+void MultiRateStepper::advanceClass(DtClass& c, double newTime)
+{
+    // Pendula resumed after being stopped by an event are no longer in step
+    // with the class, and so are left to update() from now on
+    for (size_t i = 0; i < c.pendula.size();)
+    {
+        DoublePendulum *p = c.pendula[i];
+
+        if (!p->m_stopped && p->m_time != c.time)
+        {
+            m_others.push_back(p);
+
+            const size_t last = c.pendula.size() - 1;
+
+            c.pendula[i] = c.pendula[last];
+            c.l1[i] = c.l1[last];
+            c.m1[i] = c.m1[last];
+            c.l2[i] = c.l2[last];
+            c.m2[i] = c.m2[last];
+            c.g[i] = c.g[last];
+
+            c.pendula.pop_back();
+            c.l1.pop_back();
+            c.m1.pop_back();
+            c.l2.pop_back();
+            c.m2.pop_back();
+            c.g.pop_back();
+
+            for (int j = 0; j < 4; ++j)
+            {
+                c.y[j].pop_back();
+                c.yNext[j].pop_back();
+            }
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    const int n = int(c.pendula.size());
+
+    if (n == 0 || c.time >= newTime - 0.5 * c.dt)
+    {
+        return;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            c.y[j][i] = c.pendula[i]->m_state->y[j];
+        }
+    }
+
+    long steps = 0;
+
+    // Stop at the step nearest to newTime, as update() does
+    while (c.time < newTime - 0.5 * c.dt)
+    {
+        for (int begin = 0; begin < n; begin += B)
+        {
+            double *yin[4], *yout[4];
+
+            for (int j = 0; j < 4; ++j)
+            {
+                yin[j] = &c.y[j][begin];
+                yout[j] = &c.yNext[j][begin];
+            }
+
+            stepBatch(c, begin, std::min(int(B), n - begin), yin, yout);
+        }
+
+        c.time += c.dt;
+        ++steps;
+
+        const double tPrev = c.time - c.dt;
+
+        // Pendula with events or observers are told of every step
+        for (int i = 0; i < n; ++i)
+        {
+            DoublePendulum *p = c.pendula[i];
+
+            if (!p->m_stopped && !p->needsStepOutput())
+            {
+                continue;
+            }
+
+            const double yin[4] = { c.y[0][i], c.y[1][i],
+                                    c.y[2][i], c.y[3][i] };
+            const double yout[4] = { c.yNext[0][i], c.yNext[1][i],
+                                     c.yNext[2][i], c.yNext[3][i] };
+
+            if (!p->m_stopped)
+            {
+                for (int j = 0; j < 4; ++j)
+                {
+                    p->m_state->y[j] = yout[j];
+                }
+
+                p->m_time = c.time;
+                p->m_derivsEvaluations += 4;
+
+                p->stepTaken(tPrev, yin, c.time, yout);
+                p->checkEvents(c.time, yout);
+            }
+
+            // Stopped pendula stay put, wherever their event left them
+            if (p->m_stopped)
+            {
+                for (int j = 0; j < 4; ++j)
+                {
+                    c.yNext[j][i] = p->m_state->y[j];
+                }
+            }
+        }
+
+        for (int j = 0; j < 4; ++j)
+        {
+            c.y[j].swap(c.yNext[j]);
+        }
+    }
+
+    // Hand back the states, with the last step as update() would leave it
+    for (int i = 0; i < n; ++i)
+    {
+        DoublePendulum *p = c.pendula[i];
+
+        if (p->m_stopped)
+        {
+            continue;
+        }
+
+        const double yPrev[4] = { c.yNext[0][i], c.yNext[1][i],
+                                  c.yNext[2][i], c.yNext[3][i] };
+
+        for (int j = 0; j < 4; ++j)
+        {
+            p->m_state->y[j] = c.y[j][i];
+        }
+
+        // Pendula not passed every step are brought up to date here
+        if (p->m_time != c.time)
+        {
+            p->m_time = c.time;
+            p->m_eventTime = c.time;
+            p->m_derivsEvaluations += 4 * steps;
+            p->stepTaken(c.time - c.dt, yPrev, c.time, p->m_state->y);
+        }
+    }
+}
+
+void MultiRateStepper::stepBatch(const DtClass& c, int begin, int n,
+                                 double *const *yin, double *const *yout)
+{
+    const BatchParams p = { &c.l1[begin], &c.m1[begin], &c.l2[begin],
+                            &c.m2[begin], &c.g[begin], c.accuracy };
+    const double dt = c.dt;
+
+    double dydx[4][B], yt[4][B];
+    double k1[4][B], k2[4][B], k3[4][B], k4[4][B];
+
+    // First step
+    for (int j = 0; j < 4; ++j)
+    {
+        std::copy(yin[j], yin[j] + n, yt[j]);
+    }
+
+    derivsBatch(p, n, yt, dydx);
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            k1[j][i] = dt * dydx[j][i];
+            yt[j][i] = yin[j][i] + 0.5 * k1[j][i];
+        }
+    }
+
+    // Second step
+    derivsBatch(p, n, yt, dydx);
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            k2[j][i] = dt * dydx[j][i];
+            yt[j][i] = yin[j][i] + 0.5 * k2[j][i];
+        }
+    }
+
+    // Third step
+    derivsBatch(p, n, yt, dydx);
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            k3[j][i] = dt * dydx[j][i];
+            yt[j][i] = yin[j][i] + k3[j][i];
+        }
+    }
+
+    // Fourth step
+    derivsBatch(p, n, yt, dydx);
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            k4[j][i] = dt * dydx[j][i];
+            yout[j][i] = yin[j][i] + k1[j][i] / 6.0 + k2[j][i] / 3.0
+                       + k3[j][i] / 3.0 + k4[j][i] / 6.0;
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef MULTIRATESTEPPER_H
+#define MULTIRATESTEPPER_H
+
+#include <vector>
+
+#include "doublependulum.h"
+#include "fasttrig.h"
+
+/**
+ * Advances a mixed set of pendula together to a series of output times,
+ * stepping those which use the fixed-step RK4 solver in batches.
+ *
+ * The RK4 pendula are grouped into classes by dt, each dt being rounded
+ * down to the largest among them divided by a power of two; no pendulum is
+ * stepped more coarsely than it asked to be, and the steps of every class
+ * line up with those of the coarsest.  Each class keeps the states of its
+ * pendula as a structure of arrays and steps them BATCH_SIZE at a time,
+ * taking the sines and cosines for a whole batch with a single call to
+ * FastTrig::sinCos() so that its SIMD kernels run full, and leaving the
+ * rest of the arithmetic, laid out lane by lane, for the compiler to
+ * vectorise.  With FMA contraction off, as the build has it, a pendulum
+ * whose dt is already that of its class follows exactly the path update()
+ * would have taken.
+ *
+ * advance() then takes each class up to the output time at its own rate.
+ * Pendula with events or observers are passed every step, as in update(),
+ * and one stopped by an event is left where it stopped until resumed, after
+ * which it is updated on its own at the dt it asked for.  Pendula of other
+ * solvers, or with energy projection, are simply update()d.
+ *
+ * The classes are formed on the first advance() after pendula are added.
+ */
+class MultiRateStepper
+{
+public:
+    enum
+    {
+        /**
+         * Pendula stepped at a time; their working set stays within L1.
+         */
+        BATCH_SIZE = 64
+    };
+
+    MultiRateStepper();
+
+    /**
+     * Adds a pendulum, which must be at the same time as any added before.
+     */
+    void addPendulum(DoublePendulum *pendulum);
+    void clear();
+    int count() const;
+
+    /**
+     * Advances every pendulum to newTime, to within half of its step.
+     */
+    void advance(double newTime);
+
+    /**
+     * Number of dt classes, and the dt and number of pendula of each.
+     */
+    int classCount();
+    double classDt(int i);
+    int classSize(int i);
+
+private:
+    /**
+     * Pendula stepped together, with their states and parameters laid out
+     * as a structure of arrays.
+     */
+    struct DtClass
+    {
+        double dt;
+        double time;
+        FastTrig::Accuracy accuracy;
+
+        std::vector<DoublePendulum *> pendula;
+        std::vector<double> l1, m1, l2, m2, g;
+
+        /**
+         * States at the start and end of the step being taken.
+         */
+        std::vector<double> y[4], yNext[4];
+    };
+
+    /**
+     * Sorts the pendula into classes, if any have been added since.
+     */
+    void prepare();
+
+    /**
+     * Takes class c from its time to newTime.
+     */
+    void advanceClass(DtClass& c, double newTime);
+
+    /**
+     * Takes one RK4 step of pendula [begin, begin + n) of class c, from
+     * the states in yin to those in yout.
+     */
+    void stepBatch(const DtClass& c, int begin, int n,
+                   double *const *yin, double *const *yout);
+
+    std::vector<DoublePendulum *> m_pendula;
+    bool m_prepared;
+
+    std::vector<DtClass> m_classes;
+
+    /**
+     * Pendula which are update()d on their own.
+     */
+    std::vector<DoublePendulum *> m_others;
+};
+
+#endif // MULTIRATESTEPPER_H
@@ -0,0 +1,188 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "pararealintegrator.h"
+#include "doublependulumfactory.h"
+
+#include <QTime>
+#include <QtConcurrentMap>
+
+#include <cmath>
+
+PararealIntegrator::PararealIntegrator(const QString& coarseSolver,
+                                       double coarseDt,
+                                       const QString& fineSolver,
+                                       double fineDt, double g)
+    : m_coarseSolver(coarseSolver)
+    , m_coarseDt(coarseDt)
+    , m_fineSolver(fineSolver)
+    , m_fineDt(fineDt)
+    , m_g(g)
+    , m_valid(DoublePendulumFactory::solvers().contains(coarseSolver)
+           && DoublePendulumFactory::solvers().contains(fineSolver))
+{
+}
+
+bool PararealIntegrator::isValid() const
+{
+    return m_valid;
+}
+
+PararealIntegrator::State PararealIntegrator::propagate(const QString& solver,
+                                                        double dt,
+                                                        const State& y,
+                                                        double duration) const
+{
+    DoublePendulum *p = DoublePendulumFactory::create(solver,
+        Pendulum(y.y[0], y.y[1], m_l1, m_m1),
+        Pendulum(y.y[2], y.y[3], m_l2, m_m2),
+        dt, m_g);
+
+    p->update(duration);
+
+    State out;
+    out.y[0] = p->theta1();
+    out.y[1] = p->omega1();
+    out.y[2] = p->theta2();
+    out.y[3] = p->omega2();
+
+    delete p;
+
+    return out;
+}
+
+void PararealIntegrator::runFineJob(FineJob& job)
+{
+    QTime timer;
+    timer.start();
+
+    job.out = job.integrator->propagate(job.integrator->m_fineSolver,
+                                        job.integrator->m_fineDt,
+                                        job.in, job.duration);
+
+    job.time = timer.elapsed();
+}
+
+PararealResult PararealIntegrator::run(const Pendulum& upper,
+                                       const Pendulum& lower,
+                                       double endTime, int numSlices,
+                                       double tol)
+{
+    QTime timer;
+    timer.start();
+
+    if (!m_valid)
+    {
+        PararealResult result;
+        result.upper = upper;
+        result.lower = lower;
+        result.iterations = -1;
+        result.wallTime = result.serialTime = 0;
+        result.speedup = 0.0;
+
+        return result;
+    }
+
+    m_l1 = upper.l;
+    m_m1 = upper.m;
+    m_l2 = lower.l;
+    m_m2 = lower.m;
+
+    const double sliceTime = endTime / numSlices;
+
+    // u[n] is the state at the start of slice n; g[n] the coarse prediction
+    // of the state at its end
+    QVector<State> u(numSlices + 1), g(numSlices);
+    QVector<FineJob> jobs(numSlices);
+    QVector<int> fineTime(numSlices, 0);
+
+    u[0].y[0] = upper.theta;
+    u[0].y[1] = upper.omega;
+    u[0].y[2] = lower.theta;
+    u[0].y[3] = lower.omega;
+
+    // Initial serial coarse sweep
+    for (int n = 0; n < numSlices; ++n)
+    {
+        g[n] = propagate(m_coarseSolver, m_coarseDt, u[n], sliceTime);
+        u[n + 1] = g[n];
+    }
+
+    bool converged = false;
+
+    int k;
+    for (k = 0; k < numSlices && !converged; ++k)
+    {
+        // Fine solves of every slice not yet known to be exact, in parallel
+        jobs.resize(numSlices - k);
+        for (int n = k; n < numSlices; ++n)
+        {
+            jobs[n - k].integrator = this;
+            jobs[n - k].in = u[n];
+            jobs[n - k].duration = sliceTime;
+        }
+
+        QtConcurrent::blockingMap(jobs, PararealIntegrator::runFineJob);
+
+        for (int n = k; n < numSlices; ++n)
+        {
+            fineTime[n] = jobs[n - k].time;
+        }
+
+        // Serial correction sweep: u[n+1] = G(u[n]) + F(u_old[n]) - G(u_old[n])
+        double change = 0.0;
+
+        u[k + 1] = jobs[0].out;
+        for (int n = k + 1; n < numSlices; ++n)
+        {
+            const State gNew = propagate(m_coarseSolver, m_coarseDt,
+                                         u[n], sliceTime);
+
+            State next;
+            for (int i = 0; i < NUM_EQNS; ++i)
+            {
+                next.y[i] = gNew.y[i] + jobs[n - k].out.y[i] - g[n].y[i];
+                change = qMax(change, fabs(next.y[i] - u[n + 1].y[i]));
+            }
+
+            g[n] = gNew;
+            u[n + 1] = next;
+        }
+
+        converged = (change <= tol);
+    }
+
+    PararealResult result;
+    result.iterations = k;
+
+    result.serialTime = 0;
+    for (int n = 0; n < numSlices; ++n)
+    {
+        result.serialTime += fineTime[n];
+    }
+
+    result.upper = Pendulum(u[numSlices].y[0], u[numSlices].y[1], m_l1, m_m1);
+    result.lower = Pendulum(u[numSlices].y[2], u[numSlices].y[3], m_l2, m_m2);
+
+    result.wallTime = timer.elapsed();
+    result.speedup = (result.wallTime > 0)
+                   ? double(result.serialTime) / result.wallTime : 0.0;
+
+    return result;
+}
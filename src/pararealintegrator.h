@@ -0,0 +1,127 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef PARAREALINTEGRATOR_H
+#define PARAREALINTEGRATOR_H
+
+#include <QString>
+#include <QVector>
+
+#include "doublependulum.h"
+
+/**
+ * Outcome of a Parareal run.
+ */
+struct PararealResult
+{
+    /**
+     * State of the upper and lower bobs at the end time.
+     */
+    Pendulum upper, lower;
+
+    /**
+     * Number of Parareal iterations performed, or -1 if the integrator was
+     * not valid, in which case the bobs are left where they started.
+     */
+    int iterations;
+
+    /**
+     * Wall-clock time of the run and the sum of the most recent fine solve
+     * times of each slice (i.e. an estimate of the serial run time), both in
+     * ms, along with their ratio.
+     */
+    int wallTime;
+    int serialTime;
+    double speedup;
+};
+
+/**
+ * Parallel-in-time integrator for a single long trajectory.
+ *
+ * The time interval is split into slices.  A cheap coarse propagator
+ * serially predicts the state at the start of each slice.  An expensive fine
+ * propagator then refines all slices concurrently, and the coarse predictions
+ * are corrected (Lions, Maday & Turinici, 2001).  This repeats until the slice
+ * boundaries stop changing; after k iterations at least the first k slices
+ * are exact, so at most one iteration per slice is ever needed.
+ *
+ * For the fixed-step solvers each slice should span a whole number of both
+ * the coarse and fine steps.
+ */
+class PararealIntegrator
+{
+public:
+    PararealIntegrator(const QString& coarseSolver, double coarseDt,
+                       const QString& fineSolver, double fineDt,
+                       double g=9.81);
+
+    /**
+     * Whether both solvers are known to DoublePendulumFactory; run() does
+     * nothing if not.
+     */
+    bool isValid() const;
+
+    /**
+     * Integrates from the given initial conditions to endTime using
+     * numSlices time slices.  Blocks until complete.
+     */
+    PararealResult run(const Pendulum& upper, const Pendulum& lower,
+                       double endTime, int numSlices, double tol=1e-10);
+
+private:
+    enum
+    {
+        NUM_EQNS = 4
+    };
+
+    struct State
+    {
+        double y[NUM_EQNS];
+    };
+
+    struct FineJob
+    {
+        const PararealIntegrator *integrator;
+        State in, out;
+        double duration;
+        int time;
+    };
+
+    /**
+     * Advances y by duration using the given solver.
+     */
+    State propagate(const QString& solver, double dt, const State& y,
+                    double duration) const;
+
+    static void runFineJob(FineJob& job);
+
+    const QString m_coarseSolver;
+    const double m_coarseDt;
+    const QString m_fineSolver;
+    const double m_fineDt;
+    const double m_g;
+    const bool m_valid;
+
+    /**
+     * Lengths and masses of the bobs for the current run.
+     */
+    double m_l1, m_m1, m_l2, m_m2;
+};
+
+#endif // PARAREALINTEGRATOR_H
@@ -0,0 +1,132 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "pendulumlistmodel.h"
+#include "doublependulumwidget.h"
+
+#include <QPainter>
+#include <QPixmap>
+
+namespace
+{
+    const int ICON_SIZE = 16;
+}
+
+PendulumListModel::PendulumListModel(DoublePendulumWidget *view,
+                                     QObject *parent)
+    : QAbstractListModel(parent)
+    , m_view(view)
+{
+}
+
+int PendulumListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_view->pendula().count();
+}
+
+QVariant PendulumListModel::data(const QModelIndex& index, int role) const
+{
+    const PendulumRegistry& pendula = m_view->pendula();
+
+    if (!index.isValid() || index.row() >= pendula.count())
+    {
+        return QVariant();
+    }
+
+    switch (role)
+    {
+        case Qt::DisplayRole:
+            return pendula.nameAt(index.row());
+        case Qt::DecorationRole:
+        {
+            QPixmap pm(ICON_SIZE, ICON_SIZE);
+            QPainter painter(&pm);
+
+            pendula.at(index.row())->drawIcon(&painter, pm.rect());
+
+            return pm;
+        }
+        case HandleRole:
+            return pendula.handleAt(index.row());
+        default:
+            return QVariant();
+    }
+}
+
+QModelIndex PendulumListModel::addPendulum(const QString& name,
+                                           DoublePendulumItem *item)
+{
+    return addPendula(QStringList() << name,
+                      QList<DoublePendulumItem *>() << item);
+}
+
+QModelIndex PendulumListModel::addPendula(const QStringList& names,
+                                          const QList<DoublePendulumItem *>& items)
+{
+    const int first = rowCount();
+
+    if (items.isEmpty()
+     || items.size() > PendulumRegistry::CAPACITY - first)
+    {
+        return QModelIndex();
+    }
+
+    beginInsertRows(QModelIndex(), first, first + items.size() - 1);
+
+    for (int i = 0; i < items.size(); ++i)
+    {
+        m_view->addPendulum(names.at(i), items.at(i));
+    }
+
+    endInsertRows();
+
+    return index(first);
+}
+
+DoublePendulumItem *PendulumListModel::removePendulum(int row)
+{
+    if (row < 0 || row >= rowCount())
+    {
+        return 0;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+
+    DoublePendulumItem *item = m_view->removePendulum(m_view->pendula().handleAt(row));
+
+    endRemoveRows();
+
+    return item;
+}
+
+PendulumRegistry::Handle PendulumListModel::handle(const QModelIndex& index) const
+{
+    return index.isValid() ? m_view->pendula().handleAt(index.row())
+                           : PendulumRegistry::Handle(PendulumRegistry::Null);
+}
+
+DoublePendulumItem *PendulumListModel::item(const QModelIndex& index) const
+{
+    return index.isValid() ? m_view->pendula().at(index.row()) : 0;
+}
+
+void PendulumListModel::itemChanged(const QModelIndex& index)
+{
+    emit dataChanged(index, index);
+}
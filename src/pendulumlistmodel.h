@@ -0,0 +1,83 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef PENDULUMLISTMODEL_H
+#define PENDULUMLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QStringList>
+
+#include "pendulumregistry.h"
+
+class DoublePendulumWidget;
+
+/**
+ * List model over the pendula of a DoublePendulumWidget, one row per
+ * pendulum in the order in which they were added.
+ *
+ * Rows are read straight out of the widget's registry and icons are drawn
+ * only when a view asks for them, so a view with uniform item sizes only
+ * ever touches the rows which are visible and the cost of the list is
+ * independent of the number of pendula.  Pendula should be added and
+ * removed through the model so that views are kept informed.
+ */
+class PendulumListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        HandleRole = Qt::UserRole
+    };
+
+    PendulumListModel(DoublePendulumWidget *view, QObject *parent = 0);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+    QModelIndex addPendulum(const QString& name, DoublePendulumItem *item);
+
+    /**
+     * Adds a batch of pendula in one go, returning the index of the first.
+     * If they would not all fit in the registry none are added and an
+     * invalid index is returned; the pendula then remain the caller's.
+     */
+    QModelIndex addPendula(const QStringList& names,
+                           const QList<DoublePendulumItem *>& items);
+
+    /**
+     * Removes the pendulum in the given row, returning it.
+     */
+    DoublePendulumItem *removePendulum(int row);
+
+    PendulumRegistry::Handle handle(const QModelIndex& index) const;
+    DoublePendulumItem *item(const QModelIndex& index) const;
+
+    /**
+     * Informs views that the pendulum's icon may have changed.
+     */
+    void itemChanged(const QModelIndex& index);
+
+private:
+    DoublePendulumWidget *m_view;
+};
+
+#endif // PENDULUMLISTMODEL_H
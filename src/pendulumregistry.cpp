@@ -0,0 +1,103 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "pendulumregistry.h"
+
+PendulumRegistry::PendulumRegistry()
+{
+}
+
+PendulumRegistry::Handle PendulumRegistry::insert(const QString& name,
+                                                  DoublePendulumItem *item)
+{
+    int s;
+
+    if (isFull())
+    {
+        return Null;
+    }
+
+    // Reuse a free slot if there is one
+    if (!m_freeSlots.isEmpty())
+    {
+        s = m_freeSlots.last();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        Slot slot;
+        slot.generation = 0;
+
+        s = m_slots.size();
+        m_slots.append(slot);
+    }
+
+    const Handle handle = (Handle(m_slots[s].generation) << SLOT_BITS) | s;
+
+    m_slots[s].dense = m_items.size();
+
+    m_items.append(item);
+    m_handles.append(handle);
+    m_names.append(name);
+    m_nameIndex.insert(name, handle);
+
+    return handle;
+}
+
+DoublePendulumItem *PendulumRegistry::remove(Handle handle)
+{
+    const int i = dense(handle);
+
+    if (i < 0)
+    {
+        return 0;
+    }
+
+    DoublePendulumItem *item = m_items[i];
+
+    m_nameIndex.remove(m_names[i]);
+
+    m_items.remove(i);
+    m_handles.remove(i);
+    m_names.remove(i);
+
+    // Everything after the item has moved down one
+    for (int j = i; j < m_handles.size(); ++j)
+    {
+        m_slots[int(m_handles[j] & SLOT_MASK)].dense = j;
+    }
+
+    // Free the slot, invalidating any outstanding handles to it
+    const int s = int(handle & SLOT_MASK);
+    Slot& slot = m_slots[s];
+
+    slot.dense = -1;
+    slot.generation = (slot.generation + 1) & GENERATION_MASK;
+
+    m_freeSlots.append(s);
+
+    return item;
+}
+
+QString PendulumRegistry::name(Handle handle) const
+{
+    const int i = dense(handle);
+
+    return (i >= 0) ? m_names[i] : QString();
+}
@@ -0,0 +1,180 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef PENDULUMREGISTRY_H
+#define PENDULUMREGISTRY_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+class DoublePendulumItem;
+
+/**
+ * Registry of the pendulum items in the scene, addressed by integer handles.
+ *
+ * This is a generational slot map: a handle names a slot, which holds the
+ * position of the item in a densely packed array along with a generation
+ * count that is bumped whenever the slot is freed.  Looking up a handle is
+ * therefore a couple of array accesses, a handle to a removed item is
+ * detected rather than silently referring to whatever replaced it, and
+ * iterating over the items walks a contiguous array.  Names are kept as a
+ * side index for the few places which need them.
+ *
+ * Items keep the order in which they were added, so removal is linear in
+ * the number of items; the registry does not own the items.  At most
+ * CAPACITY items may be held at once.
+ */
+class PendulumRegistry
+{
+public:
+    /**
+     * Handles are non-negative and so may be stored wherever a qint64 can,
+     * such as a QVariant; Null is never handed out.
+     */
+    typedef qint64 Handle;
+
+    enum
+    {
+        Null = -1,
+
+        /**
+         * Largest number of items which may be held at once.
+         */
+        CAPACITY = 1 << 24
+    };
+
+    PendulumRegistry();
+
+    /**
+     * Adds the item, returning its handle, or Null if the registry already
+     * holds CAPACITY items.
+     */
+    Handle insert(const QString& name, DoublePendulumItem *item);
+
+    bool isFull() const
+    {
+        return m_items.size() >= CAPACITY;
+    }
+
+    /**
+     * Removes the item, returning it, or 0 if the handle is stale.
+     */
+    DoublePendulumItem *remove(Handle handle);
+
+    bool contains(Handle handle) const
+    {
+        return dense(handle) >= 0;
+    }
+
+    /**
+     * Returns the item with the given handle, or 0 if it has been removed.
+     */
+    DoublePendulumItem *item(Handle handle) const
+    {
+        const int i = dense(handle);
+
+        return (i >= 0) ? m_items[i] : 0;
+    }
+
+    QString name(Handle handle) const;
+
+    /**
+     * Returns the handle of the item with the given name, or Null.
+     */
+    Handle find(const QString& name) const
+    {
+        return m_nameIndex.value(name, Null);
+    }
+
+    int count() const
+    {
+        return m_items.size();
+    }
+
+    /**
+     * The items in the order in which they were added.  The vector is
+     * implicitly shared so may be iterated over with foreach at no cost.
+     */
+    const QVector<DoublePendulumItem *>& items() const
+    {
+        return m_items;
+    }
+
+    DoublePendulumItem *at(int i) const
+    {
+        return m_items[i];
+    }
+
+    Handle handleAt(int i) const
+    {
+        return m_handles[i];
+    }
+
+    const QString& nameAt(int i) const
+    {
+        return m_names[i];
+    }
+
+private:
+    /**
+     * The low SLOT_BITS of a handle are its slot and the rest, less the
+     * sign bit, its generation.
+     */
+    static const int SLOT_BITS = 32;
+    static const Handle SLOT_MASK = (Handle(1) << SLOT_BITS) - 1;
+    static const int GENERATION_MASK = 0x7fffffff;
+
+    struct Slot
+    {
+        /**
+         * Position of the item in the dense arrays, or -1 if free.
+         */
+        int dense;
+        int generation;
+    };
+
+    /**
+     * Returns the position of the item in the dense arrays, or -1.
+     */
+    int dense(Handle handle) const
+    {
+        const Handle s = handle & SLOT_MASK;
+
+        if (handle < 0 || s >= m_slots.size()
+         || m_slots[int(s)].generation != (handle >> SLOT_BITS))
+        {
+            return -1;
+        }
+
+        return m_slots[int(s)].dense;
+    }
+
+    QVector<Slot> m_slots;
+    QVector<int> m_freeSlots;
+
+    QVector<DoublePendulumItem *> m_items;
+    QVector<Handle> m_handles;
+    QVector<QString> m_names;
+
+    QHash<QString, Handle> m_nameIndex;
+};
+
+#endif // PENDULUMREGISTRY_H
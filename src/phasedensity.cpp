@@ -0,0 +1,109 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "phasedensity.h"
+
+#include <cmath>
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+
+    // Bins stop counting here, leaving headroom for concurrent increments
+    const int SATURATED = 1 << 30;
+}
+
+PhaseDensity::PhaseDensity(int thetaBins, int omegaBins,
+                           double omegaRange, int tileSize)
+    : m_thetaBins(thetaBins)
+    , m_omegaBins(omegaBins)
+    , m_omegaRange(omegaRange)
+    , m_tileSize(tileSize)
+    , m_thetaTiles((thetaBins + tileSize - 1) / tileSize)
+    , m_omegaTiles((omegaBins + tileSize - 1) / tileSize)
+    , m_counts(new QAtomicInt[thetaBins * omegaBins])
+    , m_dirty(new QAtomicInt[m_thetaTiles * m_omegaTiles])
+    , m_maxCount(0)
+{
+}
+
+PhaseDensity::~PhaseDensity()
+{
+    delete[] m_counts;
+    delete[] m_dirty;
+}
+
+void PhaseDensity::add(double theta, double omega)
+{
+    // Drop anything which has blown up
+    if (theta != theta || omega != omega)
+    {
+        return;
+    }
+
+    // Wrap θ into [-π, π)
+    theta -= 2.0*pi * floor((theta + pi) / (2.0*pi));
+
+    const int i = qMin(int((theta + pi) / (2.0*pi) * m_thetaBins),
+                       m_thetaBins - 1);
+    const int j = qBound(0, int((m_omegaRange - omega) / (2.0*m_omegaRange)
+                                * m_omegaBins), m_omegaBins - 1);
+
+    QAtomicInt& bin = m_counts[j*m_thetaBins + i];
+
+    if (bin >= SATURATED)
+    {
+        return;
+    }
+
+    const int n = bin.fetchAndAddRelaxed(1) + 1;
+
+    // Only write to the flag when it needs raising, as the same tile is
+    // usually hit many times between redraws
+    QAtomicInt& dirty = m_dirty[(j / m_tileSize)*m_thetaTiles + i / m_tileSize];
+
+    if (dirty == 0)
+    {
+        dirty.fetchAndStoreRelaxed(1);
+    }
+
+    for (int max = m_maxCount; n > max; max = m_maxCount)
+    {
+        if (m_maxCount.testAndSetRelaxed(max, n))
+        {
+            break;
+        }
+    }
+}
+
+void PhaseDensity::clear()
+{
+    for (int k = 0; k < m_thetaBins*m_omegaBins; ++k)
+    {
+        m_counts[k] = 0;
+    }
+
+    // Every tile has changed
+    for (int k = 0; k < m_thetaTiles*m_omegaTiles; ++k)
+    {
+        m_dirty[k] = 1;
+    }
+
+    m_maxCount = 0;
+}
@@ -0,0 +1,104 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef PHASEDENSITY_H
+#define PHASEDENSITY_H
+
+#include <QAtomicInt>
+
+/**
+ * A fixed size two dimensional histogram of (θ, ω), with θ wrapped into
+ * [-π, π) and ω clamped to [-omegaRange, omegaRange].
+ *
+ * Counts are atomic so that samples may be added from any number of threads
+ * at once without locking, and the memory used is set by the number of bins
+ * alone however many samples are added.  The bins are grouped into square
+ * tiles, each with a dirty flag which is raised by add() and lowered by
+ * takeDirty(), so that a display need only redraw the tiles which have
+ * changed since it last looked.
+ */
+class PhaseDensity
+{
+public:
+    PhaseDensity(int thetaBins = 512, int omegaBins = 512,
+                 double omegaRange = 10.0, int tileSize = 32);
+    ~PhaseDensity();
+
+    /**
+     * Bins a sample; safe to call concurrently with itself and with any of
+     * the const members and takeDirty().  Counts saturate rather than wrap.
+     */
+    void add(double theta, double omega);
+
+    /**
+     * Zeros the histogram; must not be called concurrently with add().
+     */
+    void clear();
+
+    int thetaBins() const { return m_thetaBins; }
+    int omegaBins() const { return m_omegaBins; }
+    double omegaRange() const { return m_omegaRange; }
+
+    /**
+     * Count of bin (i, j), where i runs from θ = -π to π and j from
+     * ω = omegaRange to -omegaRange; that is in image order.
+     */
+    int count(int i, int j) const
+    {
+        return m_counts[j*m_thetaBins + i];
+    }
+
+    /**
+     * Largest count of any bin.
+     */
+    int maxCount() const
+    {
+        return m_maxCount;
+    }
+
+    int tileSize() const { return m_tileSize; }
+    int thetaTiles() const { return m_thetaTiles; }
+    int omegaTiles() const { return m_omegaTiles; }
+
+    /**
+     * Returns whether any bin of tile (ti, tj) has changed since the last
+     * call, clearing the flag.
+     */
+    bool takeDirty(int ti, int tj)
+    {
+        return m_dirty[tj*m_thetaTiles + ti].fetchAndStoreRelaxed(0) != 0;
+    }
+
+private:
+    // Owns its bins and so can not be copied
+    PhaseDensity(const PhaseDensity&);
+    PhaseDensity& operator=(const PhaseDensity&);
+
+    const int m_thetaBins, m_omegaBins;
+    const double m_omegaRange;
+
+    const int m_tileSize;
+    const int m_thetaTiles, m_omegaTiles;
+
+    QAtomicInt *m_counts;
+    QAtomicInt *m_dirty;
+    QAtomicInt m_maxCount;
+};
+
+#endif // PHASEDENSITY_H
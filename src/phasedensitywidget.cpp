@@ -0,0 +1,212 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "phasedensitywidget.h"
+#include "doublependulumevent.h"
+
+#include <QPainter>
+#include <QTimer>
+
+#include <cmath>
+
+class PhaseDensityWidget::Sampler : public DoublePendulumObserver
+{
+public:
+    Sampler(PhaseDensity *density)
+        : m_density(density)
+    {
+    }
+
+    void sample(const DoublePendulum&, double, const double *y)
+    {
+        // The state is θ1, ω1, θ2, ω2
+        m_density[0].add(y[0], y[1]);
+        m_density[1].add(y[2], y[3]);
+    }
+
+    // PhaseDensity is updated atomically
+    bool isThreadSafe() const
+    {
+        return true;
+    }
+
+private:
+    PhaseDensity *m_density;
+};
+
+PhaseDensityWidget::PhaseDensityWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_timer(new QTimer(this))
+{
+    // Pale yellow through red to black, with unvisited bins left white so
+    // that even a single sample stands out
+    m_palette[0] = qRgb(255, 255, 255);
+
+    for (int i = 1; i < 256; ++i)
+    {
+        const double x = (i - 1) / 254.0;
+
+        m_palette[i] = qRgb(qBound(0, int(255 * (2.0 - 2.0*x)), 255),
+                            qBound(0, int(255 * (1.0 - 2.0*x)), 255),
+                            qBound(0, int(255 * (0.6 - 2.4*x)), 255));
+    }
+
+    for (int arm = 0; arm < 2; ++arm)
+    {
+        m_image[arm] = QImage(m_density[arm].thetaBins(),
+                              m_density[arm].omegaBins(),
+                              QImage::Format_RGB32);
+        m_image[arm].fill(m_palette[0]);
+        m_scaleMax[arm] = 0;
+    }
+
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+    m_timer->start(100);
+}
+
+PhaseDensityWidget::~PhaseDensityWidget()
+{
+    qDeleteAll(m_samplers);
+}
+
+DoublePendulumObserver *PhaseDensityWidget::createSampler()
+{
+    Sampler *sampler = new Sampler(m_density);
+    m_samplers.append(sampler);
+
+    return sampler;
+}
+
+void PhaseDensityWidget::clear()
+{
+    qDeleteAll(m_samplers);
+    m_samplers.clear();
+
+    for (int arm = 0; arm < 2; ++arm)
+    {
+        m_density[arm].clear();
+        m_image[arm].fill(m_palette[0]);
+        m_scaleMax[arm] = 0;
+    }
+
+    update();
+}
+
+QSize PhaseDensityWidget::sizeHint() const
+{
+    return QSize(512, 256);
+}
+
+void PhaseDensityWidget::refresh()
+{
+    bool changed = false;
+
+    for (int arm = 0; arm < 2; ++arm)
+    {
+        PhaseDensity& density = m_density[arm];
+
+        // Rescale once the largest count has doubled, redrawing everything
+        const int max = density.maxCount();
+        const bool rescale = max > 2*m_scaleMax[arm];
+
+        if (rescale)
+        {
+            m_scaleMax[arm] = max;
+        }
+
+        for (int tj = 0; tj < density.omegaTiles(); ++tj)
+        {
+            for (int ti = 0; ti < density.thetaTiles(); ++ti)
+            {
+                if (density.takeDirty(ti, tj) || rescale)
+                {
+                    drawTile(arm, ti, tj);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    if (changed)
+    {
+        update();
+    }
+}
+
+void PhaseDensityWidget::drawTile(int arm, int ti, int tj)
+{
+    const PhaseDensity& density = m_density[arm];
+    QImage& image = m_image[arm];
+
+    const int size = density.tileSize();
+    const int iEnd = qMin((ti + 1)*size, density.thetaBins());
+    const int jEnd = qMin((tj + 1)*size, density.omegaBins());
+
+    // Counts above the scale maximum, up to twice it, saturate the palette
+    const double scale = (m_scaleMax[arm] > 0)
+                       ? 255.0 / log(1.0 + m_scaleMax[arm]) : 0.0;
+
+    for (int j = tj*size; j < jEnd; ++j)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(j));
+
+        for (int i = ti*size; i < iEnd; ++i)
+        {
+            const int n = density.count(i, j);
+
+            // Any visited bin gets at least the first colour after white
+            line[i] = (n > 0)
+                    ? m_palette[qBound(1, int(scale * log(1.0 + n)), 255)]
+                    : m_palette[0];
+        }
+    }
+}
+
+void PhaseDensityWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+
+    const int halfWidth = width() / 2;
+
+    for (int arm = 0; arm < 2; ++arm)
+    {
+        const QRect target(arm*halfWidth, 0, halfWidth, height());
+
+        painter.drawImage(target, m_image[arm]);
+
+        // Axes through θ = 0 and ω = 0
+        painter.setPen(QPen(Qt::gray, 0, Qt::DotLine));
+        painter.drawLine(target.center().x(), 0, target.center().x(), height());
+        painter.drawLine(target.left(), height() / 2,
+                         target.right(), height() / 2);
+
+        painter.setPen(Qt::black);
+        painter.drawText(target.adjusted(4, 4, -4, -4),
+                         Qt::AlignLeft | Qt::AlignTop,
+                         QString::fromUtf8("ω%1 (±%2 rad/s)")
+                         .arg(arm + 1).arg(m_density[arm].omegaRange()));
+        painter.drawText(target.adjusted(4, 4, -4, -4),
+                         Qt::AlignRight | Qt::AlignBottom,
+                         QString::fromUtf8("θ%1 (-π…π)").arg(arm + 1));
+    }
+
+    // Separate the two planes
+    painter.setPen(Qt::gray);
+    painter.drawLine(halfWidth, 0, halfWidth, height());
+}
@@ -0,0 +1,90 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef PHASEDENSITYWIDGET_H
+#define PHASEDENSITYWIDGET_H
+
+#include <QImage>
+#include <QList>
+#include <QWidget>
+
+#include "phasedensity.h"
+
+class QTimer;
+class DoublePendulumObserver;
+
+/**
+ * Displays the density of the running pendula in the (θ1, ω1) and (θ2, ω2)
+ * planes as a pair of log scaled heatmaps.
+ *
+ * Samples from every pendulum are binned into a PhaseDensity per arm and
+ * so the memory used is fixed however long the simulation runs.  The
+ * images are brought up to date on a timer by redrawing only the tiles
+ * which have been hit since the last refresh; everything is redrawn only
+ * when the largest count has doubled and the colour scale has to change.
+ */
+class PhaseDensityWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    PhaseDensityWidget(QWidget *parent = 0);
+    ~PhaseDensityWidget();
+
+    /**
+     * Creates an observer which bins the states it is passed.  The observer
+     * is owned by the widget and remains valid until the next call to
+     * clear().
+     */
+    DoublePendulumObserver *createSampler();
+
+    /**
+     * Releases the samplers and empties the histograms.
+     */
+    void clear();
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    class Sampler;
+
+    void drawTile(int arm, int ti, int tj);
+
+    PhaseDensity m_density[2];
+    QImage m_image[2];
+
+    /**
+     * Largest count at the time the images were last redrawn in full, which
+     * is mapped onto the top of the palette.
+     */
+    int m_scaleMax[2];
+
+    QList<Sampler *> m_samplers;
+    QTimer *m_timer;
+
+    QRgb m_palette[256];
+};
+
+#endif // PHASEDENSITYWIDGET_H
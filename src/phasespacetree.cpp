@@ -0,0 +1,271 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "phasespacetree.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+
+    // Size of the linearly searched buffer and so of the smallest tree
+    const int BUFFER_SIZE = 64;
+
+    // Ranges no larger than this are searched linearly
+    const int LEAF_SIZE = 8;
+
+    bool isAngle(int dim)
+    {
+        return dim == 0 || dim == 2;
+    }
+
+    class CoordLess
+    {
+    public:
+        CoordLess(const double *coords, int dim)
+            : m_coords(coords)
+            , m_dim(dim)
+        {
+        }
+
+        bool operator()(int a, int b) const
+        {
+            return m_coords[4*a + m_dim] < m_coords[4*b + m_dim];
+        }
+
+    private:
+        const double *m_coords;
+        const int m_dim;
+    };
+}
+
+/**
+ * The query box; in the angular dimensions it may wrap around ±π, in which
+ * case it is split into two intervals.
+ */
+struct PhaseSpaceTree::Query
+{
+    double centre[4];
+    double epsilon;
+
+    double lo[4][2];
+    double hi[4][2];
+    int intervals[4];
+
+    bool overlaps(int dim, double min, double max) const
+    {
+        for (int k = 0; k < intervals[dim]; ++k)
+        {
+            if (lo[dim][k] <= max && hi[dim][k] >= min)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+PhaseSpaceTree::PhaseSpaceTree()
+{
+}
+
+int PhaseSpaceTree::insert(const double *y)
+{
+    const int i = count();
+
+    for (int d = 0; d < 4; ++d)
+    {
+        m_coords.append(isAngle(d)
+                        ? y[d] - 2.0*pi * floor((y[d] + pi) / (2.0*pi))
+                        : y[d]);
+    }
+
+    m_buffer.append(i);
+
+    if (m_buffer.size() == BUFFER_SIZE)
+    {
+        // Merge the buffer with the trees below the first free slot
+        QVector<int> merged = m_buffer;
+        int k = 0;
+
+        for (; k < m_trees.size() && !m_trees[k].isEmpty(); ++k)
+        {
+            merged += m_trees[k];
+            m_trees[k].clear();
+        }
+
+        if (k == m_trees.size())
+        {
+            m_trees.append(QVector<int>());
+        }
+
+        build(merged.data(), merged.data() + merged.size(), 0);
+
+        m_trees[k] = merged;
+        m_buffer.clear();
+    }
+
+    return i;
+}
+
+void PhaseSpaceTree::clear()
+{
+    m_coords.clear();
+    m_buffer.clear();
+    m_trees.clear();
+}
+
+void PhaseSpaceTree::neighbours(const double *y, double epsilon,
+                                QVector<int>& found) const
+{
+    Query q;
+    q.epsilon = epsilon;
+
+    for (int d = 0; d < 4; ++d)
+    {
+        q.centre[d] = y[d];
+        q.lo[d][0] = y[d] - epsilon;
+        q.hi[d][0] = y[d] + epsilon;
+        q.intervals[d] = 1;
+
+        if (isAngle(d))
+        {
+            q.centre[d] -= 2.0*pi * floor((y[d] + pi) / (2.0*pi));
+            q.lo[d][0] = q.centre[d] - epsilon;
+            q.hi[d][0] = q.centre[d] + epsilon;
+
+            // Everything is in range if the box spans the whole circle
+            if (epsilon >= pi)
+            {
+                q.lo[d][0] = -pi;
+                q.hi[d][0] = pi;
+            }
+            else if (q.lo[d][0] < -pi)
+            {
+                q.lo[d][1] = q.lo[d][0] + 2.0*pi;
+                q.hi[d][1] = pi;
+                q.intervals[d] = 2;
+            }
+            else if (q.hi[d][0] >= pi)
+            {
+                q.lo[d][1] = -pi;
+                q.hi[d][1] = q.hi[d][0] - 2.0*pi;
+                q.intervals[d] = 2;
+            }
+        }
+    }
+
+    for (int k = 0; k < m_buffer.size(); ++k)
+    {
+        if (within(m_buffer[k], q))
+        {
+            found.append(m_buffer[k]);
+        }
+    }
+
+    for (int k = 0; k < m_trees.size(); ++k)
+    {
+        const QVector<int>& tree = m_trees[k];
+
+        if (!tree.isEmpty())
+        {
+            search(tree.constData(), tree.constData() + tree.size(), 0,
+                   q, found);
+        }
+    }
+}
+
+void PhaseSpaceTree::build(int *begin, int *end, int depth)
+{
+    if (end - begin <= LEAF_SIZE)
+    {
+        return;
+    }
+
+    int *mid = begin + (end - begin) / 2;
+
+    std::nth_element(begin, mid, end,
+                     CoordLess(m_coords.constData(), depth % 4));
+
+    build(begin, mid, depth + 1);
+    build(mid + 1, end, depth + 1);
+}
+
+void PhaseSpaceTree::search(const int *begin, const int *end, int depth,
+                            const Query& q, QVector<int>& found) const
+{
+    if (end - begin <= LEAF_SIZE)
+    {
+        for (const int *i = begin; i != end; ++i)
+        {
+            if (within(*i, q))
+            {
+                found.append(*i);
+            }
+        }
+
+        return;
+    }
+
+    const int dim = depth % 4;
+    const int *mid = begin + (end - begin) / 2;
+    const double split = point(*mid)[dim];
+
+    if (within(*mid, q))
+    {
+        found.append(*mid);
+    }
+
+    // Everything before the middle is no greater than it, everything after
+    // no less
+    if (q.overlaps(dim, -HUGE_VAL, split))
+    {
+        search(begin, mid, depth + 1, q, found);
+    }
+
+    if (q.overlaps(dim, split, HUGE_VAL))
+    {
+        search(mid + 1, end, depth + 1, q, found);
+    }
+}
+
+bool PhaseSpaceTree::within(int i, const Query& q) const
+{
+    const double *p = point(i);
+
+    for (int d = 0; d < 4; ++d)
+    {
+        double dist = fabs(p[d] - q.centre[d]);
+
+        if (isAngle(d))
+        {
+            dist = qMin(dist, 2.0*pi - dist);
+        }
+
+        if (dist > q.epsilon)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef PHASESPACETREE_H
+#define PHASESPACETREE_H
+
+#include <QVector>
+
+/**
+ * A spatial index over points (θ1, ω1, θ2, ω2) of phase space supporting
+ * ε-neighbourhood queries, where distances are measured in the maximum
+ * norm with both angles taken modulo 2π.
+ *
+ * Points are added incrementally using the logarithmic method: the most
+ * recent points are kept in a small buffer which is searched linearly and
+ * the rest in a series of balanced k-d trees of doubling size, at most one
+ * of each.  When the buffer fills it is merged with the smallest trees into
+ * a new one.  Insertion costs amortised O(log² n) however the points
+ * arrive; trajectories, which arrive in a highly correlated order, would
+ * quickly unbalance a tree built by inserting leaves.  A query costs at
+ * worst O(n^(3/4)) plus the number of points found, the bound for a range
+ * search in a 4-d k-d tree, the tree sizes being geometric; for the small
+ * ε used it is typically nearer O(log² n).
+ *
+ * The trees are implicit: each is an array of point indices arranged so that
+ * the middle entry of any range splits the rest by coordinate depth mod 4,
+ * and so take no space beyond one index per point.
+ */
+class PhaseSpaceTree
+{
+public:
+    PhaseSpaceTree();
+
+    /**
+     * Adds a point, returning its index.
+     */
+    int insert(const double *y);
+
+    void clear();
+
+    int count() const
+    {
+        return m_coords.size() / 4;
+    }
+
+    /**
+     * Appends to found the indices, in no particular order, of all points
+     * within epsilon of y.
+     */
+    void neighbours(const double *y, double epsilon, QVector<int>& found) const;
+
+private:
+    struct Query;
+
+    void build(int *begin, int *end, int depth);
+    void search(const int *begin, const int *end, int depth,
+                const Query& q, QVector<int>& found) const;
+    bool within(int i, const Query& q) const;
+
+    const double *point(int i) const
+    {
+        return &m_coords[4*i];
+    }
+
+    /**
+     * Coordinates of every point, with the angles wrapped into [-π, π).
+     */
+    QVector<double> m_coords;
+
+    QVector<int> m_buffer;
+
+    /**
+     * Tree k is either empty or holds BUFFER_SIZE·2^k points.
+     */
+    QVector<QVector<int> > m_trees;
+};
+
+#endif // PHASESPACETREE_H
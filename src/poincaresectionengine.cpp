@@ -0,0 +1,173 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "poincaresectionengine.h"
+#include "doublependulumfactory.h"
+
+#include <QMutexLocker>
+#include <QtConcurrentMap>
+
+#include <cmath>
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+
+    /**
+     * Wraps an angle into [-π, π).
+     */
+    double wrapAngle(double theta)
+    {
+        return theta - 2.0*pi * floor((theta + pi) / (2.0*pi));
+    }
+}
+
+PoincareSectionEngine::PoincareSectionEngine(const QString& solver, double dt,
+                                             double g)
+    : m_solver(solver)
+    , m_dt(dt)
+    , m_g(g)
+    , m_valid(DoublePendulumFactory::solvers().contains(solver))
+    , m_pointsWritten(0)
+{
+}
+
+bool PoincareSectionEngine::isValid() const
+{
+    return m_valid;
+}
+
+void PoincareSectionEngine::addInitialCondition(const Pendulum& upper,
+                                                const Pendulum& lower)
+{
+    Job job;
+    job.upper = upper;
+    job.lower = lower;
+
+    m_jobs.append(job);
+}
+
+void PoincareSectionEngine::clear()
+{
+    m_jobs.clear();
+}
+
+int PoincareSectionEngine::count() const
+{
+    return m_jobs.count();
+}
+
+qint64 PoincareSectionEngine::run(const QString& fileName, double endTime)
+{
+    // The jobs create their pendula on pool threads, so check the solver here
+    if (!m_valid)
+    {
+        return -1;
+    }
+
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return -1;
+    }
+
+    // Header
+    const quint32 header[2] = { 1, sizeof(Record) };
+    m_file.write("DPPS", 4);
+    m_file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+    m_pointsWritten = 0;
+
+    for (int i = 0; i < m_jobs.count(); ++i)
+    {
+        m_jobs[i].engine = this;
+        m_jobs[i].index = i;
+        m_jobs[i].endTime = endTime;
+    }
+
+    QtConcurrent::blockingMap(m_jobs, PoincareSectionEngine::runJob);
+
+    m_file.close();
+
+    return m_pointsWritten;
+}
+
+void PoincareSectionEngine::runJob(Job& job)
+{
+    PoincareSectionEngine *engine = job.engine;
+
+    DoublePendulum *p = DoublePendulumFactory::create(engine->m_solver,
+                                                      job.upper, job.lower,
+                                                      engine->m_dt,
+                                                      engine->m_g);
+    Collector collector(engine, job.index);
+
+    p->setSectionListener(&collector);
+    p->update(job.endTime);
+
+    delete p;
+}
+
+void PoincareSectionEngine::write(const Record *records, int count)
+{
+    QMutexLocker locker(&m_fileMutex);
+
+    m_file.write(reinterpret_cast<const char *>(records),
+                 count * sizeof(Record));
+    m_pointsWritten += count;
+}
+
+PoincareSectionEngine::Collector::Collector(PoincareSectionEngine *engine,
+                                            quint32 trajectory)
+    : m_engine(engine)
+    , m_trajectory(trajectory)
+    , m_count(0)
+{
+}
+
+PoincareSectionEngine::Collector::~Collector()
+{
+    flush();
+}
+
+void PoincareSectionEngine::Collector::sectionCrossed(double, double omega1,
+                                                      double theta2,
+                                                      double omega2)
+{
+    Record& r = m_buffer[m_count];
+    r.trajectory = m_trajectory;
+    r.theta2 = wrapAngle(theta2);
+    r.omega1 = omega1;
+    r.omega2 = omega2;
+
+    if (++m_count == BUFFER_SIZE)
+    {
+        flush();
+    }
+}
+
+void PoincareSectionEngine::Collector::flush()
+{
+    if (m_count > 0)
+    {
+        m_engine->write(m_buffer, m_count);
+        m_count = 0;
+    }
+}
@@ -0,0 +1,127 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef POINCARESECTIONENGINE_H
+#define POINCARESECTIONENGINE_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "doublependulum.h"
+
+/**
+ * Computes the Poincaré section θ1 = 0, ω1 > 0 of many initial conditions
+ * in parallel, streaming the points to a binary file as they are found.
+ *
+ * The file starts with a 12 byte header: the magic "DPPS", a version and
+ * the record size, each a native-endian 32-bit integer after the magic.  It
+ * is followed by 16 byte records of a 32-bit trajectory index and θ2 (wrapped
+ * to [-π, π)), ω1 and ω2 as single precision floats.  Records from different
+ * trajectories are interleaved in blocks.
+ */
+class PoincareSectionEngine
+{
+public:
+    PoincareSectionEngine(const QString& solver, double dt, double g=9.81);
+
+    /**
+     * Whether the solver is known to DoublePendulumFactory; run() does
+     * nothing if not.
+     */
+    bool isValid() const;
+
+    void addInitialCondition(const Pendulum& upper, const Pendulum& lower);
+    void clear();
+    int count() const;
+
+    /**
+     * Integrates each initial condition to endTime, writing the section
+     * points to fileName.  Blocks until complete and returns the number of
+     * points written, or -1 if the engine is not valid or the file could
+     * not be opened.
+     */
+    qint64 run(const QString& fileName, double endTime);
+
+private:
+    struct Record
+    {
+        quint32 trajectory;
+        float theta2;
+        float omega1;
+        float omega2;
+    };
+
+    /**
+     * Per-trajectory listener which buffers points and hands them to the
+     * engine in blocks.
+     */
+    class Collector : public PoincareListener
+    {
+    public:
+        Collector(PoincareSectionEngine *engine, quint32 trajectory);
+        ~Collector();
+
+        void sectionCrossed(double t, double omega1,
+                            double theta2, double omega2);
+
+        void flush();
+
+    private:
+        enum
+        {
+            BUFFER_SIZE = 4096
+        };
+
+        PoincareSectionEngine *m_engine;
+        const quint32 m_trajectory;
+
+        Record m_buffer[BUFFER_SIZE];
+        int m_count;
+    };
+
+    struct Job
+    {
+        PoincareSectionEngine *engine;
+        quint32 index;
+        Pendulum upper, lower;
+        double endTime;
+    };
+
+    static void runJob(Job& job);
+
+    /**
+     * Appends records to the output file; thread safe.
+     */
+    void write(const Record *records, int count);
+
+    const QString m_solver;
+    const double m_dt;
+    const double m_g;
+    const bool m_valid;
+
+    QVector<Job> m_jobs;
+
+    QMutex m_fileMutex;
+    QFile m_file;
+    qint64 m_pointsWritten;
+};
+
+#endif // POINCARESECTIONENGINE_H
@@ -0,0 +1,133 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "poincaresectionwidget.h"
+
+#include <QPainter>
+
+#include <cmath>
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+}
+
+class PoincareSectionWidget::Listener : public PoincareListener
+{
+public:
+    Listener(PoincareSectionWidget *widget, QRgb colour)
+        : m_widget(widget)
+        , m_colour(colour)
+    {
+    }
+
+    void sectionCrossed(double, double, double theta2, double omega2)
+    {
+        m_widget->plotPoint(theta2, omega2, m_colour);
+    }
+
+private:
+    PoincareSectionWidget *m_widget;
+    const QRgb m_colour;
+};
+
+PoincareSectionWidget::PoincareSectionWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_image(512, 512, QImage::Format_RGB32)
+    , m_omegaRange(10.0)
+{
+    m_image.fill(qRgb(255, 255, 255));
+}
+
+PoincareSectionWidget::~PoincareSectionWidget()
+{
+    qDeleteAll(m_listeners);
+}
+
+PoincareListener *PoincareSectionWidget::createListener(const QColor& colour)
+{
+    Listener *listener = new Listener(this, colour.rgb());
+    m_listeners.append(listener);
+
+    return listener;
+}
+
+void PoincareSectionWidget::clear()
+{
+    qDeleteAll(m_listeners);
+    m_listeners.clear();
+
+    m_image.fill(qRgb(255, 255, 255));
+    update();
+}
+
+double PoincareSectionWidget::omegaRange() const
+{
+    return m_omegaRange;
+}
+
+void PoincareSectionWidget::setOmegaRange(double range)
+{
+    m_omegaRange = range;
+
+    // The listeners may still be attached to running pendula
+    m_image.fill(qRgb(255, 255, 255));
+    update();
+}
+
+QSize PoincareSectionWidget::sizeHint() const
+{
+    return QSize(256, 256);
+}
+
+void PoincareSectionWidget::plotPoint(double theta2, double omega2, QRgb colour)
+{
+    // Wrap θ2 into [-π, π)
+    theta2 -= 2.0*pi * floor((theta2 + pi) / (2.0*pi));
+
+    const int x = int((theta2 + pi) / (2.0*pi) * m_image.width());
+    const int y = int((m_omegaRange - omega2) / (2.0*m_omegaRange)
+                      * m_image.height());
+
+    if (m_image.valid(x, y))
+    {
+        m_image.setPixel(x, y, colour);
+
+        // Qt will coalesce the repaints
+        update();
+    }
+}
+
+void PoincareSectionWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.drawImage(rect(), m_image);
+
+    // Axes through θ2 = 0 and ω2 = 0
+    painter.setPen(QPen(Qt::gray, 0, Qt::DotLine));
+    painter.drawLine(width() / 2, 0, width() / 2, height());
+    painter.drawLine(0, height() / 2, width(), height() / 2);
+
+    painter.setPen(Qt::black);
+    painter.drawText(rect().adjusted(4, 4, -4, -4), Qt::AlignLeft | Qt::AlignTop,
+                     QString::fromUtf8("ω2 (±%1 rad/s)").arg(m_omegaRange));
+    painter.drawText(rect().adjusted(4, 4, -4, -4),
+                     Qt::AlignRight | Qt::AlignBottom,
+                     QString::fromUtf8("θ2 (-π…π)"));
+}
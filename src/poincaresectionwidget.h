@@ -0,0 +1,77 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef POINCARESECTIONWIDGET_H
+#define POINCARESECTIONWIDGET_H
+
+#include <QImage>
+#include <QList>
+#include <QWidget>
+
+#include "doublependulum.h"
+
+/**
+ * Plots the (θ2, ω2) Poincaré section points of the running pendula.
+ *
+ * Points are drawn straight into a fixed-size image as they arrive, so the
+ * cost of each repaint is independent of the number of points accumulated.
+ */
+class PoincareSectionWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    PoincareSectionWidget(QWidget *parent = 0);
+    ~PoincareSectionWidget();
+
+    /**
+     * Creates a listener which plots the points it receives in the given
+     * colour.  The listener is owned by the widget and remains valid until
+     * the next call to clear().
+     */
+    PoincareListener *createListener(const QColor& colour);
+
+    /**
+     * Erases all of the points and releases the listeners.
+     */
+    void clear();
+
+    /**
+     * Extent of the ω2 axis, which covers [-range, range] rad/s.  Changing
+     * it erases the points plotted so far but leaves the listeners be.
+     */
+    double omegaRange() const;
+    void setOmegaRange(double range);
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    class Listener;
+
+    void plotPoint(double theta2, double omega2, QRgb colour);
+
+    QImage m_image;
+    QList<Listener *> m_listeners;
+    double m_omegaRange;
+};
+
+#endif // POINCARESECTIONWIDGET_H
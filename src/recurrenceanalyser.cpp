@@ -0,0 +1,201 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "recurrenceanalyser.h"
+
+#include <algorithm>
+
+RecurrenceAnalyser::RecurrenceAnalyser(double sampleInterval, double epsilon,
+                                       int theilerWindow, int minLine,
+                                       int plotSize) :
+    m_sampleInterval(sampleInterval),
+    m_epsilon(epsilon),
+    m_theilerWindow(qMax(1, theilerWindow)),
+    m_minLine(minLine),
+    m_plotSize(plotSize),
+    m_recurrences(0),
+    m_plotScale(1),
+    m_plot(plotSize * plotSize, 0)
+{
+}
+
+void RecurrenceAnalyser::sample(const DoublePendulum&, double, const double *y)
+{
+    const int i = m_tree.count();
+
+    // Find the recurrences before adding ourself, dropping any inside the
+    // Theiler window
+    m_nextRow.clear();
+    m_tree.neighbours(y, m_epsilon, m_nextRow);
+    m_tree.insert(y);
+
+    int n = 0;
+
+    for (int k = 0; k < m_nextRow.size(); ++k)
+    {
+        if (m_nextRow[k] <= i - m_theilerWindow)
+        {
+            m_nextRow[n++] = m_nextRow[k];
+        }
+    }
+
+    m_nextRow.resize(n);
+    std::sort(m_nextRow.begin(), m_nextRow.end());
+
+    // Recurrence (i, j) continues the line through (i - 1, j - 1); lines
+    // through the last row which are not continued have ended
+    m_nextRuns.resize(n);
+
+    int p = 0;
+
+    for (int k = 0; k < n; ++k)
+    {
+        const int j = m_nextRow[k];
+
+        for (; p < m_row.size() && m_row[p] < j - 1; ++p)
+        {
+            ++m_lineLengths[m_runs[p]];
+        }
+
+        if (p < m_row.size() && m_row[p] == j - 1)
+        {
+            m_nextRuns[k] = m_runs[p++] + 1;
+
+            if (m_nextRuns[k] >= m_lineLengths.size())
+            {
+                m_lineLengths.resize(m_nextRuns[k] + 1);
+            }
+        }
+        else
+        {
+            m_nextRuns[k] = 1;
+
+            if (m_lineLengths.size() < 2)
+            {
+                m_lineLengths.resize(2);
+            }
+        }
+    }
+
+    for (; p < m_row.size(); ++p)
+    {
+        ++m_lineLengths[m_runs[p]];
+    }
+
+    m_row.swap(m_nextRow);
+    m_runs.swap(m_nextRuns);
+    m_recurrences += n;
+
+    // Halve the resolution of the plot once we run off the end of it
+    if (i / m_plotScale >= m_plotSize)
+    {
+        for (int cj = 0; cj < m_plotSize; ++cj)
+        {
+            for (int ci = 0; ci < m_plotSize; ++ci)
+            {
+                const int count = m_plot[cj*m_plotSize + ci];
+
+                m_plot[cj*m_plotSize + ci] = 0;
+                m_plot[(cj / 2)*m_plotSize + ci / 2] += count;
+            }
+        }
+
+        m_plotScale *= 2;
+    }
+
+    const int ci = int(i / m_plotScale);
+
+    for (int k = 0; k < n; ++k)
+    {
+        ++m_plot[int(m_row[k] / m_plotScale)*m_plotSize + ci];
+    }
+}
+
+double RecurrenceAnalyser::recurrenceRate() const
+{
+    // Sample i can recur with the i - w + 1 samples 0 … i - w, which summed
+    // over i = w … N - 1 gives m(m + 1)/2 pairs for m = N - w
+    const long m = samples() - m_theilerWindow;
+    const double pairs = (m > 0) ? 0.5 * m * (m + 1) : 0.0;
+
+    return (pairs > 0.0) ? m_recurrences / pairs : 0.0;
+}
+
+double RecurrenceAnalyser::determinism() const
+{
+    long points, lines;
+    int longest;
+
+    lineStats(&points, &lines, &longest);
+
+    return (m_recurrences > 0) ? double(points) / m_recurrences : 0.0;
+}
+
+double RecurrenceAnalyser::meanLine() const
+{
+    long points, lines;
+    int longest;
+
+    lineStats(&points, &lines, &longest);
+
+    return (lines > 0) ? double(points) / lines : 0.0;
+}
+
+int RecurrenceAnalyser::maxLine() const
+{
+    long points, lines;
+    int longest;
+
+    lineStats(&points, &lines, &longest);
+
+    return longest;
+}
+
+void RecurrenceAnalyser::lineStats(long *points, long *lines,
+                                   int *longest) const
+{
+    *points = *lines = 0;
+    *longest = 0;
+
+    for (int l = 1; l < m_lineLengths.size(); ++l)
+    {
+        if (m_lineLengths[l] > 0)
+        {
+            *longest = l;
+        }
+
+        if (l >= m_minLine)
+        {
+            *points += l * m_lineLengths[l];
+            *lines += m_lineLengths[l];
+        }
+    }
+
+    // Lines through the last row are still open but count all the same
+    for (int k = 0; k < m_runs.size(); ++k)
+    {
+        *longest = qMax(*longest, m_runs[k]);
+
+        if (m_runs[k] >= m_minLine)
+        {
+            *points += m_runs[k];
+            *lines += 1;
+        }
+    }
+}
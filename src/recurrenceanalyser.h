@@ -0,0 +1,146 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef RECURRENCEANALYSER_H
+#define RECURRENCEANALYSER_H
+
+#include "doublependulum.h"
+#include "phasespacetree.h"
+
+/**
+ * Streaming recurrence quantification analysis of a trajectory.
+ *
+ * The state is sampled at a fixed interval; each sample is compared against
+ * all earlier ones using a PhaseSpaceTree, and those within epsilon (in the
+ * maximum norm, with angles taken modulo 2π) are the recurrences.  Pairs of
+ * samples closer together in time than the Theiler window are ignored as
+ * they are trivially close.
+ *
+ * Diagonal lines of the recurrence plot are followed as each new row
+ * arrives, so the usual measures can be read off at any time without
+ * revisiting the history.  A fixed size summary of the plot, in which each
+ * cell counts the recurrences in a block of scale × scale pairs, is kept
+ * for display; the blocks double in size whenever the trajectory outgrows
+ * it.
+ */
+class RecurrenceAnalyser : public DoublePendulumObserver
+{
+public:
+    RecurrenceAnalyser(double sampleInterval=0.05, double epsilon=0.2,
+                       int theilerWindow=10, int minLine=2,
+                       int plotSize=256);
+
+    void sample(const DoublePendulum& pendulum, double t, const double *y);
+
+    double sampleInterval() const
+    {
+        return m_sampleInterval;
+    }
+
+    double epsilon() const
+    {
+        return m_epsilon;
+    }
+
+    long samples() const
+    {
+        return m_tree.count();
+    }
+
+    long recurrences() const
+    {
+        return m_recurrences;
+    }
+
+    /**
+     * Fraction of the pairs of samples which are recurrences (RR).
+     */
+    double recurrenceRate() const;
+
+    /**
+     * Fraction of the recurrences which lie on diagonal lines of at least
+     * minLine points (DET).
+     */
+    double determinism() const;
+
+    /**
+     * Average length of the diagonal lines of at least minLine points (L)
+     * and the longest line of all (Lmax).
+     */
+    double meanLine() const;
+    int maxLine() const;
+
+    int plotSize() const
+    {
+        return m_plotSize;
+    }
+
+    /**
+     * Number of samples along each side of a cell of the plot.
+     */
+    long plotScale() const
+    {
+        return m_plotScale;
+    }
+
+    /**
+     * Number of recurrences between samples in cells i and j of the plot,
+     * which is symmetric.
+     */
+    int plotCount(int i, int j) const
+    {
+        return (i >= j) ? m_plot[j*m_plotSize + i] : m_plot[i*m_plotSize + j];
+    }
+
+private:
+    void lineStats(long *points, long *lines, int *longest) const;
+
+    const double m_sampleInterval;
+    const double m_epsilon;
+    const int m_theilerWindow;
+    const int m_minLine;
+    const int m_plotSize;
+
+    PhaseSpaceTree m_tree;
+
+    long m_recurrences;
+
+    /**
+     * Number of finished diagonal lines of each length.
+     */
+    QVector<long> m_lineLengths;
+
+    /**
+     * Recurrences of the last sample, in ascending order, and the length of
+     * the line which each one ends.
+     */
+    QVector<int> m_row;
+    QVector<int> m_runs;
+
+    /**
+     * Scratch space for the next row.
+     */
+    QVector<int> m_nextRow;
+    QVector<int> m_nextRuns;
+
+    long m_plotScale;
+    QVector<int> m_plot;
+};
+
+#endif // RECURRENCEANALYSER_H
@@ -0,0 +1,141 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "recurrenceplotwidget.h"
+#include "recurrenceanalyser.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QTimer>
+
+#include <cmath>
+
+RecurrencePlotWidget::RecurrencePlotWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_timer(new QTimer(this))
+{
+    // The plots are cheap to draw, so simply repaint them periodically
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(update()));
+    m_timer->start(500);
+}
+
+RecurrencePlotWidget::~RecurrencePlotWidget()
+{
+    clear();
+}
+
+RecurrenceAnalyser *RecurrencePlotWidget::createAnalyser(const QColor& colour)
+{
+    Plot plot;
+    plot.analyser = new RecurrenceAnalyser;
+    plot.colour = colour;
+
+    m_plots.append(plot);
+    update();
+
+    return plot.analyser;
+}
+
+void RecurrencePlotWidget::clear()
+{
+    foreach (const Plot& plot, m_plots)
+    {
+        delete plot.analyser;
+    }
+
+    m_plots.clear();
+    update();
+}
+
+QSize RecurrencePlotWidget::sizeHint() const
+{
+    return QSize(256, 288);
+}
+
+void RecurrencePlotWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    if (m_plots.isEmpty())
+    {
+        return;
+    }
+
+    const int textHeight = 2 * fontMetrics().height();
+    const int side = qMin(width() / m_plots.size(), height() - textHeight);
+
+    if (side <= 0)
+    {
+        return;
+    }
+
+    for (int p = 0; p < m_plots.size(); ++p)
+    {
+        const RecurrenceAnalyser *analyser = m_plots.at(p).analyser;
+        const QColor& colour = m_plots.at(p).colour;
+
+        // Only the cells covering the samples so far are in use
+        const int cells = qMin(long(analyser->plotSize()),
+                               (analyser->samples() + analyser->plotScale() - 1)
+                               / analyser->plotScale());
+        const QRect target(p * side, 0, side, side);
+
+        if (cells > 0)
+        {
+            // Shade each cell by the fraction of its pairs which recur,
+            // with time running up the plot from the bottom left
+            const double pairs = double(analyser->plotScale())
+                               * analyser->plotScale();
+            QImage image(cells, cells, QImage::Format_RGB32);
+
+            for (int j = 0; j < cells; ++j)
+            {
+                QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(cells - 1 - j));
+
+                for (int i = 0; i < cells; ++i)
+                {
+                    const int count = analyser->plotCount(i, j);
+                    const double a = (count > 0)
+                                   ? qMin(1.0, 0.25 + 0.75*sqrt(count / pairs))
+                                   : 0.0;
+
+                    line[i] = qRgb(int(255 - a*(255 - colour.red())),
+                                   int(255 - a*(255 - colour.green())),
+                                   int(255 - a*(255 - colour.blue())));
+                }
+            }
+
+            painter.drawImage(target, image);
+        }
+
+        painter.setPen(Qt::gray);
+        painter.drawRect(target.adjusted(0, 0, -1, -1));
+
+        painter.setPen(Qt::black);
+        painter.drawText(QRect(target.left() + 4, target.bottom(),
+                               side - 8, textHeight),
+                         Qt::AlignLeft | Qt::AlignVCenter,
+                         tr("RR %1  DET %2\nL %3  Lmax %4")
+                         .arg(analyser->recurrenceRate(), 0, 'g', 3)
+                         .arg(analyser->determinism(), 0, 'f', 3)
+                         .arg(analyser->meanLine(), 0, 'f', 2)
+                         .arg(analyser->maxLine()));
+    }
+}
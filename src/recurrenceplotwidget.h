@@ -0,0 +1,70 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef RECURRENCEPLOTWIDGET_H
+#define RECURRENCEPLOTWIDGET_H
+
+#include <QColor>
+#include <QList>
+#include <QWidget>
+
+class QTimer;
+class RecurrenceAnalyser;
+
+/**
+ * Displays the recurrence plot of each running pendulum side by side, each
+ * beneath its recurrence rate, determinism and mean diagonal line length.
+ */
+class RecurrencePlotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    RecurrencePlotWidget(QWidget *parent = 0);
+    ~RecurrencePlotWidget();
+
+    /**
+     * Creates an analyser whose plot is drawn in the given colour.  The
+     * analyser is owned by the widget and remains valid until the next call
+     * to clear().
+     */
+    RecurrenceAnalyser *createAnalyser(const QColor& colour);
+
+    /**
+     * Removes all of the plots and releases the analysers.
+     */
+    void clear();
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    struct Plot
+    {
+        RecurrenceAnalyser *analyser;
+        QColor colour;
+    };
+
+    QList<Plot> m_plots;
+    QTimer *m_timer;
+};
+
+#endif // RECURRENCEPLOTWIDGET_H
@@ -0,0 +1,123 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "slidingdft.h"
+#include "fft.h"
+
+#include <cmath>
+#include <cassert>
+
+SlidingDFT::SlidingDFT(int size) :
+    m_size(size),
+    m_window(new double[size]),
+    m_bins(new std::complex<double>[size / 2 + 1]),
+    m_twiddles(new std::complex<double>[size / 2 + 1]),
+    m_scratch(new std::complex<double>[size])
+{
+    assert(FFT::isPowerOfTwo(size) && size >= 4);
+
+    const double theta = 2.0 * 3.14159265358979323846 / size;
+
+    for (int k = 0; k <= size / 2; ++k)
+    {
+        m_twiddles[k] = std::complex<double>(cos(theta * k), sin(theta * k));
+    }
+
+    reset();
+}
+
+SlidingDFT::~SlidingDFT()
+{
+    delete[] m_window;
+    delete[] m_bins;
+    delete[] m_twiddles;
+    delete[] m_scratch;
+}
+
+void SlidingDFT::reset()
+{
+    for (int i = 0; i < m_size; ++i)
+    {
+        m_window[i] = 0.0;
+    }
+
+    for (int k = 0; k <= m_size / 2; ++k)
+    {
+        m_bins[k] = 0.0;
+    }
+
+    m_pos = 0;
+    m_count = 0;
+}
+
+void SlidingDFT::push(double x)
+{
+    const double delta = x - m_window[m_pos];
+
+    m_window[m_pos] = x;
+    m_pos = (m_pos + 1) & (m_size - 1);
+
+    for (int k = 0; k <= m_size / 2; ++k)
+    {
+        m_bins[k] = (m_bins[k] + delta) * m_twiddles[k];
+    }
+
+    if (++m_count % m_size == 0)
+    {
+        resync();
+    }
+}
+
+void SlidingDFT::resync()
+{
+    // Oldest sample first, to match the phase convention of push()
+    for (int i = 0; i < m_size; ++i)
+    {
+        m_scratch[i] = m_window[(m_pos + i) & (m_size - 1)];
+    }
+
+    FFT::transform(m_scratch, m_size);
+
+    for (int k = 0; k <= m_size / 2; ++k)
+    {
+        m_bins[k] = m_scratch[k];
+    }
+}
+
+double SlidingDFT::magnitude(int k) const
+{
+    const int n = m_size / 2;
+
+    assert(k >= 0 && k <= n);
+
+    // The bins either side, using X_{-k} = conj(X_k) for a real signal
+    const std::complex<double> below = (k > 0) ? m_bins[k - 1]
+                                               : std::conj(m_bins[1]);
+    const std::complex<double> above = (k < n) ? m_bins[k + 1]
+                                               : std::conj(m_bins[n - 1]);
+
+    // Hann window, w_m = ½ - ½cos(2πm/N), applied as a convolution
+    const std::complex<double> y = 0.5*m_bins[k] - 0.25*(below + above);
+
+    // Undo the coherent gain of the window, N/2, and, other than at zero
+    // and the Nyquist frequency, fold in the negative frequencies
+    const double scale = (k > 0 && k < n) ? 4.0 : 2.0;
+
+    return scale * std::abs(y) / m_size;
+}
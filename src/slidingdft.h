@@ -0,0 +1,111 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SLIDINGDFT_H
+#define SLIDINGDFT_H
+
+#include <complex>
+
+/**
+ * Discrete Fourier transform over the most recent N samples of a real
+ * signal, updated as each sample arrives.
+ *
+ * Each new sample updates the non-negative frequency bins in O(N/2) using
+ * X_k ← (X_k - x_old + x_new)·exp(2πik/N).  As the rounding errors of this
+ * recurrence accumulate without bound the bins are recomputed from the
+ * window with an FFT every N samples.  Magnitudes are reported with a Hann
+ * window, which is applied in the frequency domain.
+ */
+class SlidingDFT
+{
+public:
+    /**
+     * Creates a transform over size samples, which must be a power of two.
+     */
+    SlidingDFT(int size);
+    ~SlidingDFT();
+
+    void push(double x);
+
+    /**
+     * Clears the window back to all zeros.
+     */
+    void reset();
+
+    int size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Returns the number of bins, N/2 + 1, running from zero frequency up
+     * to the Nyquist frequency.
+     */
+    int bins() const
+    {
+        return m_size / 2 + 1;
+    }
+
+    /**
+     * Returns true once a full window of samples has been pushed.
+     */
+    bool full() const
+    {
+        return m_count >= m_size;
+    }
+
+    /**
+     * Returns the Hann-windowed magnitude of bin k, scaled such that a
+     * sinusoid of amplitude A centred on a bin (or a constant A) gives A.
+     */
+    double magnitude(int k) const;
+
+private:
+    // Owns its buffers and so can not be copied
+    SlidingDFT(const SlidingDFT&);
+    SlidingDFT& operator=(const SlidingDFT&);
+
+    /**
+     * Recomputes the bins from the samples in the window.
+     */
+    void resync();
+
+    const int m_size;
+
+    /**
+     * Circular buffer of the last N samples; m_pos is the oldest.
+     */
+    double *m_window;
+    int m_pos;
+    long m_count;
+
+    /**
+     * Non-negative frequency bins and the factors, exp(2πik/N), which
+     * advance them by one sample.
+     */
+    std::complex<double> *m_bins;
+    std::complex<double> *m_twiddles;
+
+    /**
+     * Scratch space for resync().
+     */
+    std::complex<double> *m_scratch;
+};
+
+#endif // SLIDINGDFT_H
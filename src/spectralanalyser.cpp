@@ -0,0 +1,61 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "spectralanalyser.h"
+
+SpectralAnalyser::SpectralAnalyser(double sampleInterval, int windowSize,
+                                   int hop, int history) :
+    m_sampleInterval(sampleInterval),
+    m_hop(hop),
+    m_history(history),
+    m_upper(windowSize),
+    m_lower(windowSize),
+    m_samples(0),
+    m_columns(0),
+    m_spectrogram(new float[history * 2 * (windowSize / 2 + 1)])
+{
+}
+
+SpectralAnalyser::~SpectralAnalyser()
+{
+    delete[] m_spectrogram;
+}
+
+void SpectralAnalyser::sample(const DoublePendulum&, double, const double *y)
+{
+    // State is θ1, ω1, θ2, ω2; the angles themselves grow without bound
+    // when an arm rotates, so analyse the angular velocities
+    m_upper.push(y[1]);
+    m_lower.push(y[3]);
+
+    if (++m_samples % m_hop != 0 || !m_upper.full())
+    {
+        return;
+    }
+
+    float *column = &m_spectrogram[(m_columns % m_history) * 2 * bins()];
+
+    for (int k = 0; k < bins(); ++k)
+    {
+        column[k] = m_upper.magnitude(k);
+        column[bins() + k] = m_lower.magnitude(k);
+    }
+
+    ++m_columns;
+}
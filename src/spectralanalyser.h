@@ -0,0 +1,107 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SPECTRALANALYSER_H
+#define SPECTRALANALYSER_H
+
+#include "doublependulum.h"
+#include "slidingdft.h"
+
+/**
+ * Streaming spectral analysis of the angular velocities of both arms.
+ *
+ * The state is sampled at a fixed interval and pushed into a sliding DFT
+ * per arm; after every hop samples the current spectrum of each is saved
+ * as a column of a spectrogram, of which the most recent history columns
+ * are kept.  The cost per sample is O(bins) and nothing is allocated after
+ * construction.
+ */
+class SpectralAnalyser : public DoublePendulumObserver
+{
+public:
+    SpectralAnalyser(double sampleInterval=1.0/32.0, int windowSize=256,
+                     int hop=8, int history=512);
+    ~SpectralAnalyser();
+
+    void sample(const DoublePendulum& pendulum, double t, const double *y);
+
+    double sampleInterval() const
+    {
+        return m_sampleInterval;
+    }
+
+    int bins() const
+    {
+        return m_upper.bins();
+    }
+
+    /**
+     * Returns the frequency (in Hz) at the centre of bin k.
+     */
+    double binFrequency(int k) const
+    {
+        return k / (m_upper.size() * m_sampleInterval);
+    }
+
+    int history() const
+    {
+        return m_history;
+    }
+
+    /**
+     * Returns the number of columns produced so far; only the last
+     * history() of these are retained.
+     */
+    long columns() const
+    {
+        return m_columns;
+    }
+
+    /**
+     * Returns the magnitude of bin k of the given arm (0 for the upper, 1
+     * for the lower) in the given column.
+     */
+    float magnitude(int arm, long column, int k) const
+    {
+        return m_spectrogram[((column % m_history)*2 + arm)*bins() + k];
+    }
+
+private:
+    // Owns its buffers and so can not be copied
+    SpectralAnalyser(const SpectralAnalyser&);
+    SpectralAnalyser& operator=(const SpectralAnalyser&);
+
+    const double m_sampleInterval;
+    const int m_hop;
+    const int m_history;
+
+    SlidingDFT m_upper;
+    SlidingDFT m_lower;
+
+    long m_samples;
+    long m_columns;
+
+    /**
+     * Circular buffer of history columns, each holding the spectra of the
+     * upper and then the lower arm.
+     */
+    float *m_spectrogram;
+};
+
+#endif // SPECTRALANALYSER_H
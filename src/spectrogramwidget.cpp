@@ -0,0 +1,200 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "spectrogramwidget.h"
+#include "spectralanalyser.h"
+
+#include <QPainter>
+#include <QTimer>
+
+#include <cmath>
+
+namespace
+{
+    // Range of log10(magnitude) covered by the palette
+    const double LOG_MIN = -4.0;
+    const double LOG_MAX = 1.0;
+
+    // Width of the colour swatch identifying each band
+    const int SWATCH = 6;
+}
+
+SpectrogramWidget::SpectrogramWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_timer(new QTimer(this))
+{
+    // Black through blue, red and yellow to white
+    for (int i = 0; i < 256; ++i)
+    {
+        const double x = i / 255.0;
+
+        const double r = 4.0*x - 1.0;
+        const double g = 4.0*x - 2.0;
+        const double b = (x < 0.25) ? 4.0*x
+                       : (x < 0.5)  ? 2.0 - 4.0*x
+                       : (x < 0.75) ? 0.0 : 4.0*x - 3.0;
+
+        m_palette[i] = qRgb(qBound(0, int(255 * r), 255),
+                            qBound(0, int(255 * g), 255),
+                            qBound(0, int(255 * b), 255));
+    }
+
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+    m_timer->start(100);
+}
+
+SpectrogramWidget::~SpectrogramWidget()
+{
+    clear();
+}
+
+SpectralAnalyser *SpectrogramWidget::createAnalyser(const QColor& colour)
+{
+    Band *band = new Band;
+
+    band->analyser = new SpectralAnalyser;
+    band->colour = colour;
+    band->image = QImage(band->analyser->history(),
+                         2 * band->analyser->bins(), QImage::Format_RGB32);
+    band->image.fill(m_palette[0]);
+    band->drawn = 0;
+
+    m_bands.append(band);
+    update();
+
+    return band->analyser;
+}
+
+void SpectrogramWidget::clear()
+{
+    foreach (Band *band, m_bands)
+    {
+        delete band->analyser;
+        delete band;
+    }
+
+    m_bands.clear();
+    update();
+}
+
+QSize SpectrogramWidget::sizeHint() const
+{
+    return QSize(256, 256);
+}
+
+void SpectrogramWidget::refresh()
+{
+    bool changed = false;
+
+    foreach (Band *band, m_bands)
+    {
+        const SpectralAnalyser *analyser = band->analyser;
+        const long columns = analyser->columns();
+        const int bins = analyser->bins();
+
+        // Anything older than the history has already been overwritten
+        if (columns - band->drawn > analyser->history())
+        {
+            band->drawn = columns - analyser->history();
+        }
+
+        for (long c = band->drawn; c < columns; ++c)
+        {
+            const int x = int(c % band->image.width());
+
+            for (int arm = 0; arm < 2; ++arm)
+            {
+                for (int k = 0; k < bins; ++k)
+                {
+                    const double mag = analyser->magnitude(arm, c, k);
+                    const double level = (mag > 0.0)
+                                       ? (log10(mag) - LOG_MIN)
+                                       / (LOG_MAX - LOG_MIN)
+                                       : 0.0;
+
+                    const int y = arm*bins + (bins - 1 - k);
+
+                    band->image.setPixel(x, y,
+                        m_palette[qBound(0, int(255 * level), 255)]);
+                }
+            }
+
+            changed = true;
+        }
+
+        band->drawn = columns;
+    }
+
+    if (changed)
+    {
+        update();
+    }
+}
+
+void SpectrogramWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    if (m_bands.isEmpty())
+    {
+        return;
+    }
+
+    const int bandHeight = height() / m_bands.size();
+    const int plotWidth = width() - SWATCH;
+
+    for (int i = 0; i < m_bands.size(); ++i)
+    {
+        const Band *band = m_bands.at(i);
+        const QImage& image = band->image;
+        const QRect target(SWATCH, i * bandHeight, plotWidth, bandHeight);
+
+        painter.fillRect(0, target.top(), SWATCH, bandHeight, band->colour);
+
+        // Draw the circular buffer unrolled so that the newest column is at
+        // the right hand edge
+        const int split = int(band->drawn % image.width());
+        const int oldWidth = image.width() - split;
+        const int targetSplit = target.left()
+                              + plotWidth * oldWidth / image.width();
+
+        painter.drawImage(QRect(target.left(), target.top(),
+                                targetSplit - target.left(), bandHeight),
+                          image, QRect(split, 0, oldWidth, image.height()));
+        painter.drawImage(QRect(targetSplit, target.top(),
+                                target.right() + 1 - targetSplit, bandHeight),
+                          image, QRect(0, 0, split, image.height()));
+
+        // Separate the two arms and the bands
+        painter.setPen(QPen(Qt::gray, 0, Qt::DotLine));
+        painter.drawLine(target.left(), target.center().y(),
+                         target.right(), target.center().y());
+        painter.setPen(Qt::white);
+        painter.drawLine(0, target.bottom(), width(), target.bottom());
+    }
+
+    const SpectralAnalyser *analyser = m_bands.first()->analyser;
+
+    painter.setPen(Qt::white);
+    painter.drawText(rect().adjusted(SWATCH + 4, 4, -4, -4),
+                     Qt::AlignLeft | Qt::AlignTop,
+                     QString::fromUtf8("ω1 / ω2, 0…%1 Hz")
+                     .arg(analyser->binFrequency(analyser->bins() - 1)));
+}
@@ -0,0 +1,90 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef SPECTROGRAMWIDGET_H
+#define SPECTROGRAMWIDGET_H
+
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QWidget>
+
+class QTimer;
+class SpectralAnalyser;
+
+/**
+ * Displays scrolling spectrograms of the angular velocities of each arm of
+ * the running pendula, one band per pendulum.
+ *
+ * New columns are picked up from the analysers on a timer and drawn into a
+ * per-pendulum image used as a circular buffer, so the cost of keeping the
+ * display current is proportional to the number of new columns only.
+ */
+class SpectrogramWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SpectrogramWidget(QWidget *parent = 0);
+    ~SpectrogramWidget();
+
+    /**
+     * Creates an analyser whose spectra are shown in a band labelled with
+     * the given colour.  The analyser is owned by the widget and remains
+     * valid until the next call to clear().
+     */
+    SpectralAnalyser *createAnalyser(const QColor& colour);
+
+    /**
+     * Removes all of the bands and releases the analysers.
+     */
+    void clear();
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    struct Band
+    {
+        SpectralAnalyser *analyser;
+        QColor colour;
+
+        /**
+         * Upper arm spectrogram above the lower, high frequencies at the
+         * top of each; column c of the analyser is drawn at x = c mod width.
+         */
+        QImage image;
+        long drawn;
+    };
+
+    QList<Band *> m_bands;
+    QTimer *m_timer;
+
+    /**
+     * Maps log magnitudes onto colours.
+     */
+    QRgb m_palette[256];
+};
+
+#endif // SPECTROGRAMWIDGET_H
@@ -0,0 +1,294 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "stripchartwidget.h"
+#include "minmaxpyramid.h"
+
+#include <QPainter>
+#include <QPolygonF>
+#include <QTimer>
+#include <QVector>
+#include <QWheelEvent>
+
+#include <cmath>
+
+namespace
+{
+    const double SAMPLE_INTERVAL = 0.02;
+
+    const char *const CHANNEL_NAMES[] =
+    {
+        "θ1 (rad)", "θ2 (rad)", "ω1 (rad/s)", "ω2 (rad/s)", "E (J)"
+    };
+}
+
+class StripChartWidget::Recorder : public DoublePendulumObserver
+{
+public:
+    Recorder(const QColor& colour)
+        : m_colour(colour)
+    {
+    }
+
+    void sample(const DoublePendulum& pendulum, double, const double *y)
+    {
+        // The state is θ1, ω1, θ2, ω2
+        m_series[THETA_1].append(y[0]);
+        m_series[OMEGA_1].append(y[1]);
+        m_series[THETA_2].append(y[2]);
+        m_series[OMEGA_2].append(y[3]);
+        m_series[ENERGY].append(pendulum.energy(y));
+    }
+
+    const QColor& colour() const
+    {
+        return m_colour;
+    }
+
+    const MinMaxPyramid& series(int channel) const
+    {
+        return m_series[channel];
+    }
+
+private:
+    const QColor m_colour;
+
+    MinMaxPyramid m_series[NUM_CHANNELS];
+};
+
+StripChartWidget::StripChartWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_timer(new QTimer(this))
+    , m_span(0.0)
+    , m_painted(0)
+{
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+    m_timer->start(100);
+}
+
+StripChartWidget::~StripChartWidget()
+{
+    qDeleteAll(m_recorders);
+}
+
+DoublePendulumObserver *StripChartWidget::createRecorder(const QColor& colour)
+{
+    Recorder *recorder = new Recorder(colour);
+    m_recorders.append(recorder);
+
+    return recorder;
+}
+
+void StripChartWidget::clear()
+{
+    qDeleteAll(m_recorders);
+    m_recorders.clear();
+
+    m_painted = 0;
+    update();
+}
+
+double StripChartWidget::sampleInterval() const
+{
+    return SAMPLE_INTERVAL;
+}
+
+double StripChartWidget::span() const
+{
+    return m_span;
+}
+
+void StripChartWidget::setSpan(double span)
+{
+    m_span = span;
+    update();
+}
+
+QSize StripChartWidget::sizeHint() const
+{
+    return QSize(256, 320);
+}
+
+void StripChartWidget::refresh()
+{
+    // All of the recorders sample at the same rate, so it is enough to
+    // watch the first
+    if (!m_recorders.isEmpty()
+     && m_recorders.first()->series(THETA_1).count() != m_painted)
+    {
+        update();
+    }
+}
+
+void StripChartWidget::wheelEvent(QWheelEvent *event)
+{
+    if (m_recorders.isEmpty())
+    {
+        return;
+    }
+
+    const double total = m_recorders.first()->series(THETA_1).count()
+                       * SAMPLE_INTERVAL;
+    const double current = (m_span > 0.0) ? m_span : total;
+
+    // Each notch halves or doubles the span; going beyond the length of the
+    // run shows all of it
+    double span = (event->delta() > 0) ? 0.5 * current : 2.0 * current;
+
+    if (span >= total)
+    {
+        span = 0.0;
+    }
+
+    setSpan(qMax(span, 10 * SAMPLE_INTERVAL));
+}
+
+void StripChartWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    if (m_recorders.isEmpty())
+    {
+        return;
+    }
+
+    const long count = m_recorders.first()->series(THETA_1).count();
+    const long shown = (m_span > 0.0)
+                     ? qMin(count, long(m_span / SAMPLE_INTERVAL))
+                     : count;
+
+    m_painted = count;
+
+    if (shown < 2)
+    {
+        return;
+    }
+
+    const double samplesPerPixel = double(shown) / width();
+    const int stripHeight = height() / NUM_CHANNELS;
+
+    for (int c = 0; c < NUM_CHANNELS; ++c)
+    {
+        const QRect strip(0, c * stripHeight, width(), stripHeight);
+
+        paintChannel(&painter, c, strip.adjusted(0, 2, 0, -2),
+                     count - shown, samplesPerPixel);
+
+        painter.setPen(Qt::black);
+        painter.drawText(strip.adjusted(4, 2, -4, -2),
+                         Qt::AlignLeft | Qt::AlignTop,
+                         QString::fromUtf8(CHANNEL_NAMES[c]));
+        painter.setPen(Qt::gray);
+        painter.drawLine(strip.bottomLeft(), strip.bottomRight());
+    }
+
+    painter.setPen(Qt::black);
+    painter.drawText(rect().adjusted(4, 4, -4, -4),
+                     Qt::AlignRight | Qt::AlignBottom,
+                     tr("%1 s").arg(shown * SAMPLE_INTERVAL, 0, 'f', 1));
+}
+
+void StripChartWidget::paintChannel(QPainter *painter, int channel,
+                                    const QRect& rect, long firstSample,
+                                    double samplesPerPixel)
+{
+    const long lastSample = m_recorders.first()->series(channel).count() - 1;
+
+    // Scale to the extremes of all of the series over the visible range
+    float lo = 0.0f, hi = 0.0f;
+
+    for (int i = 0; i < m_recorders.size(); ++i)
+    {
+        float min, max;
+        m_recorders.at(i)->series(channel).minMax(firstSample, lastSample,
+                                                  &min, &max);
+
+        lo = (i == 0) ? min : qMin(lo, min);
+        hi = (i == 0) ? max : qMax(hi, max);
+    }
+
+    if (hi - lo < 1e-6f * (1.0f + qAbs(hi)))
+    {
+        lo -= 0.5f;
+        hi += 0.5f;
+    }
+
+    const double yScale = (rect.height() - 1) / double(hi - lo);
+
+    painter->setRenderHint(QPainter::Antialiasing, false);
+
+    foreach (const Recorder *recorder, m_recorders)
+    {
+        const MinMaxPyramid& series = recorder->series(channel);
+
+        painter->setPen(QPen(recorder->colour(), 0));
+
+        if (samplesPerPixel <= 1.0)
+        {
+            // Fewer samples than pixels; join them up
+            QPolygonF line;
+
+            for (long i = firstSample; i <= lastSample; ++i)
+            {
+                line << QPointF(rect.left() + (i - firstSample) / samplesPerPixel,
+                                rect.bottom() - (series.value(i) - lo) * yScale);
+            }
+
+            painter->drawPolyline(line);
+        }
+        else
+        {
+            // A vertical line per column spanning the extremes of its
+            // samples, stretched to meet those of the previous column
+            QVector<QLineF> lines;
+            lines.reserve(rect.width());
+
+            float prevMin = 0.0f, prevMax = 0.0f;
+
+            for (int x = 0; x < rect.width(); ++x)
+            {
+                const long first = firstSample + long(x * samplesPerPixel);
+                const long last = firstSample
+                                + long((x + 1) * samplesPerPixel) - 1;
+
+                float min, max;
+                series.minMax(first, last, &min, &max);
+
+                if (min > max)
+                {
+                    continue;
+                }
+
+                const float top = (x > 0) ? qMax(max, prevMin) : max;
+                const float bottom = (x > 0) ? qMin(min, prevMax) : min;
+
+                lines.append(QLineF(rect.left() + x,
+                                    rect.bottom() - (bottom - lo) * yScale,
+                                    rect.left() + x,
+                                    rect.bottom() - (top - lo) * yScale));
+
+                prevMin = min;
+                prevMax = max;
+            }
+
+            painter->drawLines(lines);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef STRIPCHARTWIDGET_H
+#define STRIPCHARTWIDGET_H
+
+#include <QColor>
+#include <QList>
+#include <QWidget>
+
+#include "doublependulum.h"
+
+class QTimer;
+
+/**
+ * Plots θ1, θ2, ω1, ω2 and the energy of the running pendula against time
+ * as a set of stacked strip charts.
+ *
+ * Every series is held in a MinMaxPyramid so that, however many samples
+ * have been recorded and whatever the zoom level, each column of pixels is
+ * drawn from a handful of precomputed extremes.  The time axis always ends
+ * at the latest sample; the mouse wheel changes the span shown.
+ */
+class StripChartWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    StripChartWidget(QWidget *parent = 0);
+    ~StripChartWidget();
+
+    /**
+     * Creates an observer which records the state of a pendulum and plots it
+     * in the given colour.  It should be sampled every sampleInterval()
+     * seconds and is owned by the widget, remaining valid until the next
+     * call to clear().
+     */
+    DoublePendulumObserver *createRecorder(const QColor& colour);
+
+    /**
+     * Removes all of the series and releases their recorders.
+     */
+    void clear();
+
+    double sampleInterval() const;
+
+    /**
+     * Span of time shown (in s); zero shows the whole run.
+     */
+    double span() const;
+    void setSpan(double span);
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void wheelEvent(QWheelEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    class Recorder;
+
+    enum
+    {
+        THETA_1,
+        THETA_2,
+        OMEGA_1,
+        OMEGA_2,
+        ENERGY,
+        NUM_CHANNELS
+    };
+
+    void paintChannel(QPainter *painter, int channel, const QRect& rect,
+                      long firstSample, double samplesPerPixel);
+
+    QList<Recorder *> m_recorders;
+    QTimer *m_timer;
+
+    double m_span;
+
+    /**
+     * Number of samples there were when last painted.
+     */
+    long m_painted;
+};
+
+#endif // STRIPCHARTWIDGET_H
@@ -0,0 +1,408 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "timewarpbuffer.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+namespace
+{
+    void snapshot(DoublePendulum *pendulum, DoublePendulumState& state)
+    {
+        state.y[0] = pendulum->theta1();
+        state.y[1] = pendulum->omega1();
+        state.y[2] = pendulum->theta2();
+        state.y[3] = pendulum->omega2();
+    }
+}
+
+class TimeWarpBuffer::Producer : public QThread
+{
+public:
+    Producer(TimeWarpBuffer *buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+protected:
+    void run()
+    {
+        m_buffer->produce();
+    }
+
+private:
+    TimeWarpBuffer *m_buffer;
+};
+
+class TimeWarpBuffer::ObserverRelay : public DoublePendulumObserver
+{
+public:
+    ObserverRelay(TimeWarpBuffer *buffer, int index,
+                  DoublePendulumObserver *observer)
+        : m_buffer(buffer)
+        , m_index(index)
+        , m_observer(observer)
+    {
+    }
+
+    void sample(const DoublePendulum& pendulum, double t, const double *y)
+    {
+        Call call;
+        call.relay = m_index;
+        call.crossing = false;
+        call.pendulum = &pendulum;
+        call.t = t;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            call.y[i] = y[i];
+        }
+
+        m_buffer->record(call);
+    }
+
+    TimeWarpBuffer *m_buffer;
+    const int m_index;
+    DoublePendulumObserver *m_observer;
+};
+
+class TimeWarpBuffer::ListenerRelay : public PoincareListener
+{
+public:
+    ListenerRelay(TimeWarpBuffer *buffer, int index, PoincareListener *listener)
+        : m_buffer(buffer)
+        , m_index(index)
+        , m_listener(listener)
+    {
+    }
+
+    void sectionCrossed(double t, double omega1, double theta2, double omega2)
+    {
+        Call call;
+        call.relay = m_index;
+        call.crossing = true;
+        call.pendulum = 0;
+        call.t = t;
+        call.y[0] = omega1;
+        call.y[1] = theta2;
+        call.y[2] = omega2;
+        call.y[3] = 0.0;
+
+        m_buffer->record(call);
+    }
+
+    TimeWarpBuffer *m_buffer;
+    const int m_index;
+    PoincareListener *m_listener;
+};
+
+TimeWarpBuffer::TimeWarpBuffer()
+    : m_producer(0)
+    , m_tick(0.01)
+    , m_warp(1.0)
+    , m_head(0)
+    , m_tail(0)
+    , m_count(0)
+    , m_quit(false)
+    , m_clock(0.0)
+    , m_clockWarp(1.0)
+    , m_currentTime(0.0)
+    , m_hasCurrent(false)
+    , m_replayed(0)
+{
+}
+
+TimeWarpBuffer::~TimeWarpBuffer()
+{
+    stop();
+}
+
+int TimeWarpBuffer::addPendulum(DoublePendulum *pendulum)
+{
+    m_pendula.append(pendulum);
+    m_stepper.addPendulum(pendulum);
+
+    return m_pendula.size() - 1;
+}
+
+DoublePendulumObserver *TimeWarpBuffer::relay(DoublePendulumObserver *observer)
+{
+    if (!observer || observer->isThreadSafe())
+    {
+        return observer;
+    }
+
+    ObserverRelay *relay = new ObserverRelay(this, m_observerRelays.size(),
+                                             observer);
+    m_observerRelays.append(relay);
+
+    return relay;
+}
+
+PoincareListener *TimeWarpBuffer::relay(PoincareListener *listener)
+{
+    if (!listener)
+    {
+        return 0;
+    }
+
+    ListenerRelay *relay = new ListenerRelay(this, m_listenerRelays.size(),
+                                             listener);
+    m_listenerRelays.append(relay);
+
+    return relay;
+}
+
+double TimeWarpBuffer::timeWarp() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_warp;
+}
+
+void TimeWarpBuffer::setTimeWarp(double warp)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_warp = warp;
+}
+
+void TimeWarpBuffer::start(double tick)
+{
+    halt();
+
+    m_tick = tick;
+
+    m_frames = QVector<Frame>(LOOKAHEAD);
+
+    for (int i = 0; i < LOOKAHEAD; ++i)
+    {
+        m_frames[i].states.resize(m_pendula.size());
+    }
+
+    m_head = m_tail = m_count = 0;
+    m_quit = false;
+
+    // Until the first frame arrives show the initial states
+    m_current.resize(m_pendula.size());
+
+    for (int i = 0; i < m_pendula.size(); ++i)
+    {
+        snapshot(m_pendula[i], m_current[i]);
+    }
+
+    m_clock = m_currentTime = 0.0;
+    m_clockWarp = m_warp;
+    m_hasCurrent = false;
+    m_replayed = 0;
+
+    m_producer = new Producer(this);
+    m_producer->start();
+}
+
+void TimeWarpBuffer::stop()
+{
+    halt();
+
+    qDeleteAll(m_observerRelays);
+    m_observerRelays.clear();
+
+    qDeleteAll(m_listenerRelays);
+    m_listenerRelays.clear();
+
+    m_pendula.clear();
+    m_stepper.clear();
+    m_frames.clear();
+    m_current.clear();
+}
+
+void TimeWarpBuffer::halt()
+{
+    if (m_producer)
+    {
+        m_mutex.lock();
+        m_quit = true;
+        m_notFull.wakeAll();
+        m_mutex.unlock();
+
+        m_producer->wait();
+
+        delete m_producer;
+        m_producer = 0;
+    }
+}
+
+double TimeWarpBuffer::advance(double elapsed)
+{
+    int available;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        available = m_count;
+    }
+
+    // Run at the warp of the next frame, so that its spacing is kept
+    if (available > 0)
+    {
+        m_clockWarp = m_frames.at(m_tail).warp;
+    }
+
+    m_clock += elapsed * m_clockWarp;
+
+    int consumed = 0;
+    int budget = MAX_REPLAY;
+    bool lagging = false;
+
+    while (consumed < available)
+    {
+        const Frame& frame = m_frames.at((m_tail + consumed) % LOOKAHEAD);
+
+        if (m_hasCurrent && frame.time > m_clock)
+        {
+            break;
+        }
+
+        // Out of calls for now; the rest of the frame waits for next time
+        if (!replay(frame, budget))
+        {
+            lagging = true;
+            break;
+        }
+
+        m_currentTime = frame.time;
+        m_hasCurrent = true;
+
+        ++consumed;
+    }
+
+    if (consumed > 0)
+    {
+        const int last = (m_tail + consumed - 1) % LOOKAHEAD;
+        m_current = m_frames.at(last).states;
+
+        m_tail = (m_tail + consumed) % LOOKAHEAD;
+
+        QMutexLocker locker(&m_mutex);
+        m_count -= consumed;
+        m_notFull.wakeOne();
+    }
+
+    // If we have caught up with the integration, or the replay is behind,
+    // then wait for it
+    if (consumed == available || lagging)
+    {
+        m_clock = m_currentTime;
+    }
+
+    return m_clock;
+}
+
+const DoublePendulumState& TimeWarpBuffer::state(int i) const
+{
+    return m_current[i];
+}
+
+void TimeWarpBuffer::produce()
+{
+    double t = 0.0;
+
+    for (bool first = true;; first = false)
+    {
+        double warp;
+
+        {
+            QMutexLocker locker(&m_mutex);
+
+            while (m_count == LOOKAHEAD && !m_quit)
+            {
+                m_notFull.wait(&m_mutex);
+            }
+
+            if (m_quit)
+            {
+                return;
+            }
+
+            warp = m_warp;
+        }
+
+        Frame& frame = m_frames[m_head];
+        frame.calls.clear();
+
+        // The first frame is of the initial states
+        if (!first)
+        {
+            t += warp * m_tick;
+
+            m_stepper.advance(t);
+        }
+
+        frame.time = t;
+        frame.warp = warp;
+
+        for (int i = 0; i < m_pendula.size(); ++i)
+        {
+            snapshot(m_pendula[i], frame.states[i]);
+        }
+
+        m_head = (m_head + 1) % LOOKAHEAD;
+
+        QMutexLocker locker(&m_mutex);
+        ++m_count;
+    }
+}
+
+void TimeWarpBuffer::record(const Call& call)
+{
+    // Only ever called on the producer thread, for the frame being made
+    m_frames[m_head].calls.append(call);
+}
+
+bool TimeWarpBuffer::replay(const Frame& frame, int& budget)
+{
+    const int end = qMin(frame.calls.size(), m_replayed + budget);
+
+    for (int i = m_replayed; i < end; ++i)
+    {
+        const Call& call = frame.calls[i];
+
+        if (call.crossing)
+        {
+            m_listenerRelays[call.relay]->m_listener->sectionCrossed(
+                call.t, call.y[0], call.y[1], call.y[2]);
+        }
+        else
+        {
+            m_observerRelays[call.relay]->m_observer->sample(*call.pendulum,
+                                                             call.t, call.y);
+        }
+    }
+
+    budget -= end - m_replayed;
+
+    if (end < frame.calls.size())
+    {
+        m_replayed = end;
+        return false;
+    }
+
+    m_replayed = 0;
+    return true;
+}
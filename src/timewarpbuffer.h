@@ -0,0 +1,199 @@
+/*
+    This file is part of Double Pendulum.
+    Copyright (C) 2009–2010  Freddie Witherden
+
+    Double Pendulum is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Double Pendulum is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Double Pendulum; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TIMEWARPBUFFER_H
+#define TIMEWARPBUFFER_H
+
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "doublependulum.h"
+#include "multiratestepper.h"
+
+/**
+ * Integrates a set of pendula on a background thread, ahead of the display,
+ * into a bounded ring of frames.
+ *
+ * Frames are tick seconds of wall time apart and so, at a time warp of w,
+ * w·tick seconds of simulated time apart.  Each frame records the warp it
+ * was made at and advance() moves the clock on at that rate, so a change
+ * of warp reaches the display once the frames already made are used up.
+ * Should the integration fall behind the clock waits for it, slowing the
+ * display rather than stalling the GUI.
+ *
+ * Observers and listeners attached to the pendula through relay() have
+ * their calls recorded with the frames and made on the thread that calls
+ * advance(), in step with the display; thread safe observers are left to
+ * be called directly.  At most MAX_REPLAY calls are made per advance(), so
+ * that a high warp can not stall the GUI; beyond that the clock lags until
+ * the calls are caught up with.
+ *
+ * The pendula are advanced through a MultiRateStepper, so that those using
+ * RK4 are stepped in batches, each dt class at its own rate.
+ */
+class TimeWarpBuffer
+{
+public:
+    enum
+    {
+        /**
+         * Number of frames the integration may run ahead of the display.
+         */
+        LOOKAHEAD = 16,
+
+        /**
+         * Most recorded calls replayed by a single advance().
+         */
+        MAX_REPLAY = 16384
+    };
+
+    TimeWarpBuffer();
+    ~TimeWarpBuffer();
+
+    /**
+     * Adds a pendulum, returning its index into the frames.  The buffer must
+     * be stopped.
+     */
+    int addPendulum(DoublePendulum *pendulum);
+
+    /**
+     * Returns an observer or listener to attach in place of the given one,
+     * owned by the buffer.
+     */
+    DoublePendulumObserver *relay(DoublePendulumObserver *observer);
+    PoincareListener *relay(PoincareListener *listener);
+
+    double timeWarp() const;
+    void setTimeWarp(double warp);
+
+    /**
+     * Starts integrating, with frames tick seconds of wall time apart.
+     */
+    void start(double tick);
+
+    /**
+     * Stops integrating and forgets the pendula and relays.
+     */
+    void stop();
+
+    /**
+     * Moves the clock on by elapsed seconds of wall time, replaying the
+     * recorded calls of the frames passed over, up to MAX_REPLAY of them.
+     * Returns the clock, which is the simulated time in seconds.
+     */
+    double advance(double elapsed);
+
+    /**
+     * State of the i-th pendulum at the latest frame passed over.
+     */
+    const DoublePendulumState& state(int i) const;
+
+private:
+    // Owns its thread and relays and so can not be copied
+    TimeWarpBuffer(const TimeWarpBuffer&);
+    TimeWarpBuffer& operator=(const TimeWarpBuffer&);
+
+    class Producer;
+    class ObserverRelay;
+    class ListenerRelay;
+    friend class Producer;
+    friend class ObserverRelay;
+    friend class ListenerRelay;
+
+    /**
+     * A recorded call; to observer relay if crossing is false and otherwise
+     * to listener relay, with y then holding ω1, θ2, ω2.  Only the
+     * parameters of the pendulum are looked at when a sample is replayed.
+     */
+    struct Call
+    {
+        int relay;
+        bool crossing;
+        const DoublePendulum *pendulum;
+        double t;
+        double y[4];
+    };
+
+    struct Frame
+    {
+        double time;
+        double warp;
+        QVector<DoublePendulumState> states;
+        QVector<Call> calls;
+    };
+
+    /**
+     * Stops the producer thread, if it is running.
+     */
+    void halt();
+
+    /**
+     * Body of the producer thread.
+     */
+    void produce();
+
+    void record(const Call& call);
+
+    /**
+     * Replays up to budget of the calls of frame not yet replayed, taking
+     * off those made; returns whether all of them have been.
+     */
+    bool replay(const Frame& frame, int& budget);
+
+    QVector<DoublePendulum *> m_pendula;
+    MultiRateStepper m_stepper;
+
+    QVector<ObserverRelay *> m_observerRelays;
+    QVector<ListenerRelay *> m_listenerRelays;
+
+    Producer *m_producer;
+    double m_tick;
+    double m_warp;
+
+    /**
+     * The ring of frames.  Frames [m_tail, m_tail + m_count) are complete
+     * and belong to the consumer; the rest belong to the producer, which
+     * fills them in from m_head.
+     */
+    QVector<Frame> m_frames;
+    int m_head;
+    int m_tail;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_notFull;
+    int m_count;
+    bool m_quit;
+
+    /**
+     * Clock and the states of the latest frame passed over, consumer side.
+     */
+    double m_clock;
+    double m_clockWarp;
+    double m_currentTime;
+    QVector<DoublePendulumState> m_current;
+    bool m_hasCurrent;
+
+    /**
+     * Calls of the frame at m_tail already replayed.
+     */
+    int m_replayed;
+};
+
+#endif // TIMEWARPBUFFER_H